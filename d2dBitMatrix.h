@@ -0,0 +1,208 @@
+#ifndef D2DBITMATRIX_H
+#define D2DBITMATRIX_H
+
+#include <vector>
+#include <stdint.h>
+
+inline uint32_t d2dPopcount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (x * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+// index of the lowest set bit, x != 0
+inline uint32_t d2dLowestBit(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	uint32_t i = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+// Dense 0/1 matrix with one packed bitset per row, used for P, I and W (device x content / channel).
+// m[r][i] reads and writes single entries like an int matrix (nonzero values are stored as 1). The
+// row operations work on whole 64 bit words, e.g. the common channels of two devices W[a] & W[b] or
+// the content a device is interested in and does not hold I[d] & ~P[d]. Bits beyond the last column
+// are always 0.
+// The row operations are plain word loops with d2dPopcount (one POPCNT per word with -mpopcnt or
+// -march=native) and are not vectorized explicitly: rows hold one word per 64 channels or content, so
+// a row of W is a single word and rows of P and I a few words, shorter than a SIMD block. The cost is
+// in the loops over devices that call them.
+class d2dBitMatrix {
+
+	public:
+		class reference {
+			public:
+				reference(uint64_t *word, uint64_t mask) : word(word), mask(mask) {}
+
+				operator int() const {
+					return (*word & mask) != 0 ? 1 : 0;
+				}
+
+				reference& operator=(int value) {
+					if (value != 0) {
+						*word |= mask;
+					} else {
+						*word &= ~mask;
+					}
+					return *this;
+				}
+
+				reference& operator=(const reference &other) {
+					return *this = (int)other;
+				}
+
+			private:
+				uint64_t *word;
+				uint64_t mask;
+		};
+
+		class row {
+			public:
+				row(uint64_t *words) : words(words) {}
+
+				reference operator[](uint32_t i) const {
+					return reference(words + (i >> 6), 1ULL << (i & 63));
+				}
+
+			private:
+				uint64_t *words;
+		};
+
+		class const_row {
+			public:
+				const_row(const uint64_t *words) : words(words) {}
+
+				int operator[](uint32_t i) const {
+					return (words[i >> 6] >> (i & 63)) & 1;
+				}
+
+			private:
+				const uint64_t *words;
+		};
+
+		d2dBitMatrix() {
+			numRows 	= 0;
+			numCols 	= 0;
+			numWords 	= 0;
+		}
+
+		// rows x cols, all 0
+		void resize(uint32_t rows, uint32_t cols) {
+			numRows 	= rows;
+			numCols 	= cols;
+			numWords 	= (cols + 63) / 64;
+			bits.assign((uint64_t)rows * numWords, 0);
+		}
+
+		void clear() {
+			resize(0, 0);
+		}
+
+		bool empty() const {
+			return numRows == 0;
+		}
+
+		uint32_t rows() const {
+			return numRows;
+		}
+
+		uint32_t cols() const {
+			return numCols;
+		}
+
+		// 64 bit words per row
+		uint32_t wordsPerRow() const {
+			return numWords;
+		}
+
+		row operator[](uint32_t r) {
+			return row(words(r));
+		}
+
+		const_row operator[](uint32_t r) const {
+			return const_row(words(r));
+		}
+
+		uint64_t* words(uint32_t r) {
+			return &bits[(uint64_t)r * numWords];
+		}
+
+		const uint64_t* words(uint32_t r) const {
+			return &bits[(uint64_t)r * numWords];
+		}
+
+		// number of 1 entries of row r
+		uint32_t count(uint32_t r) const {
+			const uint64_t *a = words(r);
+			uint32_t result = 0;
+			for (uint32_t w = 0; w<numWords; w++) {
+				result += d2dPopcount(a[w]);
+			}
+			return result;
+		}
+
+		// |this[r] & other[s]|, both matrices with the same number of columns
+		uint32_t countAnd(uint32_t r, const d2dBitMatrix &other, uint32_t s) const {
+			const uint64_t *a = words(r);
+			const uint64_t *b = other.words(s);
+			uint32_t result = 0;
+			for (uint32_t w = 0; w<numWords; w++) {
+				result += d2dPopcount(a[w] & b[w]);
+			}
+			return result;
+		}
+
+		// |this[r] & ~other[s]|
+		uint32_t countAndNot(uint32_t r, const d2dBitMatrix &other, uint32_t s) const {
+			const uint64_t *a = words(r);
+			const uint64_t *b = other.words(s);
+			uint32_t result = 0;
+			for (uint32_t w = 0; w<numWords; w++) {
+				result += d2dPopcount(a[w] & ~b[w]);
+			}
+			return result;
+		}
+
+		// this[r] & other[s] != 0
+		bool intersects(uint32_t r, const d2dBitMatrix &other, uint32_t s) const {
+			const uint64_t *a = words(r);
+			const uint64_t *b = other.words(s);
+			uint64_t any = 0;
+			for (uint32_t w = 0; w<numWords; w++) {
+				any |= a[w] & b[w];
+			}
+			return any != 0;
+		}
+
+		// appends the columns of this[r] & ~other[s] in increasing order, other = NULL for this[r]
+		void columns(uint32_t r, const d2dBitMatrix *other, uint32_t s, std::vector<uint32_t> &result) const {
+			const uint64_t *a = words(r);
+			const uint64_t *b = other != NULL ? other->words(s) : NULL;
+			for (uint32_t w = 0; w<numWords; w++) {
+				uint64_t word = b != NULL ? a[w] & ~b[w] : a[w];
+				while (word != 0) {
+					result.push_back(w * 64 + d2dLowestBit(word));
+					word &= word - 1;
+				}
+			}
+		}
+
+	private:
+		uint32_t numRows;
+		uint32_t numCols;
+		uint32_t numWords;
+		std::vector<uint64_t> bits;
+};
+
+#endif
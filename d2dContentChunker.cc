@@ -0,0 +1,90 @@
+#include "d2dContentChunker.h"
+
+d2dContentChunker::d2dContentChunker(long chunkSize) {
+	this->chunkSize = std::max<long>(chunkSize, 1);
+}
+
+void d2dContentChunker::split(d2dOptimizer *src, d2dOptimizer *dst) {
+	uint32_t numDev 	= src->deviceVector.size();
+	uint32_t numChan 	= src->channelVector.size();
+	uint32_t numCont 	= src->contentVector.size();
+
+	firstChunk.assign(numCont + 1, 0);
+	chunkContent.clear();
+	for (uint32_t n = 0; n<numCont; n++) {
+		firstChunk[n] = chunkContent.size();
+		//content of size 0 keeps one chunk
+		long chunks = std::max<long>((src->S[n] + chunkSize - 1) / chunkSize, 1);
+		for (long k = 0; k<chunks; k++) {
+			chunkContent.push_back(n);
+		}
+	}
+	firstChunk[numCont] = chunkContent.size();
+	uint32_t numChunks = chunkContent.size();
+
+	for (uint32_t c = 0; c<numChan; c++) {
+		dst->addChannel(src->channelVector[c]->id);
+	}
+	for (uint32_t k = 0; k<numChunks; k++) {
+		uint32_t n = chunkContent[k];
+		long size = std::min<long>(chunkSize, src->S[n] - (long)(k - firstChunk[n]) * chunkSize);
+		dst->addContent(k, std::max<long>(size, 0));
+	}
+	for (uint32_t d = 0; d<numDev; d++) {
+		device *dev = dst->addDevice(src->deviceVector[d]->id);
+		dev->hasPosition 	= src->deviceVector[d]->hasPosition;
+		dev->x 				= src->deviceVector[d]->x;
+		dev->y 				= src->deviceVector[d]->y;
+		dev->capacity 		= src->deviceVector[d]->capacity;
+	}
+	dst->settings 	= src->settings;
+	dst->radio 		= src->radio;
+	dst->allocateParameters();
+
+	for (uint32_t k = 0; k<numChunks; k++) {
+		dst->S[k] = dst->contentVector[k]->size;
+	}
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (uint32_t k = 0; k<numChunks; k++) {
+			dst->P[d][k] = src->P[d][chunkContent[k]];
+			dst->I[d][k] = src->I[d][chunkContent[k]];
+			dst->D[d][k] = src->D[d][chunkContent[k]];
+		}
+		for (uint32_t c = 0; c<numChan; c++) {
+			dst->W[d][c] 		= src->W[d][c];
+			dst->START_AP[d][c] = src->START_AP[d][c];
+		}
+		for (uint32_t d_ap = 0; d_ap<numDev; d_ap++) {
+			dst->START_Client[d][d_ap] = src->START_Client[d][d_ap];
+		}
+		dst->START_Idle[d] = src->START_Idle[d];
+
+		for (uint32_t d_cns = 0; d_cns<numDev; d_cns++) {
+			for (uint32_t c = 0; c<numChan; c++) {
+				dst->L[d][d_cns][c] = src->L[d][d_cns][c];
+			}
+			for (uint32_t k = 0; k<numChunks; k++) {
+				uint32_t n = chunkContent[k];
+				dst->U[d][d_cns][k] = src->S[n] > 0 ? src->U[d][d_cns][n] * dst->S[k] / src->S[n] : src->U[d][d_cns][n];
+			}
+		}
+		for (uint32_t c = 0; c<numChan; c++) {
+			for (uint32_t d_int = 0; d_int<numDev; d_int++) {
+				for (uint32_t c_int = 0; c_int<numChan; c_int++) {
+					dst->X[d][c][d_int][c_int] = src->X[d][c][d_int][c_int];
+				}
+			}
+		}
+	}
+	src->updateInterferenceList();
+	dst->interferenceList = src->interferenceList;
+}
+
+bool d2dContentChunker::complete(d2dOptimizer *opt, uint32_t d, uint32_t n) const {
+	for (uint32_t k = firstChunk[n]; k<firstChunk[n + 1]; k++) {
+		if (opt->P[d][k] == 0) {
+			return false;
+		}
+	}
+	return true;
+}
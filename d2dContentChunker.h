@@ -0,0 +1,36 @@
+#ifndef D2DCONTENTCHUNKER_H
+#define D2DCONTENTCHUNKER_H
+
+#include "d2dOptimizer.h"
+
+// Splits each content of an instance into chunks of at most chunkSize units, which are scheduled
+// as separate content. Content larger than a superslot can be delivered, the chunks of one content
+// can come from different providers, and with d2dSimulator the chunks received in one superslot
+// are held in the next one, so a transfer resumes where it stopped. A device holding a content
+// holds all of its chunks, a device interested in it is interested in all chunks. The utility of a
+// content is divided among its chunks in proportion to their size.
+class d2dContentChunker {
+
+	public:
+		long chunkSize;
+
+		// chunks of content n of the source instance are the content indices [firstChunk[n], firstChunk[n+1])
+		std::vector<uint32_t> firstChunk;
+		// content of the source instance per chunk
+		std::vector<uint32_t> chunkContent;
+
+		d2dContentChunker(long chunkSize);
+
+		// adds the channels and devices of src and one content per chunk (id = chunk index) to the
+		// empty optimizer dst, copies the settings and all parameters of src. The solver
+		// configuration of dst is not changed.
+		void split(d2dOptimizer *src, d2dOptimizer *dst);
+
+		// device d holds all chunks of content n of the source instance in the chunked instance opt
+		bool complete(d2dOptimizer *opt, uint32_t d, uint32_t n) const;
+		uint32_t numChunks(uint32_t n) const {
+			return firstChunk[n + 1] - firstChunk[n];
+		}
+};
+
+#endif
@@ -0,0 +1,328 @@
+#include "d2dGurobiBackend.h"
+
+#ifndef D2D_NO_GUROBI
+
+static std::runtime_error gurobiError(GRBException &e) {
+	std::stringstream sstm;
+	sstm << "Gurobi error code = " << e.getErrorCode() << " " << e.getMessage();
+	return std::runtime_error(sstm.str());
+}
+
+d2dGurobiCallback::d2dGurobiCallback(d2dGurobiBackend *backend) {
+	this->backend = backend;
+}
+
+void d2dGurobiCallback::callback() {
+	try {
+		int numVars = backend->vars.size();
+		if (numVars == 0) {
+			return;
+		}
+		if (where == GRB_CB_MIPSOL && found) {
+			double *x = getSolution(&backend->vars[0], numVars);
+			values.assign(x, x + numVars);
+			delete [] x;
+			found(values, getDoubleInfo(GRB_CB_MIPSOL_OBJ));
+		} else if (where == GRB_CB_MIPNODE && poll && getIntInfo(GRB_CB_MIPNODE_STATUS) == GRB_OPTIMAL && poll(values)) {
+			setSolution(&backend->vars[0], &values[0], numVars);
+		}
+	} catch (GRBException e) {
+		cerr << "Error in Gurobi callback: " << e.getMessage() << endl;
+	}
+}
+
+d2dGurobiBackend::d2dGurobiBackend() {
+	callback = NULL;
+	try {
+		env = new GRBEnv();
+		model = new GRBModel(*env);	
+	} catch(GRBException e) {
+		cout << "Error code = " << e.getErrorCode() << endl;
+		cout << e.getMessage() << endl;
+		exit(-1);
+	} catch (...) {
+		cout << "Error in constructor" << endl;
+		exit(-1);
+	}
+}
+
+d2dGurobiBackend::~d2dGurobiBackend() {
+	delete model;
+	delete callback;
+	delete env;
+}
+
+std::string d2dGurobiBackend::name() {
+	return "gurobi";
+}
+
+void d2dGurobiBackend::clear() {
+	try {
+		delete model;
+		model = new GRBModel(*env);
+		vars.clear();
+		relaxedTypes.clear();
+		if (callback != NULL) {
+			model->setCallback(callback);
+		}
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+d2dVar d2dGurobiBackend::addVars(uint64_t count, double lb, double ub, char type, const std::vector<std::string> *names) {
+	d2dVar first = vars.size();
+	if (count == 0) {
+		return first;
+	}
+	try {
+		std::vector<double> lbs(count, lb);
+		std::vector<double> ubs(count, ub);
+		std::vector<char> types(count, relaxedTypes.empty() ? type : GRB_CONTINUOUS);
+		if (!relaxedTypes.empty()) {
+			relaxedTypes.resize(first + count, type);
+		}
+		GRBVar *newVars = model->addVars(&lbs[0], &ubs[0], NULL, &types[0], names != NULL ? &(*names)[0] : NULL, count);
+		vars.insert(vars.end(), newVars, newVars + count);
+		delete [] newVars;
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+	return first;
+}
+
+void d2dGurobiBackend::addConstrs(const d2dConstraintBuffer &buf) {
+	size_t rows = buf.numRows();
+	if (rows == 0) {
+		return;
+	}
+	try {
+		std::vector<GRBVar> termVars(buf.numTerms());
+		for (size_t k = 0; k<buf.numTerms(); k++) {
+			termVars[k] = vars[buf.vars[k]];
+		}
+		
+		GRBLinExpr *exprs = new GRBLinExpr[rows];
+		for (size_t i = 0; i<rows; i++) {
+			exprs[i].addTerms(&buf.coeffs[buf.rowBegin[i]], &termVars[buf.rowBegin[i]], buf.rowBegin[i+1] - buf.rowBegin[i]);
+		}
+		
+		GRBConstr *constrs = model->addConstrs(exprs, &buf.senses[0], &buf.rhs[0], buf.useNames ? &buf.names[0] : NULL, rows);
+		
+		delete [] constrs;
+		delete [] exprs;
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+void d2dGurobiBackend::setObjective(const std::vector<d2dVar> &objVars, const std::vector<double> &coeffs, int32_t sense) {
+	try {
+		std::vector<GRBVar> termVars(objVars.size());
+		for (size_t k = 0; k<objVars.size(); k++) {
+			termVars[k] = vars[objVars[k]];
+		}
+		GRBLinExpr objExpr = 0;
+		if (termVars.size() > 0) {
+			objExpr.addTerms(&coeffs[0], &termVars[0], termVars.size());
+		}
+		model->setObjective(objExpr, sense == D2D_MAXIMIZE ? GRB_MAXIMIZE : GRB_MINIMIZE);
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+uint64_t d2dGurobiBackend::numVars() {
+	return vars.size();
+}
+
+uint64_t d2dGurobiBackend::numConstrs() {
+	try {
+		model->update();
+		return model->get(GRB_IntAttr_NumConstrs);
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+void d2dGurobiBackend::setBounds(const std::vector<double> &lb, const std::vector<double> &ub) {
+	if (vars.size() == 0) {
+		return;
+	}
+	try {
+		model->update();
+		model->set(GRB_DoubleAttr_LB, &vars[0], &lb[0], std::min(vars.size(), lb.size()));
+		model->set(GRB_DoubleAttr_UB, &vars[0], &ub[0], std::min(vars.size(), ub.size()));
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+void d2dGurobiBackend::setParam(const std::string &param, const std::string &value) {
+	try {
+		model->set(param, value);
+	} catch (GRBException e) {
+		cerr << "Cannot set Gurobi parameter " << param << " = " << value << ": " << e.getMessage() << endl;
+	}
+}
+
+int32_t d2dGurobiBackend::optimize() {
+	try {
+		model->update();
+		model->optimize();
+		
+		int32_t status = model->get(GRB_IntAttr_Status);
+		switch (status) {
+			case GRB_OPTIMAL:
+				return D2D_STATUS_OPTIMAL;
+			case GRB_INFEASIBLE:
+			case GRB_INF_OR_UNBD:
+				return D2D_STATUS_INFEASIBLE;
+			case GRB_TIME_LIMIT:
+			case GRB_NODE_LIMIT:
+			case GRB_SOLUTION_LIMIT:
+			case GRB_INTERRUPTED:
+			case GRB_SUBOPTIMAL:
+			case GRB_USER_OBJ_LIMIT:
+				return hasSolution() ? D2D_STATUS_FEASIBLE : D2D_STATUS_NO_SOLUTION;
+			default:
+				cout << "Unknown gurobi state " << status << endl;
+				return D2D_STATUS_UNKNOWN;
+		}
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+bool d2dGurobiBackend::hasSolution() {
+	try {
+		return model->get(GRB_IntAttr_SolCount) > 0;
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+double d2dGurobiBackend::getObjValue() {
+	try {
+		return model->get(GRB_DoubleAttr_ObjVal);
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+void d2dGurobiBackend::getValues(std::vector<double> &values) {
+	values.assign(vars.size(), 0.0);
+	if (vars.size() == 0) {
+		return;
+	}
+	try {
+		double *x = model->get(GRB_DoubleAttr_X, &vars[0], vars.size());
+		std::copy(x, x + vars.size(), values.begin());
+		delete [] x;
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+bool d2dGurobiBackend::setRelaxed(bool relaxed) {
+	if (vars.size() == 0 || relaxed == !relaxedTypes.empty()) {
+		return true;
+	}
+	try {
+		model->update();
+		if (relaxed) {
+			char *types = model->get(GRB_CharAttr_VType, &vars[0], vars.size());
+			relaxedTypes.assign(types, types + vars.size());
+			delete [] types;
+			std::vector<char> continuous(vars.size(), GRB_CONTINUOUS);
+			model->set(GRB_CharAttr_VType, &vars[0], &continuous[0], vars.size());
+		} else {
+			model->set(GRB_CharAttr_VType, &vars[0], &relaxedTypes[0], vars.size());
+			relaxedTypes.clear();
+		}
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+	return true;
+}
+
+void d2dGurobiBackend::setStart(const std::vector<double> &values) {
+	if (vars.size() == 0) {
+		return;
+	}
+	try {
+		model->update();
+		model->set(GRB_DoubleAttr_Start, &vars[0], &values[0], std::min(vars.size(), values.size()));
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+d2dSolverBackend* d2dGurobiBackend::clone() {
+	try {
+		model->update();
+		d2dGurobiBackend *copy = new d2dGurobiBackend();
+		delete copy->model;
+		//the copy gets its own environment, environments must not be shared between threads
+		copy->model = new GRBModel(*model, *copy->env);
+		if (vars.size() > 0) {
+			GRBVar *copyVars = copy->model->getVars();
+			copy->vars.assign(copyVars, copyVars + vars.size());
+			delete [] copyVars;
+		}
+		copy->relaxedTypes = relaxedTypes;
+		return copy;
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+void d2dGurobiBackend::interrupt() {
+	model->terminate();
+}
+
+void d2dGurobiBackend::setIncumbentCallbacks(const d2dIncumbentFound &found, const d2dIncumbentPoll &poll) {
+	try {
+		if (!found && !poll) {
+			model->setCallback(NULL);
+			delete callback;
+			callback = NULL;
+			return;
+		}
+		if (callback == NULL) {
+			callback = new d2dGurobiCallback(this);
+		}
+		callback->found = found;
+		callback->poll 	= poll;
+		model->setCallback(callback);
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+bool d2dGurobiBackend::computeIIS(std::vector<std::string> &constrNames) {
+	try {
+		model->computeIIS();
+		GRBConstr* c = model->getConstrs();
+		for (int64_t i = 0; i < model->get(GRB_IntAttr_NumConstrs); ++i) {
+			if (c[i].get(GRB_IntAttr_IISConstr) == 1) {
+				constrNames.push_back(c[i].get(GRB_StringAttr_ConstrName));
+			}
+		}
+		delete [] c;
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+	return true;
+}
+
+void d2dGurobiBackend::write(const std::string &fname) {
+	try {
+		model->update();
+		model->write(fname);
+	} catch (GRBException e) {
+		throw gurobiError(e);
+	}
+}
+
+#endif
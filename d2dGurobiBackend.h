@@ -0,0 +1,71 @@
+#ifndef D2DGUROBIBACKEND_H
+#define D2DGUROBIBACKEND_H
+
+#ifndef D2D_NO_GUROBI
+
+#include "d2dSolverBackend.h"
+#include "gurobi_c++.h"
+
+class d2dGurobiBackend;
+
+// forwards new incumbents of a running optimize() and injects external solutions at MIP nodes
+class d2dGurobiCallback : public GRBCallback {
+
+	public:
+		d2dGurobiBackend *backend;
+		d2dIncumbentFound found;
+		d2dIncumbentPoll poll;
+
+		d2dGurobiCallback(d2dGurobiBackend *backend);
+
+	protected:
+		void callback();
+
+	private:
+		std::vector<double> values;
+};
+
+// Backend solving the model with Gurobi. GRBExceptions are rethrown as std::runtime_error.
+class d2dGurobiBackend : public d2dSolverBackend {
+
+	public:
+		GRBEnv *env;
+		GRBModel *model;
+
+		// GRBVar handle of every d2dVar
+		std::vector<GRBVar> vars;
+
+		// set by setIncumbentCallbacks(), owned
+		d2dGurobiCallback *callback;
+
+		// types of the variables while relaxed, empty if not relaxed
+		std::vector<char> relaxedTypes;
+
+		d2dGurobiBackend();
+		~d2dGurobiBackend();
+
+		std::string name();
+		void clear();
+		d2dVar addVars(uint64_t count, double lb, double ub, char type, const std::vector<std::string> *names);
+		void addConstrs(const d2dConstraintBuffer &buf);
+		void setObjective(const std::vector<d2dVar> &vars, const std::vector<double> &coeffs, int32_t sense);
+		uint64_t numVars();
+		uint64_t numConstrs();
+		void setBounds(const std::vector<double> &lb, const std::vector<double> &ub);
+		void setParam(const std::string &param, const std::string &value);
+		int32_t optimize();
+		bool hasSolution();
+		double getObjValue();
+		void getValues(std::vector<double> &values);
+		bool setRelaxed(bool relaxed);
+		void setStart(const std::vector<double> &values);
+		d2dSolverBackend* clone();
+		void interrupt();
+		void setIncumbentCallbacks(const d2dIncumbentFound &found, const d2dIncumbentPoll &poll);
+		bool computeIIS(std::vector<std::string> &constrNames);
+		void write(const std::string &fname);
+};
+
+#endif
+
+#endif
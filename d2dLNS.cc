@@ -0,0 +1,237 @@
+#include "d2dLNS.h"
+
+d2dLNS::d2dLNS(d2dOptimizer *opt) {
+	this->opt 		= opt;
+	backend 		= opt->backend;
+	stop 			= NULL;
+	subTimeLimit 	= 5.0;
+	clusterSize 	= 8;
+	windowLength 	= 0;
+	seed 			= 0;
+}
+
+void d2dLNS::selectCluster(uint32_t size) {
+	freeDevice.assign(numDev, 0);
+	windowBegin = 0;
+	windowEnd 	= numT;
+
+	//breadth first search over devices with a link in either direction
+	std::deque<uint32_t> queue;
+	uint32_t start = rng() % numDev;
+	freeDevice[start] = 1;
+	queue.push_back(start);
+	uint32_t count = 1;
+	while (!queue.empty() && count < size) {
+		uint32_t a = queue.front();
+		queue.pop_front();
+		for (uint32_t b = 0; b<numDev && count < size; b++) {
+			if (freeDevice[b]) {
+				continue;
+			}
+			for (uint32_t c = 0; c<numChan; c++) {
+				if (opt->L[a][b][c] > 0 || opt->L[b][a][c] > 0) {
+					freeDevice[b] = 1;
+					queue.push_back(b);
+					count++;
+					break;
+				}
+			}
+		}
+	}
+}
+
+void d2dLNS::selectChannel(const d2dSchedule &schedule, uint32_t size) {
+	freeDevice.assign(numDev, 0);
+	windowBegin = 0;
+	windowEnd 	= numT;
+
+	uint32_t c = rng() % numChan;
+	uint32_t count = 0;
+
+	//APs on channel c and their clients
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (int64_t t = 0; t<numT; t++) {
+			uint8_t role = schedule.getRole(d, t);
+			uint32_t arg = schedule.getRoleArg(d, t);
+			bool apRole = role == D2D_ROLE_STARTAP || role == D2D_ROLE_SWITCHAP || role == D2D_ROLE_AP;
+			if ((apRole && arg == c) || (role == D2D_ROLE_CLIENT && schedule.getRole(arg, t) == D2D_ROLE_AP && schedule.getRoleArg(arg, t) == c)) {
+				freeDevice[d] = 1;
+				count++;
+				break;
+			}
+		}
+	}
+
+	//random devices supporting channel c
+	std::vector<uint32_t> supporters;
+	for (uint32_t d = 0; d<numDev; d++) {
+		if (!freeDevice[d] && opt->W[d][c] == 1) {
+			supporters.push_back(d);
+		}
+	}
+	for (uint32_t i = 0; i<supporters.size() && count < size; i++) {
+		std::swap(supporters[i], supporters[i + rng() % (supporters.size() - i)]);
+		freeDevice[supporters[i]] = 1;
+		count++;
+	}
+}
+
+void d2dLNS::selectWindow(int64_t length) {
+	freeDevice.assign(numDev, 1);
+	windowBegin = rng() % (numT - length + 1);
+	windowEnd 	= windowBegin + length;
+}
+
+void d2dLNS::fixOutside(const std::vector<double> &incumbent) {
+	lb = opt->varLb;
+	ub = opt->varUb;
+
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (int64_t t = 0; t<numT; t++) {
+			if (isFree(d, t)) {
+				continue;
+			}
+			fix(opt->S_Idle(d, t), incumbent);
+			for (uint32_t c = 0; c<numChan; c++) {
+				fix(opt->S_StartAP(d, c, t), incumbent);
+				fix(opt->S_SwitchAP(d, c, t), incumbent);
+				fix(opt->S_AP(d, c, t), incumbent);
+			}
+			for (uint32_t d_ap = 0; d_ap<numDev; d_ap++) {
+				fix(opt->S_StartClient(d, d_ap, t), incumbent);
+				fix(opt->S_JoinAP(d, d_ap, t), incumbent);
+				fix(opt->S_Client(d, d_ap, t), incumbent);
+			}
+		}
+	}
+
+	//an exchange is free if one of the two devices is free in its start slot, h, s, r and p follow from the constraints
+	for (uint32_t d_prv = 0; d_prv<numDev; d_prv++) {
+		for (uint32_t d_cns = 0; d_cns<numDev; d_cns++) {
+			for (uint32_t n = 0; n<numCont; n++) {
+				for (uint32_t c = 0; c<numChan; c++) {
+					for (int64_t t = 0; t<numT; t++) {
+						if (!isFree(d_prv, t) && !isFree(d_cns, t)) {
+							fix(opt->y(d_prv, d_cns, n, c, t), incumbent);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+int32_t d2dLNS::run(d2dSchedule &schedule) {
+	numDev 	= opt->deviceVector.size();
+	numChan = opt->channelVector.size();
+	numCont = opt->contentVector.size();
+	numT 	= opt->settings.numTimeSlots;
+	rng.seed(seed);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	std::vector<double> incumbent;
+	opt->scheduleToValues(schedule, incumbent);
+	opt->solution = incumbent;
+
+	if (numDev == 0 || numChan == 0 || numT == 0) {
+		return D2D_STATUS_OPTIMAL;
+	}
+
+	uint32_t size 	= std::max(std::min(clusterSize, numDev), (uint32_t)1);
+	int64_t length 	= windowLength > 0 ? std::min(windowLength, numT) : std::max(numT / 4, (int64_t)1);
+
+	cout << "LNS start utility " << schedule.utility << endl;
+
+	int32_t status = D2D_STATUS_FEASIBLE;
+	d2dSchedule candidate;
+	uint32_t iteration = 0;
+	//neighborhoods in a row that were solved to optimality without improvement
+	uint32_t exhausted = 0;
+	std::vector<double> values;
+	while (true) {
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		double remaining = opt->timeLimit - elapsed;
+		if ((opt->timeLimit > 0.0 && remaining <= 0.0) || (stop != NULL && *stop)) {
+			break;
+		}
+		//continue from a better schedule found by another search
+		if (poll && poll(candidate) && candidate.utility > schedule.utility + 1e-6) {
+			schedule = candidate;
+			opt->scheduleToValues(schedule, incumbent);
+			exhausted = 0;
+		}
+
+		int32_t type = iteration % D2D_LNS_NUM_NEIGHBORHOODS;
+		iteration++;
+		switch (type) {
+			case D2D_LNS_CLUSTER:
+				selectCluster(size);
+				break;
+			case D2D_LNS_CHANNEL:
+				selectChannel(schedule, size);
+				break;
+			case D2D_LNS_WINDOW:
+				selectWindow(length);
+				break;
+		}
+		bool whole = windowBegin == 0 && windowEnd == numT && 
+				std::count(freeDevice.begin(), freeDevice.end(), 1) == (int64_t)numDev;
+
+		fixOutside(incumbent);
+		backend->setBounds(lb, ub);
+		backend->setStart(incumbent);
+
+		double limit = subTimeLimit;
+		if (opt->timeLimit > 0.0) {
+			limit = std::min(limit, remaining);
+		}
+		std::stringstream sstm;
+		sstm << limit;
+		backend->setParam("TimeLimit", sstm.str());
+
+		int32_t subStatus = backend->optimize();
+		if (subStatus == D2D_STATUS_EXPORTED) {
+			cout << "LNS requires a solver backend, only the first neighborhood has been exported" << endl;
+			status = subStatus;
+			break;
+		}
+		if (subStatus == D2D_STATUS_ERROR || subStatus == D2D_STATUS_INFEASIBLE) {
+			cout << "LNS sub-MIP failed with status " << subStatus << endl;
+			break;
+		}
+
+		bool improved = false;
+		if (backend->hasSolution()) {
+			backend->getValues(values);
+			opt->getSchedule(values, candidate);
+			if (candidate.utility > schedule.utility + 1e-6) {
+				schedule = candidate;
+				incumbent = values;
+				improved = true;
+				if (found) {
+					found(schedule);
+				}
+				cout << "LNS iteration " << iteration << " neighborhood " << type << " utility " << schedule.utility << endl;
+			}
+		}
+
+		if (whole && subStatus == D2D_STATUS_OPTIMAL) {
+			status = D2D_STATUS_OPTIMAL;
+			break;
+		} else if (improved || subStatus != D2D_STATUS_OPTIMAL) {
+			exhausted = 0;
+		} else if (++exhausted >= D2D_LNS_NUM_NEIGHBORHOODS) {
+			size 	= std::min(2 * size, numDev);
+			length 	= std::min(2 * length, numT);
+			exhausted = 0;
+		}
+	}
+
+	//restore the original bounds of the model
+	backend->setBounds(opt->varLb, opt->varUb);
+	opt->solution = incumbent;
+
+	cout << "LNS utility " << schedule.utility << " after " << iteration << " iterations" << endl;
+	return status;
+}
@@ -0,0 +1,87 @@
+#ifndef D2DLNS_H
+#define D2DLNS_H
+
+#include <random>
+#include <chrono>
+#include <atomic>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// neighborhoods of d2dLNS, used round robin
+// devices connected by links (L) around a random device, whole superslot
+#define D2D_LNS_CLUSTER 	0
+// devices using or supporting a random channel, whole superslot
+#define D2D_LNS_CHANNEL 	1
+// all devices within a random window of time slots
+#define D2D_LNS_WINDOW 		2
+#define D2D_LNS_NUM_NEIGHBORHOODS 3
+
+// Large neighborhood search on the model of d2dOptimizer. Starting from an incumbent schedule,
+// the state and exchange variables outside a neighborhood are fixed to the incumbent and the
+// remaining sub-MIP is solved with a short time limit, using the incumbent as MIP start. Better
+// solutions replace the incumbent. When all neighborhood types are solved to optimality without
+// improvement, the neighborhoods are enlarged. The search ends at opt->timeLimit or once a
+// neighborhood covering the whole instance has been solved to optimality.
+// The model is built by opt; with another backend holding a copy of it the search can run
+// concurrently to other solvers (d2dPortfolio).
+// Requires a built model and a backend that solves (d2dFileBackend only exports the first sub-MIP).
+class d2dLNS {
+
+	public:
+		d2dOptimizer *opt;
+		// solves the sub-MIPs, opt->backend by default
+		d2dSolverBackend *backend;
+
+		// optional: called with every improved schedule; may return a schedule found elsewhere, which
+		// replaces the incumbent if it is better; the search ends once *stop is set
+		std::function<void(const d2dSchedule&)> found;
+		std::function<bool(d2dSchedule&)> poll;
+		const std::atomic<bool> *stop;
+
+		// seconds per sub-MIP
+		double subTimeLimit;
+		// initial number of free devices of the cluster and channel neighborhoods
+		uint32_t clusterSize;
+		// initial number of free time slots of the window neighborhood, 0 = a quarter of the superslot
+		int64_t windowLength;
+		uint32_t seed;
+
+		d2dLNS(d2dOptimizer *opt);
+
+		// improves schedule, which must be feasible, in place, returns a D2D_STATUS_* value
+		int32_t run(d2dSchedule &schedule);
+
+	private:
+		std::mt19937 rng;
+
+		uint32_t numDev;
+		uint32_t numChan;
+		uint32_t numCont;
+		int64_t numT;
+
+		// current neighborhood, variables of free devices within [windowBegin, windowEnd) are free
+		std::vector<char> freeDevice;
+		int64_t windowBegin;
+		int64_t windowEnd;
+
+		std::vector<double> lb;
+		std::vector<double> ub;
+
+		void selectCluster(uint32_t size);
+		void selectChannel(const d2dSchedule &schedule, uint32_t size);
+		void selectWindow(int64_t length);
+
+		bool isFree(uint32_t d, int64_t t) {
+			return freeDevice[d] && t >= windowBegin && t < windowEnd;
+		}
+
+		// fixes all variables outside the neighborhood to the values of the incumbent
+		void fixOutside(const std::vector<double> &incumbent);
+		void fix(d2dVar var, const std::vector<double> &incumbent) {
+			lb[var] = incumbent[var];
+			ub[var] = incumbent[var];
+		}
+};
+
+#endif
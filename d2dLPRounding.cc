@@ -0,0 +1,144 @@
+#include "d2dLPRounding.h"
+#include "d2dMatchingHeuristic.h"
+#include "d2dValidator.h"
+
+d2dLPRounding::d2dLPRounding(d2dOptimizer *opt) {
+	this->opt 	= opt;
+	backend 	= opt->backend;
+	rounds 		= 16;
+	seed 		= 0;
+	bound 		= 0.0;
+	boundProven = false;
+	gap 		= 0.0;
+}
+
+bool d2dLPRounding::compareTransfers(const transfer &a, const transfer &b) {
+	if (a.density != b.density) {
+		return a.density > b.density;
+	}
+	if (a.d_prv != b.d_prv) {
+		return a.d_prv < b.d_prv;
+	}
+	if (a.d_cns != b.d_cns) {
+		return a.d_cns < b.d_cns;
+	}
+	return a.n < b.n;
+}
+
+void d2dLPRounding::collect(const std::vector<double> &values) {
+	uint32_t numDev 	= opt->deviceVector.size();
+	uint32_t numChan 	= opt->channelVector.size();
+	uint32_t numCont 	= opt->contentVector.size();
+	int64_t numT 		= opt->settings.numTimeSlots;
+
+	transfers.clear();
+	for (uint32_t d_prv = 0; d_prv<numDev; d_prv++) {
+		for (uint32_t d_cns = 0; d_cns<numDev; d_cns++) {
+			if (d_prv == d_cns) {
+				continue;
+			}
+			for (uint32_t n = 0; n<numCont; n++) {
+				if (opt->U[d_prv][d_cns][n] <= 0.0) {
+					continue;
+				}
+				transfer tr;
+				tr.d_prv 	= d_prv;
+				tr.d_cns 	= d_cns;
+				tr.n 		= n;
+				tr.x 		= 0.0;
+				tr.duration = -1;
+				for (uint32_t c = 0; c<numChan; c++) {
+					int64_t duration = opt->exchangeDuration(d_prv, d_cns, n, c);
+					if (duration > 0 && (tr.duration < 0 || duration < tr.duration)) {
+						tr.duration = duration;
+					}
+					for (int64_t t = 0; t<numT; t++) {
+						tr.x += values[opt->y(d_prv, d_cns, n, c, t)];
+					}
+				}
+				if (tr.x <= 1e-6 || tr.duration < 0) {
+					continue;
+				}
+				tr.x 		= std::min(tr.x, 1.0);
+				tr.density 	= opt->U[d_prv][d_cns][n] / (double)tr.duration;
+				transfers.push_back(tr);
+			}
+		}
+	}
+	std::sort(transfers.begin(), transfers.end(), compareTransfers);
+}
+
+void d2dLPRounding::round(uint32_t i, std::vector<double> &weights) {
+	uint64_t numDev 	= opt->deviceVector.size();
+	uint64_t numCont 	= opt->contentVector.size();
+	int64_t numT 		= opt->settings.numTimeSlots;
+	//a provider may serve several consumers at once with multicast or airtime sharing
+	bool providerBusy 	= !opt->multicast && !opt->airtimeSharing;
+
+	weights.assign(numDev * numDev * numCont, D2D_LP_FILL_WEIGHT);
+	std::vector<int64_t> busy(numDev, 0);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	for (uint32_t k = 0; k<transfers.size(); k++) {
+		const transfer &tr = transfers[k];
+		bool selected = i == 0 ? tr.x >= 0.5 : uniform(rng) < tr.x;
+		if (!selected || busy[tr.d_cns] + tr.duration > numT || (providerBusy && busy[tr.d_prv] + tr.duration > numT)) {
+			continue;
+		}
+		weights[(tr.d_prv * numDev + tr.d_cns) * numCont + tr.n] = 1.0;
+		busy[tr.d_cns] += tr.duration;
+		if (providerBusy) {
+			busy[tr.d_prv] += tr.duration;
+		}
+	}
+}
+
+int32_t d2dLPRounding::run(d2dSchedule &schedule) {
+	rng.seed(seed);
+	if (!backend->setRelaxed(true)) {
+		cout << "LP rounding requires a backend solving the relaxation" << endl;
+		return D2D_STATUS_ERROR;
+	}
+	if (opt->timeLimit > 0.0) {
+		std::stringstream sstm;
+		sstm << opt->timeLimit;
+		backend->setParam("TimeLimit", sstm.str());
+	}
+	int32_t status = backend->optimize();
+	backend->setRelaxed(false);
+	if (!backend->hasSolution()) {
+		if (status == D2D_STATUS_EXPORTED) {
+			cout << "LP rounding requires a solver backend, the relaxation has been exported" << endl;
+			return status;
+		}
+		cout << "LP relaxation failed with status " << status << endl;
+		return status == D2D_STATUS_INFEASIBLE ? status : D2D_STATUS_NO_SOLUTION;
+	}
+	std::vector<double> values;
+	backend->getValues(values);
+	bound 		= backend->getObjValue();
+	boundProven = status == D2D_STATUS_OPTIMAL;
+	collect(values);
+
+	d2dMatchingHeuristic heuristic(opt);
+	d2dValidator validator(opt);
+	bool found = false;
+	for (uint32_t i = 0; i<rounds; i++) {
+		d2dSchedule candidate;
+		round(i, heuristic.weights);
+		heuristic.run(candidate);
+		if (validator.validate(candidate) && (!found || validator.utility > schedule.utility)) {
+			schedule 			= candidate;
+			schedule.utility 	= validator.utility;
+			found 				= true;
+		}
+	}
+	if (!found) {
+		cout << "LP rounding found no valid schedule" << endl;
+		return D2D_STATUS_NO_SOLUTION;
+	}
+
+	gap = bound > 0.0 ? std::max(bound - schedule.utility, 0.0) / bound : 0.0;
+	cout << "LP " << (boundProven ? "bound " : "objective (not proven optimal) ") << bound << ", rounded utility " << schedule.utility
+		<< " from " << transfers.size() << " LP transfers, gap " << gap * 100.0 << "%" << endl;
+	return boundProven && gap <= 1e-9 ? D2D_STATUS_OPTIMAL : D2D_STATUS_FEASIBLE;
+}
@@ -0,0 +1,64 @@
+#ifndef D2DLPROUNDING_H
+#define D2DLPROUNDING_H
+
+#include <random>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// weight of the exchanges not selected by the rounding, they fill the schedule after the selected ones
+#define D2D_LP_FILL_WEIGHT 0.1
+
+// Fast scheduling mode for large instances. The continuous relaxation of the model of d2dOptimizer is
+// solved once, its objective is an upper bound of the utility. Per provider, consumer and content the
+// LP value x = sum of y over channels and time slots is rounded: in order of utility density (utility
+// per time slot of the exchange) each transfer is selected with probability x, unless the consumer
+// (or the provider without multicast and airtime sharing) is already busy for the whole superslot
+// with selected transfers. d2dMatchingHeuristic then repairs the selection into a schedule, it sets up
+// the roles and schedules the selected transfers first while keeping half-duplex and interference
+// feasibility. The best valid schedule of all rounds is returned with its gap to the LP bound.
+class d2dLPRounding {
+
+	public:
+		d2dOptimizer *opt;
+		// solves the relaxation, opt->backend by default
+		d2dSolverBackend *backend;
+
+		// number of roundings, the first one selects all transfers with x >= 0.5
+		uint32_t rounds;
+		uint32_t seed;
+
+		// objective of the relaxation, proven upper bound of the utility if boundProven
+		double bound;
+		bool boundProven;
+		// (bound - utility) / bound of the returned schedule
+		double gap;
+
+		d2dLPRounding(d2dOptimizer *opt);
+
+		// schedule rounded from the relaxation, requires a built model, returns a D2D_STATUS_* value
+		int32_t run(d2dSchedule &schedule);
+
+	private:
+		struct transfer {
+			uint32_t d_prv;
+			uint32_t d_cns;
+			uint32_t n;
+			double x;
+			double density;
+			// time slots at the fastest link of the pair
+			int64_t duration;
+		};
+
+		static bool compareTransfers(const transfer &a, const transfer &b);
+
+		std::mt19937 rng;
+		// transfers with x > 0 by decreasing density
+		std::vector<transfer> transfers;
+
+		void collect(const std::vector<double> &values);
+		// weights of d2dMatchingHeuristic for one rounding
+		void round(uint32_t i, std::vector<double> &weights);
+};
+
+#endif
@@ -0,0 +1,466 @@
+#include "d2dLagrangian.h"
+#include "d2dMatchingHeuristic.h"
+#include "d2dLPRounding.h"
+#include "d2dValidator.h"
+
+#include <chrono>
+
+d2dLagrangian::d2dLagrangian(d2dOptimizer *opt) {
+	this->opt 		= opt;
+	maxClusterSize 	= 0;
+	maxIterations 	= 30;
+	subTimeLimit 	= 10.0;
+	stepFactor 		= 2.0;
+	stallLimit 		= 3;
+	createBackend 	= createDefaultBackend;
+	bound 			= D2D_INFINITY;
+	boundValid 		= false;
+	gap 			= 0.0;
+	decomposed 		= false;
+}
+
+d2dLagrangian::~d2dLagrangian() {
+	for (uint32_t k = 0; k<subs.size(); k++) {
+		delete subs[k];
+	}
+}
+
+bool d2dLagrangian::linkClusters(d2dOptimizer *opt, uint32_t maxClusterSize, std::vector< std::vector<uint32_t> > &clusters) {
+	uint32_t numDev 	= opt->deviceVector.size();
+	uint32_t numChan 	= opt->channelVector.size();
+	std::vector< std::vector<uint32_t> > neighbors(numDev);
+	for (uint32_t a = 0; a<numDev; a++) {
+		for (uint32_t b = a + 1; b<numDev; b++) {
+			for (uint32_t c = 0; c<numChan; c++) {
+				if (opt->L[a][b][c] > 0 || opt->L[b][a][c] > 0) {
+					neighbors[a].push_back(b);
+					neighbors[b].push_back(a);
+					break;
+				}
+			}
+		}
+	}
+
+	//breadth first search per component, parts of the BFS order keep neighboring devices together
+	bool split = false;
+	clusters.clear();
+	std::vector<char> visited(numDev, 0);
+	for (uint32_t start = 0; start<numDev; start++) {
+		if (visited[start]) {
+			continue;
+		}
+		std::vector<uint32_t> component(1, start);
+		visited[start] = 1;
+		for (uint32_t i = 0; i<component.size(); i++) {
+			uint32_t a = component[i];
+			for (uint32_t j = 0; j<neighbors[a].size(); j++) {
+				uint32_t b = neighbors[a][j];
+				if (!visited[b]) {
+					visited[b] = 1;
+					component.push_back(b);
+				}
+			}
+		}
+		uint32_t part = maxClusterSize > 0 ? maxClusterSize : component.size();
+		split = split || component.size() > part;
+		for (uint32_t i = 0; i<component.size(); i += part) {
+			clusters.push_back(std::vector<uint32_t>(component.begin() + i, component.begin() + std::min<size_t>(i + part, component.size())));
+			std::sort(clusters.back().begin(), clusters.back().end());
+		}
+	}
+	return split;
+}
+
+void d2dLagrangian::partition() {
+	decomposed = linkClusters(opt, maxClusterSize, clusters) || decomposed;
+	clusterOf.assign(numDev, 0);
+	localIndex.assign(numDev, 0);
+	for (uint32_t k = 0; k<clusters.size(); k++) {
+		for (uint32_t i = 0; i<clusters[k].size(); i++) {
+			clusterOf[clusters[k][i]] 	= k;
+			localIndex[clusters[k][i]] 	= i;
+		}
+	}
+}
+
+void d2dLagrangian::extract(uint32_t k, d2dOptimizer *sub) {
+	const std::vector<uint32_t> &devices = clusters[k];
+	uint32_t size = devices.size();
+
+	for (uint32_t c = 0; c<numChan; c++) {
+		sub->addChannel(opt->channelVector[c]->id);
+	}
+	for (uint32_t n = 0; n<numCont; n++) {
+		sub->addContent(opt->contentVector[n]->id, opt->contentVector[n]->size);
+	}
+	for (uint32_t i = 0; i<size; i++) {
+		const device *src = opt->deviceVector[devices[i]];
+		device *dev = sub->addDevice(src->id);
+		dev->hasPosition 	= src->hasPosition;
+		dev->x 				= src->x;
+		dev->y 				= src->y;
+		dev->capacity 		= src->capacity;
+	}
+	sub->settings 	= opt->settings;
+	sub->radio 		= opt->radio;
+	sub->allocateParameters();
+
+	for (uint32_t n = 0; n<numCont; n++) {
+		sub->S[n] = opt->S[n];
+	}
+	bool terminal = !opt->terminalAP.empty() && !opt->terminalClient.empty();
+	if (terminal) {
+		sub->terminalAP.assign(size * numChan, 0.0);
+		sub->terminalClient.assign(size * size, 0.0);
+	}
+	for (uint32_t i = 0; i<size; i++) {
+		uint32_t d = devices[i];
+		for (uint32_t n = 0; n<numCont; n++) {
+			sub->P[i][n] = opt->P[d][n];
+			sub->I[i][n] = opt->I[d][n];
+			sub->D[i][n] = opt->D[d][n];
+		}
+		for (uint32_t c = 0; c<numChan; c++) {
+			sub->W[i][c] 		= opt->W[d][c];
+			sub->START_AP[i][c] = opt->START_AP[d][c];
+			if (terminal) {
+				sub->terminalAP[i * numChan + c] = opt->terminalAP[d * numChan + c];
+			}
+		}
+		sub->START_Idle[i] = opt->START_Idle[d];
+		//a client of an AP in another cluster starts Idle
+		for (uint32_t d_ap = 0; d_ap<numDev; d_ap++) {
+			if (opt->START_Client[d][d_ap] == 1 && clusterOf[d_ap] != k) {
+				sub->START_Idle[i] 	= 1;
+				decomposed 			= true;
+			}
+		}
+		for (uint32_t j = 0; j<size; j++) {
+			uint32_t e = devices[j];
+			sub->START_Client[i][j] = opt->START_Client[d][e];
+			if (terminal) {
+				sub->terminalClient[i * size + j] = opt->terminalClient[d * numDev + e];
+			}
+			for (uint32_t c = 0; c<numChan; c++) {
+				sub->L[i][j][c] = opt->L[d][e][c];
+				for (uint32_t c_int = 0; c_int<numChan; c_int++) {
+					sub->X[i][c][j][c_int] = opt->X[d][c][e][c_int];
+				}
+			}
+			for (uint32_t n = 0; n<numCont; n++) {
+				sub->U[i][j][n] = opt->U[d][e][n];
+			}
+		}
+	}
+
+	sub->mode 				= D2D_MODE_MIP;
+	sub->numThreads 		= 1;
+	sub->channelReuse 		= opt->channelReuse;
+	sub->multicast 			= opt->multicast;
+	sub->airtimeSharing 	= opt->airtimeSharing;
+	sub->utilityDecay 		= opt->utilityDecay;
+	sub->decayRate 			= opt->decayRate;
+	sub->decaySlot 			= opt->decaySlot;
+	sub->debug 				= false;
+	sub->debugResults 		= false;
+}
+
+void d2dLagrangian::findPairs() {
+	pairs.clear();
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (uint32_t c = 0; c<numChan; c++) {
+			const std::vector< std::pair<uint32_t, uint32_t> > &receivers = opt->interferenceList[d * numChan + c];
+			for (uint32_t i = 0; i<receivers.size(); i++) {
+				uint32_t e 		= receivers[i].first;
+				uint32_t c_rx 	= receivers[i].second;
+				if (clusterOf[e] == clusterOf[d]) {
+					continue;
+				}
+				couplingPair pair;
+				pair.a 	= d;
+				pair.b 	= e;
+				pair.ca = c;
+				pair.cb = c_rx;
+				pair.interference = true;
+				pairs.push_back(pair);
+				//APperChan with channel reuse, each pair once as in the model
+				if (opt->channelReuse && c_rx == c && !(e < d && opt->X[e][c][d][c] == 1)) {
+					pair.interference = false;
+					pairs.push_back(pair);
+				}
+			}
+		}
+	}
+}
+
+d2dVar d2dLagrangian::pairVar(const couplingPair &pair, bool first, int64_t t) {
+	uint32_t d 	= first ? pair.a : pair.b;
+	uint32_t c 	= first ? pair.ca : pair.cb;
+	d2dOptimizer *sub = subs[clusterOf[d]];
+	if (!pair.interference) {
+		return sub->S_AP(localIndex[d], c, t);
+	}
+	return first ? sub->s(localIndex[d], c, t) : sub->r(localIndex[d], c, t);
+}
+
+double d2dLagrangian::pairValue(const couplingPair &pair, bool first, int64_t t) {
+	d2dOptimizer *sub = subs[clusterOf[first ? pair.a : pair.b]];
+	return sub->solution[pairVar(pair, first, t)] > 0.5 ? 1.0 : 0.0;
+}
+
+bool d2dLagrangian::hasAP(uint32_t d, uint32_t c, int64_t t) {
+	d2dOptimizer *sub = subs[clusterOf[d]];
+	return sub->solution[sub->S_AP(localIndex[d], c, t)] > 0.5;
+}
+
+void d2dLagrangian::setPrices() {
+	for (uint32_t k = 0; k<subs.size(); k++) {
+		subs[k]->extraObjective.clear();
+	}
+	for (uint32_t d = 0; d<numDev && !channelPrice.empty(); d++) {
+		d2dOptimizer *sub = subs[clusterOf[d]];
+		for (uint32_t c = 0; c<numChan; c++) {
+			for (int64_t t = 0; t<numT; t++) {
+				double price = channelPrice[c * numT + t];
+				if (price > 0.0) {
+					sub->extraObjective.push_back(std::make_pair(sub->S_AP(localIndex[d], c, t), -price));
+				}
+			}
+		}
+	}
+	for (uint32_t i = 0; i<pairs.size(); i++) {
+		for (int64_t t = 0; t<numT; t++) {
+			double price = pairPrice[i * numT + t];
+			if (price <= 0.0) {
+				continue;
+			}
+			subs[clusterOf[pairs[i].a]]->extraObjective.push_back(std::make_pair(pairVar(pairs[i], true, t), -price));
+			subs[clusterOf[pairs[i].b]]->extraObjective.push_back(std::make_pair(pairVar(pairs[i], false, t), -price));
+		}
+	}
+}
+
+void d2dLagrangian::solveSubs() {
+	subStatus.assign(subs.size(), D2D_STATUS_UNKNOWN);
+	subObjective.assign(subs.size(), 0.0);
+	std::atomic<uint32_t> next(0);
+	auto worker = [&]() {
+		for (uint32_t k = next++; k<subs.size(); k = next++) {
+			d2dOptimizer *sub = subs[k];
+			try {
+				sub->buildObjective();
+				subStatus[k] = sub->backend->optimize();
+				if (sub->backend->hasSolution()) {
+					sub->backend->getValues(sub->solution);
+					sub->getSchedule(sub->schedule);
+					subObjective[k] = sub->backend->getObjValue();
+				}
+			} catch (exception &e) {
+				cout << "Cluster " << k << ": " << e.what() << endl;
+				subStatus[k] = D2D_STATUS_ERROR;
+			}
+		}
+	};
+	uint32_t numWorkers = std::max<uint32_t>(1, std::min<uint32_t>(opt->buildThreads(), subs.size()));
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i<numWorkers; i++) {
+		workers.push_back(std::thread(worker));
+	}
+	worker();
+	for (uint32_t i = 0; i<workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+void d2dLagrangian::combine(d2dSchedule &schedule) {
+	schedule.reset(numDev, numT);
+	for (uint32_t k = 0; k<clusters.size(); k++) {
+		const d2dSchedule &local = subs[k]->schedule;
+		const std::vector<uint32_t> &devices = clusters[k];
+		for (uint32_t i = 0; i<devices.size(); i++) {
+			for (int64_t t = 0; t<numT; t++) {
+				uint8_t role = local.getRole(i, t);
+				uint32_t arg = local.getRoleArg(i, t);
+				bool client = role == D2D_ROLE_STARTCLIENT || role == D2D_ROLE_JOINAP || role == D2D_ROLE_CLIENT;
+				schedule.setRole(devices[i], t, role, client ? devices[arg] : arg);
+			}
+		}
+		for (uint32_t i = 0; i<local.exchanges.size(); i++) {
+			d2dExchange ex = local.exchanges[i];
+			ex.d_prv = devices[ex.d_prv];
+			ex.d_cns = devices[ex.d_cns];
+			schedule.exchanges.push_back(ex);
+		}
+		schedule.utility += local.utility;
+	}
+}
+
+int32_t d2dLagrangian::run(d2dSchedule &schedule) {
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	numDev 	= opt->deviceVector.size();
+	numChan = opt->channelVector.size();
+	numCont = opt->contentVector.size();
+	numT 	= opt->settings.numTimeSlots;
+	opt->updateInterferenceList();
+	if (opt->multicast && opt->multicastRates.empty()) {
+		opt->computeMulticastRates();
+	}
+
+	decomposed 	= false;
+	boundValid 	= false;
+	partition();
+	findPairs();
+	for (uint32_t k = 0; k<subs.size(); k++) {
+		delete subs[k];
+	}
+	subs.assign(clusters.size(), NULL);
+	for (uint32_t k = 0; k<clusters.size(); k++) {
+		subs[k] = new d2dOptimizer(createBackend());
+		extract(k, subs[k]);
+		subs[k]->buildModel();
+		if (subTimeLimit > 0.0) {
+			std::stringstream sstm;
+			sstm << subTimeLimit;
+			subs[k]->backend->setParam("TimeLimit", sstm.str());
+		}
+	}
+	cout << "Lagrangian decomposition: " << clusters.size() << " clusters, " << pairs.size() << " coupling pairs" << endl;
+
+	//without channel reuse all APs of a channel are coupled, which only matters between clusters
+	channelPrice.clear();
+	if (!opt->channelReuse && clusters.size() > 1) {
+		channelPrice.assign(numChan * numT, 0.0);
+	}
+	pairPrice.assign(pairs.size() * numT, 0.0);
+
+	d2dMatchingHeuristic heuristic(opt);
+	d2dValidator validator(opt);
+	bool found 		= false;
+	bool bounded 	= false;
+	bound 			= D2D_INFINITY;
+	double theta 	= stepFactor;
+	uint32_t stall 	= 0;
+	uint32_t iteration = 0;
+	int32_t status 	= D2D_STATUS_FEASIBLE;
+	while (iteration < maxIterations) {
+		iteration++;
+		setPrices();
+		solveSubs();
+
+		bool allOptimal = true;
+		for (uint32_t k = 0; k<subs.size() && status == D2D_STATUS_FEASIBLE; k++) {
+			if (subStatus[k] == D2D_STATUS_EXPORTED) {
+				cout << "Lagrangian decomposition requires a solver backend" << endl;
+				status = D2D_STATUS_EXPORTED;
+			} else if (!subs[k]->backend->hasSolution() || subStatus[k] == D2D_STATUS_ERROR) {
+				cout << "Cluster " << k << " failed with status " << subStatus[k] << endl;
+				status = D2D_STATUS_ERROR;
+			}
+			allOptimal = allOptimal && subStatus[k] == D2D_STATUS_OPTIMAL;
+		}
+		if (status != D2D_STATUS_FEASIBLE) {
+			break;
+		}
+
+		//Lagrangian dual, each dualized row has right hand side 1
+		double dual = 0.0;
+		for (uint32_t k = 0; k<subs.size(); k++) {
+			dual += subObjective[k];
+		}
+		for (uint32_t i = 0; i<channelPrice.size(); i++) {
+			dual += channelPrice[i];
+		}
+		for (uint32_t i = 0; i<pairPrice.size(); i++) {
+			dual += pairPrice[i];
+		}
+		if (allOptimal && dual < bound - 1e-9) {
+			bound 	= dual;
+			bounded = true;
+			stall 	= 0;
+		} else if (++stall >= stallLimit) {
+			theta 	/= 2.0;
+			stall 	= 0;
+		}
+
+		//primal schedules: the combination of the clusters and its repair
+		d2dSchedule candidate;
+		combine(candidate);
+		if (validator.validate(candidate) && (!found || validator.utility > schedule.utility)) {
+			schedule 			= candidate;
+			schedule.utility 	= validator.utility;
+			found 				= true;
+		}
+		heuristic.weights.assign((uint64_t)numDev * numDev * numCont, D2D_LP_FILL_WEIGHT);
+		for (uint32_t i = 0; i<candidate.exchanges.size(); i++) {
+			const d2dExchange &ex = candidate.exchanges[i];
+			heuristic.weights[((uint64_t)ex.d_prv * numDev + ex.d_cns) * numCont + ex.n] = 1.0;
+		}
+		heuristic.run(candidate);
+		if (validator.validate(candidate) && (!found || validator.utility > schedule.utility)) {
+			schedule 			= candidate;
+			schedule.utility 	= validator.utility;
+			found 				= true;
+		}
+		cout << "Lagrangian iteration " << iteration << " dual " << dual << " best bound " << (bounded ? bound : dual)
+			 << " utility " << (found ? schedule.utility : 0.0) << endl;
+
+		//subgradients, prices at 0 with a satisfied row stay 0
+		std::vector<double> channelGrad(channelPrice.size(), -1.0);
+		for (uint32_t d = 0; d<numDev && !channelPrice.empty(); d++) {
+			for (uint32_t c = 0; c<numChan; c++) {
+				for (int64_t t = 0; t<numT; t++) {
+					channelGrad[c * numT + t] += hasAP(d, c, t) ? 1.0 : 0.0;
+				}
+			}
+		}
+		std::vector<double> pairGrad(pairPrice.size());
+		for (uint32_t i = 0; i<pairs.size(); i++) {
+			for (int64_t t = 0; t<numT; t++) {
+				pairGrad[i * numT + t] = pairValue(pairs[i], true, t) + pairValue(pairs[i], false, t) - 1.0;
+			}
+		}
+		double norm = 0.0;
+		for (uint32_t i = 0; i<channelGrad.size(); i++) {
+			norm += channelPrice[i] > 0.0 || channelGrad[i] > 0.0 ? channelGrad[i] * channelGrad[i] : 0.0;
+		}
+		for (uint32_t i = 0; i<pairGrad.size(); i++) {
+			norm += pairPrice[i] > 0.0 || pairGrad[i] > 0.0 ? pairGrad[i] * pairGrad[i] : 0.0;
+		}
+		double target = found ? schedule.utility : 0.0;
+		//a split component only bounds the relaxation of the clusters, not the instance
+		if (norm == 0.0 || (bounded && !decomposed && bound - target <= 1e-9)) {
+			break;
+		}
+		double step = theta * std::max(dual - target, 1e-6) / norm;
+		for (uint32_t i = 0; i<channelPrice.size(); i++) {
+			channelPrice[i] = std::max(0.0, channelPrice[i] + step * channelGrad[i]);
+		}
+		for (uint32_t i = 0; i<pairPrice.size(); i++) {
+			pairPrice[i] = std::max(0.0, pairPrice[i] + step * pairGrad[i]);
+		}
+
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		if (opt->timeLimit > 0.0 && elapsed >= opt->timeLimit) {
+			break;
+		}
+	}
+
+	for (uint32_t k = 0; k<subs.size(); k++) {
+		delete subs[k];
+	}
+	subs.clear();
+	if (!found) {
+		return status == D2D_STATUS_FEASIBLE ? D2D_STATUS_NO_SOLUTION : status;
+	}
+
+	boundValid 	= bounded && !decomposed;
+	gap 		= boundValid && bound > 0.0 ? std::max(bound - schedule.utility, 0.0) / bound : 0.0;
+	cout << "Lagrangian utility " << schedule.utility << " after " << iteration << " iterations";
+	if (boundValid) {
+		cout << ", bound " << bound << ", gap " << gap * 100.0 << "%";
+	} else if (bounded) {
+		cout << ", bound of the clusters " << bound << " (components split, not valid for the instance)";
+	}
+	cout << endl;
+	return boundValid && gap <= 1e-9 ? D2D_STATUS_OPTIMAL : D2D_STATUS_FEASIBLE;
+}
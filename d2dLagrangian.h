@@ -0,0 +1,104 @@
+#ifndef D2DLAGRANGIAN_H
+#define D2DLAGRANGIAN_H
+
+#include <atomic>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// Lagrangian decomposition for large networks. The devices are partitioned into clusters, the
+// connected components of the links (L > 0 in either direction), split into parts of at most
+// maxClusterSize devices. Exchanges only take place within a cluster, so CnsServedByOnePrv and
+// PrvOnlyOneConsumer stay in the subproblem of each cluster. The rows coupling different clusters
+// are dualized:
+//  - APperChan: sum of S_AP[d][c][t] over all devices <= 1, or with channel reuse the pairs of
+//    interfering APs in different clusters
+//  - Interference between a transmitter and a receiver in different clusters: s + r <= 1
+// Each cluster is a separate instance with its own model and backend, solved in parallel with the
+// prices of the multipliers in its objective (d2dOptimizer::extraObjective). The multipliers are
+// updated by subgradient steps (Polyak step length towards the best schedule). In each iteration
+// the schedules of the clusters are combined, which is a valid schedule if no dualized row is
+// violated, and d2dMatchingHeuristic repairs the combination into a valid schedule by preferring
+// the exchanges of the clusters.
+// The sum of the subproblem objectives plus the multipliers is an upper bound of the utility if
+// all subproblems are solved to optimality and no component was split (boundValid).
+class d2dLagrangian {
+
+	public:
+		d2dOptimizer *opt;
+
+		// devices per cluster, 0 = connected components only
+		uint32_t maxClusterSize;
+		uint32_t maxIterations;
+		// seconds per subproblem
+		double subTimeLimit;
+		// initial factor of the Polyak step, halved after stallLimit iterations without a better bound
+		double stepFactor;
+		uint32_t stallLimit;
+		// backend of each cluster, createDefaultBackend() by default
+		std::function<d2dSolverBackend*()> createBackend;
+
+		// best Lagrangian bound, valid upper bound of the utility if boundValid
+		double bound;
+		bool boundValid;
+		double gap;
+
+		d2dLagrangian(d2dOptimizer *opt);
+		~d2dLagrangian();
+
+		// best valid schedule found until maxIterations or opt->timeLimit, returns a D2D_STATUS_* value
+		int32_t run(d2dSchedule &schedule);
+
+		// clusters of the devices of opt in increasing order: connected components of the links, split
+		// into parts of at most maxClusterSize devices along a breadth first search (0 = no split),
+		// returns true if a component was split
+		static bool linkClusters(d2dOptimizer *opt, uint32_t maxClusterSize, std::vector< std::vector<uint32_t> > &clusters);
+
+	private:
+		uint32_t numDev;
+		uint32_t numChan;
+		uint32_t numCont;
+		int64_t numT;
+
+		// cluster of each device and its index in the instance of the cluster
+		std::vector<uint32_t> clusterOf;
+		std::vector<uint32_t> localIndex;
+		std::vector< std::vector<uint32_t> > clusters;
+		std::vector<d2dOptimizer*> subs;
+		// a component was split or an initial client role across clusters was dropped
+		bool decomposed;
+
+		// dualized pair rows, value(a) + value(b) <= 1 per time slot: S_AP[a][ca] + S_AP[b][cb] for APs,
+		// s[a][ca] + r[b][cb] for interference
+		struct couplingPair {
+			uint32_t a;
+			uint32_t b;
+			uint32_t ca;
+			uint32_t cb;
+			bool interference;
+		};
+		std::vector<couplingPair> pairs;
+
+		// multipliers, per channel and time slot without channel reuse, per pair and time slot
+		std::vector<double> channelPrice;
+		std::vector<double> pairPrice;
+
+		std::vector<int32_t> subStatus;
+		std::vector<double> subObjective;
+
+		void partition();
+		// instance of the devices of cluster k
+		void extract(uint32_t k, d2dOptimizer *sub);
+		void findPairs();
+
+		d2dVar pairVar(const couplingPair &pair, bool first, int64_t t);
+		double pairValue(const couplingPair &pair, bool first, int64_t t);
+		bool hasAP(uint32_t d, uint32_t c, int64_t t);
+
+		void setPrices();
+		void solveSubs();
+		// schedule of opt from the schedules of the clusters
+		void combine(d2dSchedule &schedule);
+};
+
+#endif
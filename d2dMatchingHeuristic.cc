@@ -0,0 +1,573 @@
+#include "d2dMatchingHeuristic.h"
+
+d2dMatchingHeuristic::d2dMatchingHeuristic(d2dOptimizer *opt) {
+	this->opt = opt;
+}
+
+bool d2dMatchingHeuristic::compareCandidates(const candidate &a, const candidate &b) {
+	if (a.utility != b.utility) {
+		return a.utility > b.utility;
+	}
+	if (a.d_prv != b.d_prv) {
+		return a.d_prv < b.d_prv;
+	}
+	return a.d_cns < b.d_cns;
+}
+
+bool d2dMatchingHeuristic::compareProxy(const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b) {
+	if (a.first != b.first) {
+		return a.first > b.first;
+	}
+	return a.second < b.second;
+}
+
+void d2dMatchingHeuristic::init(d2dSchedule &schedule) {
+	numDev 	= opt->deviceVector.size();
+	numChan = opt->channelVector.size();
+	numCont = opt->contentVector.size();
+	numT 	= opt->settings.numTimeSlots;
+
+	switchSlots = std::max<int64_t>(opt->settings.kappa_startAP, 1);
+	joinSlots 	= std::max<int64_t>(opt->settings.kappa_startClient, 1);
+
+	schedule.reset(numDev, numT);
+
+	role.assign(numDev, D2D_ROLE_IDLE);
+	roleArg.assign(numDev, 0);
+	roleStart.assign(numDev, -1);
+	parked.assign(numDev, 0);
+	busyUntil.assign(numDev, 0);
+	airtime.clear();
+	if (opt->airtimeSharing && !opt->multicast) {
+		airtime.assign((uint64_t)numDev * numT, 0.0);
+	}
+	numClients.assign(numDev, 0);
+	channelAPs.assign(numChan, std::vector<uint32_t>());
+
+	settled.assign(numDev, 0);
+	stale.assign(numDev, 0);
+	decided.assign(numDev, 0);
+	reserved.assign(numDev, 0);
+	gain.assign(numDev * numChan, 0.0);
+	touched.clear();
+	active.clear();
+
+	//initial states, a device is Idle, AP or client of an AP
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (uint32_t c = 0; c<numChan; c++) {
+			if (opt->START_AP[d][c] == 1) {
+				role[d] 		= D2D_ROLE_AP;
+				roleArg[d] 		= c;
+				channelAPs[c].push_back(d);
+			}
+		}
+		for (uint32_t d_ap = 0; d_ap<numDev; d_ap++) {
+			if (opt->START_Client[d][d_ap] == 1) {
+				role[d] 	= D2D_ROLE_CLIENT;
+				roleArg[d] 	= d_ap;
+				numClients[d_ap]++;
+			}
+		}
+	}
+
+	holds.assign(numDev * numCont, 0);
+	incoming.assign(numDev * numCont, 0);
+	storage.resize(numDev);
+	for (uint32_t d = 0; d<numDev; d++) {
+		storage[d] = opt->freeStorage(d);
+	}
+	heldContent.assign(numDev, std::vector<uint32_t>());
+	wantedContent.assign(numDev, std::vector<uint32_t>());
+	holders.assign(numCont, std::vector<uint32_t>());
+	interested.assign(numCont, std::vector<uint32_t>());
+	for (uint32_t d = 0; d<numDev; d++) {
+		opt->P.columns(d, NULL, 0, heldContent[d]);
+		opt->I.columns(d, &opt->P, d, wantedContent[d]);
+		for (uint32_t i = 0; i<heldContent[d].size(); i++) {
+			holds[d * numCont + heldContent[d][i]] = 1;
+			holders[heldContent[d][i]].push_back(d);
+		}
+		for (uint32_t i = 0; i<wantedContent[d].size(); i++) {
+			interested[wantedContent[d][i]].push_back(d);
+		}
+	}
+
+	interferer.assign(numDev, 0);
+	victim.assign(numDev, 0);
+	opt->updateInterferenceList();
+	for (uint32_t d_tx = 0; d_tx<numDev; d_tx++) {
+		for (uint32_t c_tx = 0; c_tx<numChan; c_tx++) {
+			const std::vector< std::pair<uint32_t, uint32_t> > &receivers = opt->interferenceList[d_tx * numChan + c_tx];
+			for (uint32_t i = 0; i<receivers.size(); i++) {
+				interferer[d_tx] 			= 1;
+				victim[receivers[i].first] 	= 1;
+			}
+		}
+	}
+}
+
+void d2dMatchingHeuristic::run(d2dSchedule &schedule) {
+	init(schedule);
+
+	for (int64_t t = 0; t<numT; t++) {
+
+		//roles continue from the previous slot, the start of an AP / client takes switchSlots / joinSlots
+		if (t > 0) {
+			for (uint32_t d = 0; d<numDev; d++) {
+				if (role[d] == D2D_ROLE_STARTAP || role[d] == D2D_ROLE_SWITCHAP) {
+					role[d] = (parked[d] || t - roleStart[d] <= switchSlots) ? D2D_ROLE_SWITCHAP : D2D_ROLE_AP;
+				} else if (role[d] == D2D_ROLE_STARTCLIENT || role[d] == D2D_ROLE_JOINAP) {
+					role[d] = (t - roleStart[d] <= joinSlots) ? D2D_ROLE_JOINAP : D2D_ROLE_CLIENT;
+				}
+			}
+		}
+
+		finishExchanges(schedule, t);
+		matchExchanges(schedule, t);
+
+		//devices without a possible exchange in their current role may change it
+		for (uint32_t d = 0; d<numDev; d++) {
+			decided[d] 	= 0;
+			reserved[d] = 0;
+			stale[d] 	= 0;
+			//S_StartAP and S_StartClient require S_Idle, S_AP or S_Client in the previous slot (C21, C29)
+			settled[d] 	= busyUntil[d] <= t && (t == 0 || stableRole(schedule.getRole(d, t - 1)));
+			if (!settled[d]) {
+				continue;
+			}
+			candidate cand;
+			switch (role[d]) {
+				case D2D_ROLE_IDLE:
+					stale[d] = 1;
+					break;
+				case D2D_ROLE_AP:
+					stale[d] = numClients[d] == 0;
+					break;
+				case D2D_ROLE_CLIENT:
+					stale[d] = !bestExchange(roleArg[d], d, roleArg[roleArg[d]], t, cand);
+					break;
+			}
+		}
+		joinAPs(t, false);
+		joinAPs(t, true);
+		startAPs(t);
+
+		for (uint32_t d = 0; d<numDev; d++) {
+			schedule.setRole(d, t, role[d], roleArg[d]);
+		}
+	}
+}
+
+bool d2dMatchingHeuristic::bestExchange(uint32_t a, uint32_t b, uint32_t c, int64_t t, candidate &best) {
+	bool found = false;
+	best.utility = 0.0;
+
+	for (int dir = 0; dir<2; dir++) {
+		uint32_t d_prv = dir == 0 ? a : b;
+		uint32_t d_cns = dir == 0 ? b : a;
+		if (opt->W[d_prv][c] == 0 || opt->W[d_cns][c] == 0 || opt->L[d_prv][d_cns][c] <= 0) {
+			continue;
+		}
+		for (uint32_t i = 0; i<heldContent[d_prv].size(); i++) {
+			uint32_t n = heldContent[d_prv][i];
+			double utility = weighted(d_prv, d_cns, n, opt->exchangeUtility(d_prv, d_cns, n, c, t));
+			if (utility > best.utility && wants(d_cns, n) && opt->exchangeFits(d_prv, d_cns, n, c, t)) {
+				best.d_prv 		= d_prv;
+				best.d_cns 		= d_cns;
+				best.n 			= n;
+				best.c 			= c;
+				best.utility 	= utility;
+				found 			= true;
+			}
+		}
+	}
+	return found;
+}
+
+bool d2dMatchingHeuristic::interferes(const d2dSchedule &schedule, const candidate &cand) {
+	if (!interferer[cand.d_prv] && !victim[cand.d_cns]) {
+		return false;
+	}
+	//all running exchanges overlap with the new one, consumers of the same transmitter are not affected
+	for (uint32_t i = 0; i<active.size(); i++) {
+		const d2dExchange &ex = schedule.exchanges[active[i]];
+		if (ex.d_prv == cand.d_prv) {
+			continue;
+		}
+		if (opt->X[cand.d_prv][cand.c][ex.d_cns][ex.c] == 1 ||
+			opt->X[ex.d_prv][ex.c][cand.d_cns][cand.c] == 1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void d2dMatchingHeuristic::finishExchanges(d2dSchedule &schedule, int64_t t) {
+	for (uint32_t i = 0; i<active.size(); ) {
+		const d2dExchange &ex = schedule.exchanges[active[i]];
+		if (ex.t + ex.duration > t) {
+			i++;
+			continue;
+		}
+		holds[ex.d_cns * numCont + ex.n] 	= 1;
+		incoming[ex.d_cns * numCont + ex.n] = 0;
+		heldContent[ex.d_cns].push_back(ex.n);
+		holders[ex.n].push_back(ex.d_cns);
+
+		active[i] = active.back();
+		active.pop_back();
+	}
+}
+
+void d2dMatchingHeuristic::matchExchanges(d2dSchedule &schedule, int64_t t) {
+	std::vector<candidate> candidates;
+	for (uint32_t d = 0; d<numDev; d++) {
+		if (role[d] != D2D_ROLE_CLIENT || busyUntil[d] > t) {
+			continue;
+		}
+		uint32_t d_ap = roleArg[d];
+		if (role[d_ap] != D2D_ROLE_AP || (busyUntil[d_ap] > t && airtime.empty())) {
+			continue;
+		}
+		candidate cand;
+		if (bestExchange(d_ap, d, roleArg[d_ap], t, cand)) {
+			candidates.push_back(cand);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), compareCandidates);
+
+	for (uint32_t i = 0; i<candidates.size(); i++) {
+		const candidate &cand = candidates[i];
+		if (!canSend(cand, t) || busyUntil[cand.d_cns] > t || !wants(cand.d_cns, cand.n)) {
+			continue;
+		}
+		if (interferes(schedule, cand)) {
+			continue;
+		}
+		std::vector<candidate> group(1, cand);
+		int64_t duration = opt->exchangeDuration(cand.d_prv, cand.d_cns, cand.n, cand.c);
+		if (opt->multicast && role[cand.d_prv] == D2D_ROLE_AP) {
+			duration = addReceivers(schedule, group, t);
+		}
+		for (uint32_t k = 0; k<group.size(); k++) {
+			schedule.exchanges.push_back(d2dExchange(group[k].d_prv, group[k].d_cns, group[k].n, group[k].c, t, duration));
+			schedule.utility += opt->exchangeUtility(group[k].d_prv, group[k].d_cns, group[k].n, group[k].c, t);
+			active.push_back(schedule.exchanges.size() - 1);
+
+			busyUntil[group[k].d_cns] = t + duration;
+			incoming[group[k].d_cns * numCont + group[k].n] = 1;
+			if (storage[group[k].d_cns] >= 0) {
+				storage[group[k].d_cns] -= opt->S[group[k].n];
+			}
+		}
+		busyUntil[cand.d_prv] = std::max(busyUntil[cand.d_prv], t + duration);
+		if (!airtime.empty()) {
+			double share = opt->airtimeShare(cand.d_prv, cand.d_cns, cand.n, cand.c);
+			for (int64_t u = t; u<t + duration; u++) {
+				airtime[cand.d_prv * numT + u] += share;
+			}
+		}
+	}
+}
+
+bool d2dMatchingHeuristic::canSend(const candidate &cand, int64_t t) {
+	if (busyUntil[cand.d_prv] <= t) {
+		return true;
+	}
+	//a device receiving content does not send (half-duplex)
+	if (airtime.empty() || airtime[cand.d_prv * numT + t] == 0.0) {
+		return false;
+	}
+	double share = opt->airtimeShare(cand.d_prv, cand.d_cns, cand.n, cand.c);
+	int64_t duration = opt->exchangeDuration(cand.d_prv, cand.d_cns, cand.n, cand.c);
+	for (int64_t u = t; u<t + duration; u++) {
+		if (airtime[cand.d_prv * numT + u] + share > 1.0 + D2D_AIRTIME_TOLERANCE) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int64_t d2dMatchingHeuristic::addReceivers(const d2dSchedule &schedule, std::vector<candidate> &group, int64_t t) {
+	const candidate first = group[0];
+	//fastest links first, a slower client is added if the transmission at its rate still fits
+	std::vector< std::pair<long, uint32_t> > clients;
+	for (uint32_t e = 0; e<numDev; e++) {
+		if (e == first.d_cns || role[e] != D2D_ROLE_CLIENT || roleArg[e] != first.d_prv || busyUntil[e] > t ||
+			!wants(e, first.n) || opt->W[e][first.c] == 0 || opt->L[first.d_prv][e][first.c] <= 0 || opt->U[first.d_prv][e][first.n] <= 0) {
+			continue;
+		}
+		clients.push_back(std::make_pair(-opt->L[first.d_prv][e][first.c], e));
+	}
+	std::sort(clients.begin(), clients.end());
+
+	uint32_t slowest = first.d_cns;
+	for (uint32_t i = 0; i<clients.size(); i++) {
+		candidate cand 	= first;
+		cand.d_cns 		= clients[i].second;
+		cand.utility 	= weighted(cand.d_prv, cand.d_cns, cand.n, opt->exchangeUtility(cand.d_prv, cand.d_cns, cand.n, cand.c, t));
+		bool slower = opt->L[cand.d_prv][cand.d_cns][cand.c] < opt->L[cand.d_prv][slowest][cand.c];
+		if ((slower && !opt->exchangeFits(cand.d_prv, cand.d_cns, cand.n, cand.c, t)) || interferes(schedule, cand)) {
+			continue;
+		}
+		//the group and the new consumer end at the slower of both rates
+		int64_t end = t + opt->exchangeDuration(cand.d_prv, slower ? cand.d_cns : slowest, cand.n, cand.c);
+		bool late = !opt->meetsDeadline(cand.d_cns, cand.n, end);
+		for (uint32_t k = 0; k<group.size() && slower; k++) {
+			late = late || !opt->meetsDeadline(group[k].d_cns, cand.n, end);
+		}
+		if (late) {
+			continue;
+		}
+		if (slower) {
+			slowest = cand.d_cns;
+		}
+		group.push_back(cand);
+	}
+	return opt->exchangeDuration(first.d_prv, slowest, first.n, first.c);
+}
+
+void d2dMatchingHeuristic::leaveRole(uint32_t d) {
+	switch (role[d]) {
+		case D2D_ROLE_STARTAP:
+		case D2D_ROLE_SWITCHAP:
+		case D2D_ROLE_AP:
+		{
+			std::vector<uint32_t> &aps = channelAPs[roleArg[d]];
+			std::vector<uint32_t>::iterator it = std::find(aps.begin(), aps.end(), d);
+			if (it != aps.end()) {
+				aps.erase(it);
+			}
+		}
+			break;
+		case D2D_ROLE_STARTCLIENT:
+		case D2D_ROLE_JOINAP:
+		case D2D_ROLE_CLIENT:
+			numClients[roleArg[d]]--;
+			break;
+	}
+}
+
+void d2dMatchingHeuristic::joinAPs(int64_t t, bool apDevices) {
+	//S_StartClient not allowed if the join process cannot be completed (C30)
+	if (t >= numT - opt->settings.kappa_startClient - 1) {
+		return;
+	}
+
+	for (uint32_t d = 0; d<numDev; d++) {
+		if (!mayChangeRole(d) || (role[d] == D2D_ROLE_AP) != apDevices) {
+			continue;
+		}
+
+		int64_t bestAP = -1;
+		double bestUtility = 0.0;
+		for (uint32_t c = 0; c<numChan; c++) {
+			for (uint32_t i = 0; i<channelAPs[c].size(); i++) {
+				uint32_t d_ap = channelAPs[c][i];
+				if (d_ap == d || (role[d] == D2D_ROLE_CLIENT && roleArg[d] == d_ap)) {
+					continue;
+				}
+				candidate cand;
+				if (role[d_ap] == D2D_ROLE_AP) {
+					if (bestExchange(d, d_ap, c, t + joinSlots + 1, cand) && cand.utility > bestUtility) {
+						bestAP 		= d_ap;
+						bestUtility = cand.utility;
+					}
+				} else {
+					//the AP is not ready yet, the device waits for it instead of starting an AP itself
+					int64_t tReady = roleStart[d_ap] + switchSlots + 1;
+					if (tReady < numT - opt->settings.kappa_startClient - 1 && bestExchange(d, d_ap, c, tReady + joinSlots + 1, cand)) {
+						reserved[d] = 1;
+					}
+				}
+			}
+		}
+
+		if (bestAP >= 0) {
+			leaveRole(d);
+			role[d] 		= D2D_ROLE_STARTCLIENT;
+			roleArg[d] 		= bestAP;
+			roleStart[d] 	= t;
+			decided[d] 		= 1;
+			numClients[bestAP]++;
+		}
+	}
+}
+
+int64_t d2dMatchingHeuristic::conflictingAP(uint32_t d, uint32_t c) {
+	int64_t result = -1;
+	for (uint32_t i = 0; i<channelAPs[c].size(); i++) {
+		uint32_t e = channelAPs[c][i];
+		if (e == d || opt->apConflict(e, d, c)) {
+			if (result >= 0) {
+				return -2;
+			}
+			result = e;
+		}
+	}
+	return result;
+}
+
+bool d2dMatchingHeuristic::channelAvailable(uint32_t d, uint32_t c) {
+	if (opt->W[d][c] == 0) {
+		return false;
+	}
+	//the channel is free or its AP has no other client than d and gives up its role
+	int64_t owner = conflictingAP(d, c);
+	if (owner == -1) {
+		return true;
+	}
+	if (owner < 0 || owner == d || role[owner] != D2D_ROLE_AP || !settled[owner] || decided[owner]) {
+		return false;
+	}
+	bool onlyClient = role[d] == D2D_ROLE_CLIENT && roleArg[d] == owner && numClients[owner] == 1;
+	return numClients[owner] == 0 || onlyClient;
+}
+
+void d2dMatchingHeuristic::apScores(uint32_t d, int64_t t, std::vector<double> &scores) {
+	for (uint32_t i = 0; i<touched.size(); i++) {
+		for (uint32_t c = 0; c<numChan; c++) {
+			gain[touched[i] * numChan + c] = 0.0;
+		}
+	}
+	touched.clear();
+	scores.assign(numChan, 0.0);
+
+	//the first clients can join once the AP is ready
+	int64_t tJoin = t + switchSlots + 1;
+	if (tJoin >= numT - opt->settings.kappa_startClient - 1) {
+		return;
+	}
+	int64_t tReady = tJoin + joinSlots + 1;
+
+	for (int dir = 0; dir<2; dir++) {
+		std::vector<uint32_t> &contentList = dir == 0 ? heldContent[d] : wantedContent[d];
+		for (uint32_t i = 0; i<contentList.size(); i++) {
+			uint32_t n = contentList[i];
+			if (dir == 1 && !wants(d, n)) {
+				continue;
+			}
+			std::vector<uint32_t> &partners = dir == 0 ? interested[n] : holders[n];
+			for (uint32_t k = 0; k<partners.size(); k++) {
+				uint32_t e = partners[k];
+				if (e == d || !mayChangeRole(e) || reserved[e] || (dir == 0 && !wants(e, n)) || !opt->W.intersects(d, opt->W, e)) {
+					continue;
+				}
+				uint32_t d_prv = dir == 0 ? d : e;
+				uint32_t d_cns = dir == 0 ? e : d;
+				double utility = weighted(d_prv, d_cns, n, opt->U[d_prv][d_cns][n]);
+				if (utility <= 0.0) {
+					continue;
+				}
+				for (uint32_t c = 0; c<numChan; c++) {
+					double &g = gain[e * numChan + c];
+					if (utility <= g || isChannelAP(e, c) || opt->W[d][c] == 0 || opt->W[e][c] == 0 ||
+						!opt->exchangeFits(d_prv, d_cns, n, c, tReady)) {
+						continue;
+					}
+					if (g == 0.0) {
+						scores[c] += utility;
+					} else {
+						scores[c] += utility - g;
+					}
+					g = utility;
+				}
+				touched.push_back(e);
+			}
+		}
+	}
+}
+
+void d2dMatchingHeuristic::startAPs(int64_t t) {
+	//S_StartAP not allowed if start AP cannot be finished in the super slot (C22)
+	if (t >= numT - opt->settings.kappa_startAP - 1) {
+		return;
+	}
+
+	//with channel reuse an AP may be started on a channel next to non-interfering APs
+	bool anyChannel = opt->channelReuse;
+	for (uint32_t c = 0; c<numChan && !anyChannel; c++) {
+		anyChannel = channelAPs[c].empty() || (role[channelAPs[c][0]] == D2D_ROLE_AP && numClients[channelAPs[c][0]] <= 1);
+	}
+	if (!anyChannel) {
+		return;
+	}
+
+	// Lazy greedy: the score of an AP candidate only decreases once other APs reserved its clients,
+	// a candidate is accepted if its updated score is still at least the best remaining score.
+	// At most one AP per channel (or per set of interfering APs with channel reuse) can be started, only the devices with the most potential partners
+	// (number of interested devices / providers of their content) are evaluated exactly.
+	std::vector< std::pair<uint64_t, uint32_t> > proxy;
+	for (uint32_t d = 0; d<numDev; d++) {
+		if (!mayChangeRole(d) || reserved[d]) {
+			continue;
+		}
+		uint64_t partners = 0;
+		for (uint32_t i = 0; i<heldContent[d].size(); i++) {
+			partners += interested[heldContent[d][i]].size();
+		}
+		for (uint32_t i = 0; i<wantedContent[d].size(); i++) {
+			partners += holders[wantedContent[d][i]].size();
+		}
+		if (partners > 0) {
+			proxy.push_back(std::make_pair(partners, d));
+		}
+	}
+	uint32_t numCandidates = std::min<uint64_t>(proxy.size(), numChan * D2D_MATCHING_AP_CANDIDATES_PER_CHANNEL);
+	std::partial_sort(proxy.begin(), proxy.begin() + numCandidates, proxy.end(), compareProxy);
+
+	std::vector<apCandidate> heap;
+	std::vector<double> scores;
+	for (uint32_t i = 0; i<numCandidates; i++) {
+		uint32_t d = proxy[i].second;
+		apScores(d, t, scores);
+		for (uint32_t c = 0; c<numChan; c++) {
+			if (scores[c] > 0.0 && channelAvailable(d, c)) {
+				heap.push_back(apCandidate(scores[c], d, c));
+			}
+		}
+	}
+	std::make_heap(heap.begin(), heap.end());
+
+	while (!heap.empty()) {
+		apCandidate best = heap.front();
+		std::pop_heap(heap.begin(), heap.end());
+		heap.pop_back();
+
+		if (!mayChangeRole(best.d) || reserved[best.d] || !channelAvailable(best.d, best.c)) {
+			continue;
+		}
+		apScores(best.d, t, scores);
+		best.score = scores[best.c];
+		if (best.score <= 0.0) {
+			continue;
+		}
+		if (!heap.empty() && best < heap.front()) {
+			heap.push_back(best);
+			std::push_heap(heap.begin(), heap.end());
+			continue;
+		}
+
+		//devices that will join the new AP are not considered for other APs in this slot
+		for (uint32_t i = 0; i<touched.size(); i++) {
+			if (gain[touched[i] * numChan + best.c] > 0.0) {
+				reserved[touched[i]] = 1;
+			}
+		}
+
+		leaveRole(best.d);
+		int64_t owner = conflictingAP(best.d, best.c);
+		if (owner >= 0) {
+			leaveRole(owner);
+			role[owner] 		= D2D_ROLE_STARTAP;
+			roleStart[owner] 	= t;
+			parked[owner] 		= 1;
+			decided[owner] 		= 1;
+		}
+		role[best.d] 			= D2D_ROLE_STARTAP;
+		roleArg[best.d] 		= best.c;
+		roleStart[best.d] 		= t;
+		decided[best.d] 		= 1;
+		channelAPs[best.c].push_back(best.d);
+	}
+}
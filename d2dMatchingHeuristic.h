@@ -0,0 +1,172 @@
+#ifndef D2DMATCHINGHEURISTIC_H
+#define D2DMATCHINGHEURISTIC_H
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// number of AP candidates per channel that are evaluated exactly in each time slot
+#define D2D_MATCHING_AP_CANDIDATES_PER_CHANNEL 16
+
+// Polynomial scheduling mode without solver. The time slots are processed in order, in each slot
+//  - the exchanges between APs and their connected clients form a matching, every device takes part
+//    in at most one exchange (PrvOnlyOneConsumer, CnsServedByOnePrv, half-duplex). The feasible
+//    exchanges are added greedily by utility, skipping exchanges that would cause interference.
+//    Each client is connected to a single AP, so without interference the matching is optimal.
+//  - devices without a possible exchange in their current role join an AP they can exchange
+//    content with, or start an AP on a free channel if other devices would join it.
+// With airtime sharing a provider serves further clients while the airtime shares of its
+// exchanges fit into each time slot, so APs can serve several clients with short transfers at once.
+// With multicast a transmission of an AP to one client is extended to all other idle clients of
+// the AP that want the content, as long as it fits into the superslot at the slowest rate.
+// APs with clients keep their role. A device that gives up its AP role stays in S_SwitchAP for the
+// rest of the superslot, which releases the channel.
+// Optional weights scale the utility by which exchanges and roles are chosen (d2dLPRounding), the
+// utility of the schedule is not weighted.
+class d2dMatchingHeuristic {
+
+	public:
+		d2dOptimizer *opt;
+
+		// weights[(d_prv * numDev + d_cns) * numCont + n], empty = 1 for all exchanges
+		std::vector<double> weights;
+
+		d2dMatchingHeuristic(d2dOptimizer *opt);
+
+		// computes a schedule for the instance of opt
+		void run(d2dSchedule &schedule);
+
+	private:
+		struct candidate {
+			uint32_t d_prv;
+			uint32_t d_cns;
+			uint32_t n;
+			uint32_t c;
+			double utility;
+		};
+
+		static bool compareCandidates(const candidate &a, const candidate &b);
+		static bool compareProxy(const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b);
+
+		struct apCandidate {
+			double score;
+			uint32_t d;
+			uint32_t c;
+
+			apCandidate(double score, uint32_t d, uint32_t c) {
+				this->score = score;
+				this->d 	= d;
+				this->c 	= c;
+			}
+
+			// max-heap order, ties are broken by the lower device and channel index
+			bool operator<(const apCandidate &other) const {
+				if (score != other.score) {
+					return score < other.score;
+				}
+				if (d != other.d) {
+					return d > other.d;
+				}
+				return c > other.c;
+			}
+		};
+
+		uint32_t numDev;
+		uint32_t numChan;
+		uint32_t numCont;
+		int64_t numT;
+
+		// number of S_SwitchAP / S_JoinAP slots, at least one slot is required by the state transitions
+		int64_t switchSlots;
+		int64_t joinSlots;
+
+		// role in the current time slot and the slot in which S_StartAP / S_StartClient was entered
+		std::vector<uint8_t> role;
+		std::vector<uint32_t> roleArg;
+		std::vector<int64_t> roleStart;
+		// device gave up its AP role and stays in S_SwitchAP
+		std::vector<char> parked;
+
+		// first time slot in which the device is not exchanging content
+		std::vector<int64_t> busyUntil;
+		// airtime[d * numT + t] share of slot t used by d as provider, only with airtime sharing
+		std::vector<double> airtime;
+		// connected and joining clients per AP
+		std::vector<uint32_t> numClients;
+		// devices in S_StartAP, S_SwitchAP or S_AP per channel, at most one without channel reuse
+		std::vector< std::vector<uint32_t> > channelAPs;
+
+		// holds[d * numCont + n] content available in the current slot, incoming: exchange scheduled
+		std::vector<char> holds;
+		std::vector<char> incoming;
+		// storage left per device for received content, -1 = unlimited
+		std::vector<int64_t> storage;
+		std::vector< std::vector<uint32_t> > heldContent;
+		// content a device is interested in and does not hold initially
+		std::vector< std::vector<uint32_t> > wantedContent;
+		// devices holding / interested in (and not initially holding) content n
+		std::vector< std::vector<uint32_t> > holders;
+		std::vector< std::vector<uint32_t> > interested;
+
+		// running exchanges, indices into schedule.exchanges
+		std::vector<uint32_t> active;
+		// devices causing interference as transmitter / receiver
+		std::vector<char> interferer;
+		std::vector<char> victim;
+
+		// per slot decision state, settled: not exchanging and no role change in progress
+		std::vector<char> settled;
+		std::vector<char> stale;
+		std::vector<char> decided;
+		std::vector<char> reserved;
+		// gain[e * numChan + c] utility of client e for the evaluated AP candidate on channel c
+		std::vector<double> gain;
+		std::vector<uint32_t> touched;
+
+		void init(d2dSchedule &schedule);
+
+		static bool stableRole(uint8_t role) {
+			return role == D2D_ROLE_IDLE || role == D2D_ROLE_AP || role == D2D_ROLE_CLIENT;
+		}
+
+		// stale device that has not changed its role in this slot, APs keep their role while they have clients
+		bool mayChangeRole(uint32_t d) {
+			return stale[d] && !decided[d] && (role[d] != D2D_ROLE_AP || numClients[d] == 0);
+		}
+
+		// utility of the exchange for the decisions of the heuristic
+		double weighted(uint32_t d_prv, uint32_t d_cns, uint32_t n, double utility) {
+			return weights.empty() ? utility : utility * weights[((uint64_t)d_prv * numDev + d_cns) * numCont + n];
+		}
+
+		bool wants(uint32_t d, uint32_t n) {
+			return opt->I[d][n] == 1 && !holds[d * numCont + n] && !incoming[d * numCont + n] && 
+				(storage[d] < 0 || storage[d] >= opt->S[n]);
+		}
+
+		// best exchange between devices a and b in either direction on channel c starting in slot t
+		bool bestExchange(uint32_t a, uint32_t b, uint32_t c, int64_t t, candidate &best);
+		// cand interferes with one of the active exchanges, which all overlap with the current slot
+		bool interferes(const d2dSchedule &schedule, const candidate &cand);
+		// the provider of cand is idle or, with airtime sharing, only sending and has airtime left
+		bool canSend(const candidate &cand, int64_t t);
+
+		void finishExchanges(d2dSchedule &schedule, int64_t t);
+		void matchExchanges(d2dSchedule &schedule, int64_t t);
+		// multicast, adds the other clients of the AP group[0].d_prv that want the content to the
+		// transmission of group[0], returns the duration at the rate of the slowest receiver
+		int64_t addReceivers(const d2dSchedule &schedule, std::vector<candidate> &group, int64_t t);
+		void joinAPs(int64_t t, bool apDevices);
+		void startAPs(int64_t t);
+		// device d may start an AP on channel c in the current slot
+		bool channelAvailable(uint32_t d, uint32_t c);
+		// AP on channel c that excludes an AP of device d on c, -1 if none, -2 if several
+		int64_t conflictingAP(uint32_t d, uint32_t c);
+		bool isChannelAP(uint32_t d, uint32_t c) {
+			return std::find(channelAPs[c].begin(), channelAPs[c].end(), d) != channelAPs[c].end();
+		}
+		// utility of the devices that could join if d starts an AP in slot t, per channel
+		void apScores(uint32_t d, int64_t t, std::vector<double> &scores);
+		void leaveRole(uint32_t d);
+};
+
+#endif
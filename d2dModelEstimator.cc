@@ -0,0 +1,287 @@
+#include "d2dModelEstimator.h"
+#include "d2dLagrangian.h"
+
+d2dModelEstimator::d2dModelEstimator(d2dOptimizer *opt) {
+	this->opt 		= opt;
+	bytesPerVar 	= D2D_EST_BYTES_PER_VAR;
+	bytesPerRow 	= D2D_EST_BYTES_PER_ROW;
+	bytesPerNonzero = D2D_EST_BYTES_PER_NONZERO;
+	buildRate 		= 2e7;
+	solveRate 		= 1e5;
+	memoryBudget 	= opt->memoryBudget * 1024.0 * 1024.0;
+	timeBudget 		= opt->timeLimit;
+	minIterations 	= 5;
+	numClusters 	= 0;
+}
+
+d2dModelSize d2dModelEstimator::estimate() {
+	std::vector<uint32_t> devices(opt->deviceVector.size());
+	for (uint32_t d = 0; d<devices.size(); d++) {
+		devices[d] = d;
+	}
+	return estimate(devices);
+}
+
+d2dModelSize d2dModelEstimator::estimate(const std::vector<uint32_t> &devices) {
+	uint64_t K 		= devices.size();
+	uint64_t C 		= opt->channelVector.size();
+	uint64_t N 		= opt->contentVector.size();
+	int64_t T 		= opt->settings.numTimeSlots;
+	int64_t kA 		= opt->settings.kappa_startAP;
+	int64_t kC 		= opt->settings.kappa_startClient;
+	uint64_t T1 	= std::max<int64_t>(T - 1, 0);
+	uint64_t nt 	= opt->useTemplate ? 0 : 1;
+	opt->updateInterferenceList();
+	if (opt->multicast) {
+		opt->computeMulticastRates();
+	}
+	uint64_t R = opt->multicast ? opt->multicastRates.size() : 0;
+	std::vector<char> member(opt->deviceVector.size(), 0);
+	for (uint32_t i = 0; i<K; i++) {
+		member[devices[i]] = 1;
+	}
+
+	d2dModelSize size;
+	size.vars = 2 * K * K * N * C * T + 5 * K * C * T + K * N * T + K * T + 3 * K * K * T + K * N * C * T * R;
+	auto family = [&](uint64_t rows, uint64_t nonzeros) {
+		size.rows 				+= rows;
+		size.nonzeros 			+= nonzeros;
+		size.maxFamilyNonzeros 	= std::max(size.maxFamilyNonzeros, nonzeros);
+	};
+
+	//C1, C2, C3 and C4 - C11 (with C8 and the deadlines) by link
+	uint64_t rows1 = 0, rows3 = K * N * T1, nz3 = 2 * K * N * T1, rows4 = 0, nz4 = 0;
+	for (uint32_t i = 0; i<K; i++) {
+		uint32_t d = devices[i];
+		for (uint32_t n = 0; n<N; n++) {
+			rows1 += nt * (opt->P[d][n] == 1 ? T : 1);
+		}
+	}
+	for (uint32_t i = 0; i<K; i++) {
+		uint32_t d_prv = devices[i];
+		for (uint32_t j = 0; j<K; j++) {
+			uint32_t d_cns = devices[j];
+			for (uint32_t c = 0; c<C; c++) {
+				rows4 	+= N * T * (3 + nt);
+				nz4 	+= N * T * (4 + nt);
+				long link = opt->L[d_prv][d_cns][c];
+				if (link <= 0) {
+					continue;
+				}
+				for (uint32_t n = 0; n<N; n++) {
+					int64_t duration = opt->exchangeDuration(d_prv, d_cns, n, c);
+					if (!opt->multicast) {
+						nz3 += std::max<int64_t>(T - std::max<int64_t>(1, duration), 0);
+					} else {
+						int64_t lastDuration = -1;
+						for (uint32_t k = 0; k<R && opt->multicastRates[k] <= link; k++) {
+							int64_t rateDuration = opt->multicastDuration(n, k);
+							if (rateDuration != lastDuration) {
+								nz3 += std::max<int64_t>(T - std::max<int64_t>(1, rateDuration), 0);
+							}
+							lastDuration = rateDuration;
+						}
+					}
+					uint64_t fit = std::max<int64_t>(T - duration + 1, 0);
+					rows4 	+= 3 * duration * fit + T;
+					nz4 	+= 6 * duration * fit + T;
+					if (opt->D[d_cns][n] >= 0) {
+						uint64_t late = T - std::min<int64_t>(std::max<int64_t>(opt->D[d_cns][n] - duration + 1, 0), T);
+						rows4 	+= late;
+						nz4 	+= late;
+					}
+				}
+			}
+		}
+	}
+	family(rows1, rows1);
+	family(rows3, nz3);
+	family(rows4, nz4);
+
+	//C12
+	family(K * T, 2 * C * K * T);
+
+	//storage
+	uint64_t rowsStorage = 0, nzStorage = 0;
+	for (uint32_t i = 0; i<K; i++) {
+		uint32_t d = devices[i];
+		if (opt->freeStorage(d) < 0) {
+			continue;
+		}
+		rowsStorage++;
+		nzStorage += (opt->useTemplate ? N : opt->I.countAndNot(d, opt->P, d)) * K * C * T;
+	}
+	family(rowsStorage, nzStorage);
+
+	//C13
+	family(K * N, K * N * K * C * T);
+
+	//C14 or the multicast transmissions
+	if (!opt->multicast) {
+		family(K * T, K * T * K * N * C);
+	} else {
+		uint64_t nzOne = 0, rowsMC = 0, nzMC = 0;
+		for (uint32_t n = 0; n<N; n++) {
+			for (uint32_t k = 0; k<R; k++) {
+				int64_t duration = opt->multicastDuration(n, k);
+				for (int64_t t = 0; t<T; t++) {
+					nzOne 	+= std::min<int64_t>(duration, t + 1);
+					rowsMC 	+= opt->multicastFits(n, k, t) ? duration : 1;
+					nzMC 	+= opt->multicastFits(n, k, t) ? 2 * duration : 1;
+				}
+			}
+		}
+		family(K * T, K * C * nzOne);
+		rowsMC 	*= K * C;
+		nzMC 	*= K * C;
+		for (uint32_t i = 0; i<K; i++) {
+			uint32_t d_prv = devices[i];
+			for (uint32_t j = 0; j<K; j++) {
+				uint32_t d_cns = devices[j];
+				for (uint32_t c = 0; c<C; c++) {
+					long link = opt->L[d_prv][d_cns][c];
+					if (link <= 0) {
+						continue;
+					}
+					for (uint32_t n = 0; n<N; n++) {
+						int64_t pairDuration = opt->exchangeDuration(d_prv, d_cns, n, c);
+						for (int64_t t = 0; t<T; t++) {
+							//MC3, MC4 and MC5
+							rowsMC++;
+							nzMC++;
+							for (uint32_t k = 0; k<R && opt->multicastRates[k] <= link; k++) {
+								int64_t duration = opt->multicastDuration(n, k);
+								nzMC += opt->meetsDeadline(d_cns, n, t + duration) ? 1 : 0;
+								if (opt->multicastRates[k] < link && t + duration <= T) {
+									uint64_t slots = std::max<int64_t>(duration - pairDuration, 0);
+									rowsMC 	+= 3 * slots;
+									nzMC 	+= 9 * slots;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+		family(rowsMC, nzMC);
+	}
+
+	//C15
+	family(K * T, K * T * K * N * C);
+
+	//C16 and C36 with channel reuse by interference pair
+	uint64_t interferencePairs = 0, apPairs = 0;
+	for (uint32_t i = 0; i<K; i++) {
+		uint32_t d = devices[i];
+		for (uint32_t c = 0; c<C; c++) {
+			const std::vector< std::pair<uint32_t, uint32_t> > &receivers = opt->interferenceList[d * C + c];
+			for (uint32_t r = 0; r<receivers.size(); r++) {
+				uint32_t d_int = receivers[r].first;
+				if (!member[d_int]) {
+					continue;
+				}
+				interferencePairs++;
+				if (receivers[r].second == c && !(d_int < d && opt->X[d_int][c][d][c] == 1)) {
+					apPairs++;
+				}
+			}
+		}
+	}
+	family(interferencePairs * T, interferencePairs * T * (2 + N));
+
+	//C17 - C19
+	family(K * T, K * T * (1 + 3 * C + 3 * K));
+	family(K * nt + K * T1, K * nt + 2 * K * T1);
+
+	//C20 - C27 per device and channel
+	uint64_t startAP 	= std::max<int64_t>(T - kA - 2, 0);
+	uint64_t noStartAP 	= T - std::max<int64_t>(T - kA - 1, 0);
+	uint64_t switchAP 	= std::max<int64_t>(T - kA - 1, 0);
+	family(K * C * (nt + startAP + noStartAP), K * C * (nt + startAP * (2 + C + K) + noStartAP));
+	family(K * C * (1 + switchAP + T1), K * C * (2 + switchAP * (kA + 2) + 3 * T1));
+	family(K * C * (nt + T1), K * C * (nt + 3 * T1));
+
+	//C28 - C35 per device and AP
+	uint64_t startClient 	= std::max<int64_t>(T - kC - 2, 0);
+	uint64_t noStartClient 	= T - std::max<int64_t>(T - kC - 1, 0);
+	uint64_t joinAP 		= std::max<int64_t>(T - kC - 1, 0);
+	family(K * K * (nt + startClient + noStartClient), K * K * (nt + startClient * (2 + C + K) + noStartClient));
+	family(K * K * (1 + joinAP + T1), K * K * (2 + joinAP * (kC + 2) + 3 * T1));
+	family(K * K * (nt + T1), K * K * (nt + 3 * T1));
+
+	//C36
+	if (!opt->channelReuse) {
+		family(C * T, C * T * K);
+	} else {
+		family(apPairs * T, 2 * apPairs * T);
+	}
+
+	//C36 - C41 client states
+	family(3 * K * K * T, 3 * K * K * T * (1 + C));
+	family(3 * K * T, 3 * K * T);
+
+	//C42, with channelReuse a second row requiring a client of the other device
+	uint64_t connectRows = opt->channelReuse ? 2 : 1;
+	family(connectRows * K * K * N * C * T, (2 + 3 * connectRows) * K * K * N * C * T);
+
+	//the constraint buffers of all threads hold up to D2D_CONSTR_FLUSH_TERMS terms before they are flushed
+	uint64_t bufferTerms = std::min<uint64_t>(size.maxFamilyNonzeros, D2D_CONSTR_FLUSH_TERMS);
+	size.bytes = size.vars * bytesPerVar + size.rows * bytesPerRow + size.nonzeros * bytesPerNonzero + bufferTerms * D2D_EST_BYTES_PER_TERM;
+	size.bytes += (opt->setVariableNames ? size.vars : 0) * D2D_EST_BYTES_PER_NAME;
+	size.bytes += (opt->setConstraintNames ? size.rows : 0) * D2D_EST_BYTES_PER_NAME;
+	size.buildSeconds = size.nonzeros / buildRate;
+	size.solveSeconds = size.nonzeros / solveRate;
+	return size;
+}
+
+int32_t d2dModelEstimator::selectMode() {
+	model = estimate();
+	print(cout, "Model estimate", model);
+	bool fits 		= memoryBudget <= 0.0 || model.bytes <= memoryBudget;
+	bool inTime 	= timeBudget <= 0.0 || model.buildSeconds + model.solveSeconds <= timeBudget;
+	if (fits && inTime) {
+		cout << "Selected mode: MIP" << endl;
+		return D2D_MODE_MIP;
+	}
+
+	//all clusters are built before the iterations, each iteration solves them on buildThreads() workers
+	std::vector< std::vector<uint32_t> > clusters;
+	d2dLagrangian::linkClusters(opt, opt->maxClusterSize, clusters);
+	numClusters 	= clusters.size();
+	clusterModels 	= d2dModelSize();
+	largestCluster 	= d2dModelSize();
+	for (uint32_t k = 0; k<clusters.size(); k++) {
+		d2dModelSize cluster = estimate(clusters[k]);
+		clusterModels.vars 			+= cluster.vars;
+		clusterModels.rows 			+= cluster.rows;
+		clusterModels.nonzeros 		+= cluster.nonzeros;
+		clusterModels.bytes 		+= cluster.bytes;
+		clusterModels.buildSeconds 	+= cluster.buildSeconds;
+		clusterModels.solveSeconds 	+= cluster.solveSeconds;
+		if (cluster.nonzeros >= largestCluster.nonzeros) {
+			largestCluster = cluster;
+		}
+	}
+	if (numClusters > 1) {
+		std::stringstream label;
+		label << numClusters << " clusters";
+		print(cout, label.str(), clusterModels);
+		double iteration = std::max(largestCluster.solveSeconds, clusterModels.solveSeconds / std::max<uint32_t>(opt->buildThreads(), 1));
+		if ((memoryBudget <= 0.0 || clusterModels.bytes <= memoryBudget) &&
+			(timeBudget <= 0.0 || clusterModels.buildSeconds + minIterations * iteration <= timeBudget)) {
+			cout << "Selected mode: Lagrangian decomposition" << endl;
+			return D2D_MODE_LAGRANGIAN;
+		}
+	}
+	if (fits) {
+		cout << "Selected mode: LNS" << endl;
+		return D2D_MODE_LNS;
+	}
+	cout << "Selected mode: matching heuristic" << endl;
+	return D2D_MODE_MATCHING;
+}
+
+void d2dModelEstimator::print(ostream &out, const std::string &label, const d2dModelSize &size) {
+	out << label << ": " << size.vars << " variables, " << size.rows << " constraints, " << size.nonzeros << " nonzeros, "
+		<< size.bytes / (1024.0 * 1024.0) << " MB, build ~" << size.buildSeconds << " s, solve ~" << size.solveSeconds << " s" << endl;
+}
@@ -0,0 +1,80 @@
+#ifndef D2DMODELESTIMATOR_H
+#define D2DMODELESTIMATOR_H
+
+#include "d2dOptimizer.h"
+
+// approximate memory of the solver per variable, row and nonzero of the model including the working
+// copies of presolve and the LP, and of the optimizer per variable (bounds and solution)
+#define D2D_EST_BYTES_PER_VAR 		96
+#define D2D_EST_BYTES_PER_ROW 		64
+#define D2D_EST_BYTES_PER_NONZERO 	40
+// bytes per term in d2dConstraintBuffer (d2dVar and coefficient)
+#define D2D_EST_BYTES_PER_TERM 		16
+// bytes per name with setVariableNames / setConstraintNames
+#define D2D_EST_BYTES_PER_NAME 		64
+
+// size of a model as buildModel() would create it
+struct d2dModelSize {
+	uint64_t vars;
+	uint64_t rows;
+	uint64_t nonzeros;
+	// terms of the largest constraint family, which bounds the constraint buffers
+	uint64_t maxFamilyNonzeros;
+	// approximate peak memory of build and solve
+	double bytes;
+	double buildSeconds;
+	double solveSeconds;
+
+	d2dModelSize() : vars(0), rows(0), nonzeros(0), maxFamilyNonzeros(0), bytes(0.0), buildSeconds(0.0), solveSeconds(0.0) {}
+};
+
+// Predicts the size of the model of the loaded instance without building it. The variable counts
+// follow from the dimensions of the variable blocks, rows and nonzeros are counted per constraint
+// family with the same conditions as buildModel() (links, content sizes, deadlines, interference
+// and the model options), in time linear in the number of y variables divided by the time slots.
+// The multicast families are counted with the rate classes of the whole instance.
+// selectMode() picks the scheduling mode for D2D_MODE_AUTO against the memory and time budgets:
+// the full MIP if it fits both, otherwise d2dLagrangian if the models of all clusters fit the memory
+// and allow minIterations iterations in time, otherwise d2dLNS if the full model fits the memory,
+// otherwise d2dMatchingHeuristic. Times are rough predictions from the nonzeros with the rates below,
+// which depend on the machine and the solver parameters.
+class d2dModelEstimator {
+
+	public:
+		d2dOptimizer *opt;
+
+		double bytesPerVar;
+		double bytesPerRow;
+		double bytesPerNonzero;
+		// nonzeros per second of buildModel() and of solving the MIP to the default gap
+		double buildRate;
+		double solveRate;
+
+		// bytes, opt->memoryBudget by default, 0 = unlimited
+		double memoryBudget;
+		// seconds, opt->timeLimit by default, 0 = unlimited
+		double timeBudget;
+		// subgradient iterations d2dLagrangian has to reach within timeBudget
+		uint32_t minIterations;
+
+		// results of the last selectMode()
+		d2dModelSize model;
+		// sum over the clusters of d2dLagrangian and its largest cluster
+		d2dModelSize clusterModels;
+		d2dModelSize largestCluster;
+		uint32_t numClusters;
+
+		d2dModelEstimator(d2dOptimizer *opt);
+
+		// model of the whole instance
+		d2dModelSize estimate();
+		// model of the sub-instance of the given devices (in increasing order), as extracted by d2dLagrangian
+		d2dModelSize estimate(const std::vector<uint32_t> &devices);
+
+		// D2D_MODE_MIP, D2D_MODE_LAGRANGIAN, D2D_MODE_LNS or D2D_MODE_MATCHING
+		int32_t selectMode();
+
+		void print(ostream &out, const std::string &label, const d2dModelSize &size);
+};
+
+#endif
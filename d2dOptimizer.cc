@@ -1,4 +1,12 @@
 #include "d2dOptimizer.h"
+#include "d2dMatchingHeuristic.h"
+#include "d2dLNS.h"
+#include "d2dPortfolio.h"
+#include "d2dLPRounding.h"
+#include "d2dLagrangian.h"
+#include "d2dModelEstimator.h"
+#include "d2dValidator.h"
+#include "d2dSolutionCache.h"
 
 std::vector<std::string> split_string(const std::string& str,
                                       const std::string& delimiter,
@@ -23,7 +31,51 @@ std::vector<std::string> split_string(const std::string& str,
     return strings;
 }
 
-d2dOptimizer::d2dOptimizer() {
+// Splits [0, count) into one contiguous range per thread and runs fn(begin, end, threadIndex) for each range.
+// Exceptions thrown by a worker are rethrown in the calling thread.
+static void runParallel(uint32_t count, uint32_t numThreads, const std::function<void(uint32_t, uint32_t, uint32_t)> &fn) {
+	if (count == 0) {
+		return;
+	}
+	numThreads = std::max<uint32_t>(1, std::min(numThreads, count));
+	if (numThreads == 1) {
+		fn(0, count, 0);
+		return;
+	}
+	
+	uint32_t rangeSize = (count + numThreads - 1) / numThreads;
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(numThreads);
+	for (uint32_t i = 0; i<numThreads; i++) {
+		uint32_t begin	= i * rangeSize;
+		uint32_t end	= std::min(count, begin + rangeSize);
+		if (begin >= end) {
+			break;
+		}
+		workers.push_back(std::thread([&fn, &errors, begin, end, i]() {
+			try {
+				fn(begin, end, i);
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+		}));
+	}
+	for (uint32_t i = 0; i<workers.size(); i++) {
+		workers[i].join();
+	}
+	for (uint32_t i = 0; i<errors.size(); i++) {
+		if (errors[i]) {
+			std::rethrow_exception(errors[i]);
+		}
+	}
+}
+
+d2dOptimizer::d2dOptimizer() : d2dOptimizer(createDefaultBackend()) {
+}
+
+d2dOptimizer::d2dOptimizer(d2dSolverBackend *backend) {
+	
+	this->backend = backend;
 
 	settings.numTimeSlots 		= 10;
 	settings.tau 				= 10.0;
@@ -37,42 +89,45 @@ d2dOptimizer::d2dOptimizer() {
 	setVariableNames 	= false;
 	setConstraintNames 	= false;
 	
-	P 	= NULL;
-	I 	= NULL;
-	W	= NULL;
+	numThreads = std::thread::hardware_concurrency();
+	
+	mode				= D2D_MODE_MIP;
+	useMatchingStart 	= false;
+	timeLimit			= 0.0;
+	validateSchedule	= true;
+	solutionCache		= NULL;
+	maxClusterSize		= 0;
+	memoryBudget		= 0.0;
+	useTemplate			= false;
+	templateBuilt		= false;
+	builtShape			= 0;
+	channelReuse		= false;
+	multicast			= false;
+	airtimeSharing		= false;
+	utilityDecay		= D2D_DECAY_NONE;
+	decayRate			= 0.0;
+	decaySlot			= 0;
+	parameterFile		= D2D_PARAMETER_FILE;
+	
 	L	= NULL;
 	S	= NULL;
 	X	= NULL;
 	U	= NULL;
+	D	= NULL;
 
 	START_Idle		= NULL;
 	START_AP		= NULL;  	
 	START_Client	= NULL;
-	
-	try {
-		env = new GRBEnv();
-		model = new GRBModel(*env);	
-	} catch(GRBException e) {
-		cout << "Error code = " << e.getErrorCode() << endl;
-		cout << e.getMessage() << endl;
-		exit(-1);
-	} catch (...) {
-		cout << "Error in constructor" << endl;
-		exit(-1);
-	}
+
 }
 
 
 d2dOptimizer::~d2dOptimizer() {
 
 	for (uint32_t d = 0; d<deviceVector.size(); d++) {
-		if (P != NULL &&
-			P[d] != NULL) 
-			delete [] P[d];
-			
-		if (I != NULL && 
-			I[d] != NULL) 
-			delete []  I[d];
+		if (D != NULL && 
+			D[d] != NULL) 
+			delete []  D[d];
 		
 		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {
 			if (L != NULL && 
@@ -112,18 +167,10 @@ d2dOptimizer::~d2dOptimizer() {
 		if (X != NULL && 
 			X[d] != NULL)
 			delete [] X[d];
-			
-		if (W != NULL &&
-			W[d] != NULL)
-			delete [] W[d];
 	}
 	
-	if (P != NULL)
-		delete [] P;
-	if (I != NULL)
-		delete [] I;
-	if (W != NULL)
-		delete [] W;
+	if (D != NULL)
+		delete [] D;
 	if (S != NULL)
 		delete [] S;
 	if (L != NULL)
@@ -163,26 +210,30 @@ d2dOptimizer::~d2dOptimizer() {
 	} 
 	contentVector.clear();
 	
-	delete model;
-	delete env;
+	delete backend;
 }
 
 device* d2dOptimizer::getDeviceById(uint64_t id) {	
-	for (uint32_t i=0; i<deviceVector.size(); i++) {	
-		if (deviceVector.at(i)->id == id) {
-			return deviceVector.at(i);
-		}
+	int32_t index = getDeviceIndexById(id);
+	if (index < 0) {
+		return NULL;
 	}
-	return NULL;
+	return deviceVector.at(index);
 }
 
 int32_t d2dOptimizer::getDeviceIndexById(uint64_t id) {
-	for (uint32_t i=0; i<deviceVector.size(); i++) {
-		if (deviceVector.at(i)->id == id) {
-			return i;
+	//devices may also be appended to deviceVector directly
+	if (deviceIndexById.size() != deviceVector.size()) {
+		deviceIndexById.clear();
+		for (uint32_t i=0; i<deviceVector.size(); i++) {
+			deviceIndexById.insert(std::make_pair(deviceVector.at(i)->id, i));
 		}
 	}
-	return -1;
+	std::unordered_map<uint64_t, uint32_t>::const_iterator it = deviceIndexById.find(id);
+	if (it == deviceIndexById.end()) {
+		return -1;
+	}
+	return it->second;
 }
 
 channel* d2dOptimizer::getChannelById(uint64_t id) {
@@ -235,6 +286,7 @@ device* d2dOptimizer::addDevice(uint64_t id) {
 	if ((dev = getDeviceById(id)) == NULL) {
 		dev = new device(id);	
 		deviceVector.push_back(dev);
+		deviceIndexById[id] = deviceVector.size() - 1;
 	}
 	return dev;
 }
@@ -251,7 +303,7 @@ channel* d2dOptimizer::addChannel(uint64_t id) {
 void d2dOptimizer::readBasicParamters() {
 	std::string line;
 	
-	std::string fname = "channels.dat";
+	std::string fname = dataPrefix + "channels.dat";
 	std::ifstream infile(fname.c_str());
 	if (!infile.is_open()) {
 		cerr << "Cannot open " << fname << endl;
@@ -275,7 +327,7 @@ void d2dOptimizer::readBasicParamters() {
 		addChannel(tmpId);
 	}
 	
-	fname = "content.dat";
+	fname = dataPrefix + "content.dat";
 	std::ifstream contentfile(fname.c_str());
 	if (!contentfile.is_open()) {
 		cerr << "Cannot open " << fname << endl;
@@ -302,7 +354,7 @@ void d2dOptimizer::readBasicParamters() {
 		addContent(tmpId, atoi(tokens.at(1).c_str()));
 	}
 	
-	fname = "devices.dat";
+	fname = dataPrefix + "devices.dat";
 	std::ifstream devicefile(fname.c_str());
 	if (!devicefile.is_open()) {
 		cerr << "Cannot open " << fname << endl;
@@ -313,7 +365,7 @@ void d2dOptimizer::readBasicParamters() {
 			continue;
 		}
 		std::vector<std::string> tokens = split_string(line, "\t", true);		
-		if (tokens.size() != 4) {
+		if (tokens.size() != 4 && tokens.size() != 5) {
 			for (uint32_t i=0; i<tokens.size(); i++) {
 				cout << i << "\t" << tokens.at(i) << endl;
 			}
@@ -329,6 +381,10 @@ void d2dOptimizer::readBasicParamters() {
 		device *dev = NULL;
 		if ((dev = addDevice(tmpId)) == NULL)
 			return;
+		// optional storage capacity
+		if (tokens.size() == 5) {
+			dev->capacity = atol(tokens.at(4).c_str());
+		}
 		
 		// #deviceID (list of supported channel ids) (list of available content ids) (list of interested content ids)
 		std::vector<std::string> channelTokens = split_string(tokens.at(1), ",", true);	
@@ -378,20 +434,19 @@ void d2dOptimizer::readBasicParamters() {
 }
 
 void d2dOptimizer::allocateParameters() {
-	P = new int*[deviceVector.size()];
-	I = new int*[deviceVector.size()];
-	W = new int*[deviceVector.size()];
+	P.resize(deviceVector.size(), contentVector.size());
+	I.resize(deviceVector.size(), contentVector.size());
+	W.resize(deviceVector.size(), channelVector.size());
+	D = new int64_t*[deviceVector.size()];
 	S = new long[contentVector.size()];
 	L = new long**[deviceVector.size()];
 	U = new double**[deviceVector.size()];
 	X = new int***[deviceVector.size()];
 	for (uint32_t d = 0; d<deviceVector.size(); d++) {
-		P[d] = new int[contentVector.size()];
-		I[d] = new int[contentVector.size()];
+		D[d] = new int64_t[contentVector.size()];
 		
 		for (uint32_t n = 0; n<contentVector.size(); n++) {	
-			P[d][n] = 0;
-			I[d][n] = 0;	
+			D[d][n] = -1;
 		}
 		
 		U[d] = new double*[deviceVector.size()];
@@ -408,11 +463,8 @@ void d2dOptimizer::allocateParameters() {
 			}
 		}
 		
-		W[d] = new int[channelVector.size()];
 		X[d] = new int**[channelVector.size()];
 		for (uint32_t c = 0; c<channelVector.size(); c++) {	
-			W[d][c] = 0;
-			
 			X[d][c] = new int*[deviceVector.size()];
 			for (uint32_t d_int = 0; d_int<deviceVector.size(); d_int++) {
 				X[d][c][d_int] = new int[channelVector.size()];
@@ -448,7 +500,7 @@ void d2dOptimizer::allocateParameters() {
 
 void d2dOptimizer::readParameters() {
 	std::string line;
-	std::string fname = "channels.dat";
+	std::string fname = dataPrefix + "channels.dat";
 	
 	//cout << endl << "Content " << endl;
 	for (uint32_t n=0; n<contentVector.size(); n++) {
@@ -480,63 +532,14 @@ void d2dOptimizer::readParameters() {
 		//cout << endl;
 	}
 
-	fname = "interference.dat";
-	std::ifstream interference(fname.c_str());
-	if (!interference.is_open()) {
-		cerr << "Cannot open " << fname << endl;
+	bool positions = readPositions();
+	if (positions) {
+		computeLinkParameters();
+	} else if (!readInterference()) {
 		return;
 	}
-	cout << "Interference " << endl;
-	while (std::getline(interference, line)) {
-		if (line.substr(0,1) == "#") {
-			continue;
-		}
-		std::vector<std::string> tokens = split_string(line, "\t", true);		
-		if (tokens.size() !=4 ) {
-			for (uint32_t i=0; i<tokens.size(); i++) {
-				cout << i << "\t" << tokens.at(i) << endl;
-			}
-			cerr << "wrong number of tokens " << tokens.size() << " in file " << fname <<  endl;
-			cerr << line << endl;
-			return;
-		}
-		//#transmittingDeviceId transmittingChannelId receivingDeviceId interferredChannelIdList
-		
-		uint32_t txDeviceIndex = getDeviceIndexById(atol(tokens.at(0).c_str()));
-		if (txDeviceIndex < 0) {
-			cerr << "unknown txDeviceId " << endl;
-			cerr << line << endl;
-			return;
-		}
-		uint32_t txChannelIndex = getChannelIndexById(atol(tokens.at(1).c_str()));
-		if (txChannelIndex < 0) {
-			cerr << "unknown txChannelId " << endl;
-			cerr << line << endl;
-			return;
-		}
-		uint32_t rxDeviceIndex = getDeviceIndexById(atol(tokens.at(2).c_str()));
-		if (rxDeviceIndex < 0) {
-			cerr << "unknown rxDeviceId " << endl;
-			cerr << line << endl;
-			return;
-		}
-			
-		std::vector<std::string> channelTokens = split_string(tokens.at(3), ",", true);	
-		for (uint32_t i=0; i<channelTokens.size(); i++) {
-			
-			uint32_t rxChannelIndex = getChannelIndexById(atol(channelTokens.at(i).c_str()));
-			if (rxChannelIndex < 0) {
-				cerr << "unknown rxChannelId " << endl;
-				cerr << line << endl;
-				return;
-			}
-			X[txDeviceIndex][txChannelIndex][rxDeviceIndex][rxChannelIndex] = 1;
-			
-			//cout << "X[" << txDeviceIndex << "][" << txChannelIndex << "][" << rxDeviceIndex << "][" << rxChannelIndex << "]" << endl;
-		}
-	}
 	
-	fname = "utility.dat";
+	fname = dataPrefix + "utility.dat";
 	std::ifstream utilityfile(fname.c_str());
 	if (!utilityfile.is_open()) {
 		cerr << "Cannot open " << fname << endl;
@@ -581,52 +584,11 @@ void d2dOptimizer::readParameters() {
 	}
 	
 	
-	fname = "link_speed.dat";
-	std::ifstream linkspeedfile(fname.c_str());
-	if (!linkspeedfile.is_open()) {
-		cerr << "Cannot open " << fname << endl;
+	if (!positions && !readLinkSpeed()) {
 		return;
 	}
-	//cout << endl << "Link Speed " << endl;
-	while (std::getline(linkspeedfile, line)) {
-		if (line.substr(0,1) == "#") {
-			continue;
-		}
-		// #contentProvider contentConsumer contentId utilityValue
-		std::vector<std::string> tokens = split_string(line, "\t", true);		
-		if (tokens.size() != 4) {
-			for (uint32_t i=0; i<tokens.size(); i++) {
-				cout << i << "\t" << tokens.at(i) << endl;
-			}
-			cerr << "wrong number of tokens " << tokens.size() << " in file " << fname <<  endl;
-			cerr << line << endl;
-			return;
-		}
-		// #contentProvider contentConsumer  channelId linkSpeed(not present or 0=no connectivity )
-		uint32_t providerIndex = getDeviceIndexById(atol(tokens.at(0).c_str()));
-		if (providerIndex < 0) {
-			cerr << "unknown providerId " << endl;
-			cerr << line << endl;
-			return;
-		}
-		uint32_t consumerIndex = getDeviceIndexById(atol(tokens.at(1).c_str()));
-		if (consumerIndex < 0) {
-			cerr << "unknown consumerId " << endl;
-			cerr << line << endl;
-			return;
-		}
-		uint32_t channelIndex = getChannelIndexById(atol(tokens.at(2).c_str()));
-		if (channelIndex < 0) {
-			cerr << "unknown channelIndex " << endl;
-			cerr << line << endl;
-			return;
-		}
-		uint64_t speed = atol(tokens.at(3).c_str());
-		L[providerIndex][consumerIndex][channelIndex] = speed;
-		//cout << "L[" << providerIndex << "][" << consumerIndex << "][" << channelIndex << "] = " << speed << endl;
-	}
 	
-	fname = "state.dat";
+	fname = dataPrefix + "state.dat";
 	std::ifstream statefile(fname.c_str());
 	if (!statefile.is_open()) {
 		cerr << "Cannot open " << fname << endl;
@@ -720,920 +682,1826 @@ void d2dOptimizer::readParameters() {
 			}
 		}
 	}
-}
-
-void d2dOptimizer::printParameterSimple() {
-	cout << endl << "Channels " <<  channelVector.size() << endl;
-	for (uint32_t c=0; c<channelVector.size(); c++) {
-		cout << "\t" << c << " ID " << channelVector.at(c)->id << endl;
-	}
-	
-	cout << endl << "Devices " << deviceVector.size() << endl;
-	for (uint32_t d=0; d<deviceVector.size(); d++) {
-		cout << "\t" <<  d << " ID " << deviceVector.at(d)->id <<   endl;
-	}
 	
-	cout << endl << "Content " <<  contentVector.size() << endl;
-	for (uint32_t c=0; c<contentVector.size(); c++) {
-		content *cont = contentVector.at(c);
-		cout << "\t" << c << " ID " << cont->id << " Size " << cont->size <<  endl;
-	}
+	readDeadlines();
 }
 
-void d2dOptimizer::printParameter() {
-	
-	cout << endl << "Channels " <<  channelVector.size() << endl;
-	
-	cout << endl << "Content " << contentVector.size() << endl;
-	for (uint32_t n=0; n<contentVector.size(); n++) {
-		cout << "\t" << "S[" << n << "] = " << S[n] << " ID " << contentVector[n]->id << endl;
+bool d2dOptimizer::readDeadlines() {
+	std::string line;
+	std::string fname = dataPrefix + "deadline.dat";
+	std::ifstream deadlinefile(fname.c_str());
+	if (!deadlinefile.is_open()) {
+		return false;
 	}
-	
-	cout << endl << "Devices " << deviceVector.size() << endl;
-	for (uint32_t d=0; d<deviceVector.size(); d++) {
-		cout << "Device index " << d << " ID " << deviceVector[d]->id << endl;
-		for (uint32_t n=0; n<contentVector.size(); n++) {
-			if (P[d][n] == 1) {
-				cout << "\tP[" << d << "][" << n << "]" << endl;
-			}
+	while (std::getline(deadlinefile, line)) {
+		if (line.substr(0,1) == "#") {
+			continue;
 		}
-		
-		for (uint32_t n=0; n<contentVector.size(); n++) {
-			if (I[d][n] == 1) {
-				cout << "\tI[" << d << "][" << n << "]" << endl;
-			}
+		// #deviceId contentId deadlineSlot
+		std::vector<std::string> tokens = split_string(line, "\t", true);		
+		if (tokens.size() != 3) {
+			cerr << "wrong number of tokens " << tokens.size() << " in file " << fname <<  endl;
+			cerr << line << endl;
+			return false;
 		}
-		
-		for (uint32_t c=0; c<channelVector.size(); c++) {
-			if (W[d][c] == 1) {				
-				cout << "\tW[" << d << "][" << c << "]" << endl;
-			}	
+		device *dev = getDeviceById(atol(tokens.at(0).c_str()));
+		content *cont = getContentById(atol(tokens.at(1).c_str()));
+		if (dev == NULL || cont == NULL) {
+			cerr << "unknown device or content id " << endl;
+			cerr << line << endl;
+			return false;
 		}
-		cout << endl;
+		D[getDeviceIndexById(dev->id)][getContentIndexById(cont->id)] = atol(tokens.at(2).c_str());
 	}
-	
-	cout << "Interference " << endl;
-	for (uint32_t d_tx=0; d_tx<deviceVector.size(); d_tx++) {
-		for (uint32_t c_tx=0; c_tx<channelVector.size(); c_tx++) {
-			for (uint32_t d_rx=0; d_rx<deviceVector.size(); d_rx++) {
-				for (uint32_t c_rx=0; c_rx<channelVector.size(); c_rx++) {
-					if (X[d_tx][c_tx][d_rx][c_rx] == 1) {
-						cout << "\t" << "X[" << d_tx << "][" << c_tx << "][" << d_rx << "][" << c_rx << "]" << endl;
-					}
-				}
-			}	
-		}
+	return true;
+}
+
+bool d2dOptimizer::readInterference() {
+	std::string line;
+	std::string fname = dataPrefix + "interference.dat";
+	std::ifstream interference(fname.c_str());
+	if (!interference.is_open()) {
+		cerr << "Cannot open " << fname << endl;
+		return false;
 	}
-	
-	cout << endl << "Utility " << endl;
-	for (uint32_t d_prv=0; d_prv<deviceVector.size(); d_prv++) {
-		for (uint32_t d_cns=0; d_cns<deviceVector.size(); d_cns++) {
-			for (uint32_t n=0; n<contentVector.size(); n++) {
-				if (U[d_prv][d_cns][n] > 0) {
-					cout << "\t" << "U[" << d_prv << "][" << d_cns << "][" << n << "] = " << U[d_prv][d_cns][n]  << endl;	
-				}
-			}
+	cout << "Interference " << endl;
+	interferenceList.assign(deviceVector.size() * channelVector.size(), std::vector< std::pair<uint32_t, uint32_t> >());
+	while (std::getline(interference, line)) {
+		if (line.substr(0,1) == "#") {
+			continue;
 		}
-	}
-		
-	cout << endl << "Link Speed " << endl;	
-	for (uint32_t d_prv=0; d_prv<deviceVector.size(); d_prv++) {
-		for (uint32_t d_cns=0; d_cns<deviceVector.size(); d_cns++) {
-			for (uint32_t c=0; c<channelVector.size(); c++) {
-				if (L[d_prv][d_cns][c] > 0) {
-					cout << "\t" << "L[" << d_prv << "][" << d_cns << "][" << c << "] = " << L[d_prv][d_cns][c] << endl;
-				}
+		std::vector<std::string> tokens = split_string(line, "\t", true);		
+		if (tokens.size() !=4 ) {
+			for (uint32_t i=0; i<tokens.size(); i++) {
+				cout << i << "\t" << tokens.at(i) << endl;
 			}
+			cerr << "wrong number of tokens " << tokens.size() << " in file " << fname <<  endl;
+			cerr << line << endl;
+			return false;
 		}
-	}
-	
-	cout << endl << "State " << endl;
-	for (uint32_t d=0; d<deviceVector.size(); d++) {
+		//#transmittingDeviceId transmittingChannelId receivingDeviceId interferredChannelIdList
 		
-		if (START_Idle[d] == 1) {
-			cout << "\t" << "IDLE[" << d << "]= 1 " << endl;
+		uint32_t txDeviceIndex = getDeviceIndexById(atol(tokens.at(0).c_str()));
+		if (txDeviceIndex < 0) {
+			cerr << "unknown txDeviceId " << endl;
+			cerr << line << endl;
+			return false;
 		}
-		for (uint32_t c=0; c<channelVector.size(); c++) {
-			if (START_AP[d][c] == 1) {
-				cout << "\t" << "START_AP[" << d << "][" <<  c << "] = 1 " << endl;
-			}
+		uint32_t txChannelIndex = getChannelIndexById(atol(tokens.at(1).c_str()));
+		if (txChannelIndex < 0) {
+			cerr << "unknown txChannelId " << endl;
+			cerr << line << endl;
+			return false;
 		}
-		for (uint32_t d_ap=0; d_ap<deviceVector.size(); d_ap++) {
-			if (START_Client[d][d_ap] == 1) {
-				cout << "\t" << "START_Client[" << d << "][" << d_ap << "] = 1 " << endl;
-			}
+		uint32_t rxDeviceIndex = getDeviceIndexById(atol(tokens.at(2).c_str()));
+		if (rxDeviceIndex < 0) {
+			cerr << "unknown rxDeviceId " << endl;
+			cerr << line << endl;
+			return false;
 		}
-	}
-}
-
-int32_t d2dOptimizer::optimize() {
-	int32_t status;		
-	try {	
-		// Create variables
-		//y[d_prv][d_cns][n][c][t]
-		y = new GRBVar****[deviceVector.size()];
-		
-		for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
-			y[d_prv] = new GRBVar***[deviceVector.size()];
 			
-			for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
-				y[d_prv][d_cns] = new GRBVar**[contentVector.size()];
+		std::vector<std::string> channelTokens = split_string(tokens.at(3), ",", true);	
+		for (uint32_t i=0; i<channelTokens.size(); i++) {
 			
-				for (uint32_t n = 0; n<contentVector.size(); n++) {	
-					y[d_prv][d_cns][n] =  new GRBVar*[channelVector.size()];
+			uint32_t rxChannelIndex = getChannelIndexById(atol(channelTokens.at(i).c_str()));
+			if (rxChannelIndex < 0) {
+				cerr << "unknown rxChannelId " << endl;
+				cerr << line << endl;
+				return false;
+			}
+			if (X[txDeviceIndex][txChannelIndex][rxDeviceIndex][rxChannelIndex] == 0 && txDeviceIndex != rxDeviceIndex) {
+				interferenceList[txDeviceIndex * channelVector.size() + txChannelIndex].push_back(std::make_pair(rxDeviceIndex, rxChannelIndex));
+			}
+			X[txDeviceIndex][txChannelIndex][rxDeviceIndex][rxChannelIndex] = 1;
+			
+			//cout << "X[" << txDeviceIndex << "][" << txChannelIndex << "][" << rxDeviceIndex << "][" << rxChannelIndex << "]" << endl;
+		}
+	}
+	
+	for (uint64_t i = 0; i<interferenceList.size(); i++) {
+		std::sort(interferenceList[i].begin(), interferenceList[i].end());
+	}
+	return true;
+}
+
+bool d2dOptimizer::readLinkSpeed() {
+	std::string line;
+	std::string fname = dataPrefix + "link_speed.dat";
+	std::ifstream linkspeedfile(fname.c_str());
+	if (!linkspeedfile.is_open()) {
+		cerr << "Cannot open " << fname << endl;
+		return false;
+	}
+	//cout << endl << "Link Speed " << endl;
+	while (std::getline(linkspeedfile, line)) {
+		if (line.substr(0,1) == "#") {
+			continue;
+		}
+		// #contentProvider contentConsumer contentId utilityValue
+		std::vector<std::string> tokens = split_string(line, "\t", true);		
+		if (tokens.size() != 4) {
+			for (uint32_t i=0; i<tokens.size(); i++) {
+				cout << i << "\t" << tokens.at(i) << endl;
+			}
+			cerr << "wrong number of tokens " << tokens.size() << " in file " << fname <<  endl;
+			cerr << line << endl;
+			return false;
+		}
+		// #contentProvider contentConsumer  channelId linkSpeed(not present or 0=no connectivity )
+		uint32_t providerIndex = getDeviceIndexById(atol(tokens.at(0).c_str()));
+		if (providerIndex < 0) {
+			cerr << "unknown providerId " << endl;
+			cerr << line << endl;
+			return false;
+		}
+		uint32_t consumerIndex = getDeviceIndexById(atol(tokens.at(1).c_str()));
+		if (consumerIndex < 0) {
+			cerr << "unknown consumerId " << endl;
+			cerr << line << endl;
+			return false;
+		}
+		uint32_t channelIndex = getChannelIndexById(atol(tokens.at(2).c_str()));
+		if (channelIndex < 0) {
+			cerr << "unknown channelIndex " << endl;
+			cerr << line << endl;
+			return false;
+		}
+		uint64_t speed = atol(tokens.at(3).c_str());
+		L[providerIndex][consumerIndex][channelIndex] = speed;
+		//cout << "L[" << providerIndex << "][" << consumerIndex << "][" << channelIndex << "] = " << speed << endl;
+	}
+	
+	return true;
+}
+
+bool d2dOptimizer::readPositions() {
+	std::string line;
+	std::string fname = dataPrefix + "positions.dat";
+	std::ifstream positionfile(fname.c_str());
+	if (!positionfile.is_open()) {
+		return false;
+	}
+	//cout << endl << "Positions " << endl;
+	while (std::getline(positionfile, line)) {
+		if (line.substr(0,1) == "#") {
+			continue;
+		}
+		// #deviceId x y
+		std::vector<std::string> tokens = split_string(line, "\t", true);		
+		if (tokens.size() != 3) {
+			for (uint32_t i=0; i<tokens.size(); i++) {
+				cout << i << "\t" << tokens.at(i) << endl;
+			}
+			cerr << "wrong number of tokens " << tokens.size() << " in file " << fname <<  endl;
+			cerr << line << endl;
+			return false;
+		}
+		device *dev = getDeviceById(atol(tokens.at(0).c_str()));
+		if (dev == NULL) {
+			cerr << "unknown device id " << endl;
+			cerr << line << endl;
+			return false;
+		}
+		dev->hasPosition 	= true;
+		dev->x 				= atof(tokens.at(1).c_str());
+		dev->y 				= atof(tokens.at(2).c_str());
+	}
+	return true;
+}
+
+void d2dOptimizer::computeLinkParameters() {
+	uint32_t numChan = channelVector.size();
+	radio.sortRates();
+	
+	//only devices with position take part, index i of the spatial index is device located[i]
+	std::vector<uint32_t> located;
+	std::vector<double> posX;
+	std::vector<double> posY;
+	for (uint32_t d = 0; d<deviceVector.size(); d++) {
+		if (deviceVector[d]->hasPosition) {
+			located.push_back(d);
+			posX.push_back(deviceVector[d]->x);
+			posY.push_back(deviceVector[d]->y);
+		}
+	}
+	double range = radio.range();
+	d2dSpatialIndex index;
+	index.build(posX, posY, range);
+	
+	interferenceList.assign(deviceVector.size() * numChan, std::vector< std::pair<uint32_t, uint32_t> >());
+	//each thread writes the rows of its transmitting devices only
+	runParallel(located.size(), buildThreads(), [&](uint32_t begin, uint32_t end, uint32_t) {
+		std::vector<uint32_t> near;
+		for (uint32_t i = begin; i<end; i++) {
+			uint32_t a = located[i];
+			index.neighbors(i, range, near);
+			for (uint32_t j = 0; j<near.size(); j++) {
+				uint32_t b 	= located[near[j]];
+				double dist = index.distance(i, near[j]);
+				long speed 	= radio.linkSpeed(dist);
+				for (uint32_t c = 0; c<numChan; c++) {
+					if (W[a][c] == 0) {
+						continue;
+					}
+					if (speed > 0 && W[b][c] == 1) {
+						L[a][b][c] = speed;
+					}
+					for (uint32_t c_rx = 0; c_rx<numChan; c_rx++) {
+						if (W[b][c_rx] == 1 && radio.interferes(c, c_rx, dist)) {
+							X[a][c][b][c_rx] = 1;
+							interferenceList[a * numChan + c].push_back(std::make_pair(b, c_rx));
+						}
+					}
+				}
+			}
+		}
+	});
+}
+
+void d2dOptimizer::updateInterferenceList() {
+	uint32_t numChan = channelVector.size();
+	if (interferenceList.size() == deviceVector.size() * numChan) {
+		return;
+	}
+	interferenceList.assign(deviceVector.size() * numChan, std::vector< std::pair<uint32_t, uint32_t> >());
+	for (uint32_t d_tx = 0; d_tx<deviceVector.size(); d_tx++) {
+		for (uint32_t c_tx = 0; c_tx<numChan; c_tx++) {
+			for (uint32_t d_rx = 0; d_rx<deviceVector.size(); d_rx++) {
+				if (d_tx == d_rx) {
+					continue;
+				}
+				for (uint32_t c_rx = 0; c_rx<numChan; c_rx++) {
+					if (X[d_tx][c_tx][d_rx][c_rx] == 1) {
+						interferenceList[d_tx * numChan + c_tx].push_back(std::make_pair(d_rx, c_rx));
+					}
+				}
+			}
+		}
+	}
+}
+
+void d2dOptimizer::printParameterSimple() {
+	cout << endl << "Channels " <<  channelVector.size() << endl;
+	for (uint32_t c=0; c<channelVector.size(); c++) {
+		cout << "\t" << c << " ID " << channelVector.at(c)->id << endl;
+	}
+	
+	cout << endl << "Devices " << deviceVector.size() << endl;
+	for (uint32_t d=0; d<deviceVector.size(); d++) {
+		cout << "\t" <<  d << " ID " << deviceVector.at(d)->id <<   endl;
+	}
+	
+	cout << endl << "Content " <<  contentVector.size() << endl;
+	for (uint32_t c=0; c<contentVector.size(); c++) {
+		content *cont = contentVector.at(c);
+		cout << "\t" << c << " ID " << cont->id << " Size " << cont->size <<  endl;
+	}
+}
+
+void d2dOptimizer::printParameter() {
+	
+	cout << endl << "Channels " <<  channelVector.size() << endl;
+	
+	cout << endl << "Content " << contentVector.size() << endl;
+	for (uint32_t n=0; n<contentVector.size(); n++) {
+		cout << "\t" << "S[" << n << "] = " << S[n] << " ID " << contentVector[n]->id << endl;
+	}
+	
+	cout << endl << "Devices " << deviceVector.size() << endl;
+	for (uint32_t d=0; d<deviceVector.size(); d++) {
+		cout << "Device index " << d << " ID " << deviceVector[d]->id << endl;
+		for (uint32_t n=0; n<contentVector.size(); n++) {
+			if (P[d][n] == 1) {
+				cout << "\tP[" << d << "][" << n << "]" << endl;
+			}
+		}
+		
+		for (uint32_t n=0; n<contentVector.size(); n++) {
+			if (I[d][n] == 1) {
+				cout << "\tI[" << d << "][" << n << "]" << endl;
+			}
+		}
+		
+		for (uint32_t c=0; c<channelVector.size(); c++) {
+			if (W[d][c] == 1) {				
+				cout << "\tW[" << d << "][" << c << "]" << endl;
+			}	
+		}
+		cout << endl;
+	}
+	
+	cout << "Interference " << endl;
+	for (uint32_t d_tx=0; d_tx<deviceVector.size(); d_tx++) {
+		for (uint32_t c_tx=0; c_tx<channelVector.size(); c_tx++) {
+			for (uint32_t d_rx=0; d_rx<deviceVector.size(); d_rx++) {
+				for (uint32_t c_rx=0; c_rx<channelVector.size(); c_rx++) {
+					if (X[d_tx][c_tx][d_rx][c_rx] == 1) {
+						cout << "\t" << "X[" << d_tx << "][" << c_tx << "][" << d_rx << "][" << c_rx << "]" << endl;
+					}
+				}
+			}	
+		}
+	}
+	
+	cout << endl << "Utility " << endl;
+	for (uint32_t d_prv=0; d_prv<deviceVector.size(); d_prv++) {
+		for (uint32_t d_cns=0; d_cns<deviceVector.size(); d_cns++) {
+			for (uint32_t n=0; n<contentVector.size(); n++) {
+				if (U[d_prv][d_cns][n] > 0) {
+					cout << "\t" << "U[" << d_prv << "][" << d_cns << "][" << n << "] = " << U[d_prv][d_cns][n]  << endl;	
+				}
+			}
+		}
+	}
+		
+	cout << endl << "Link Speed " << endl;	
+	for (uint32_t d_prv=0; d_prv<deviceVector.size(); d_prv++) {
+		for (uint32_t d_cns=0; d_cns<deviceVector.size(); d_cns++) {
+			for (uint32_t c=0; c<channelVector.size(); c++) {
+				if (L[d_prv][d_cns][c] > 0) {
+					cout << "\t" << "L[" << d_prv << "][" << d_cns << "][" << c << "] = " << L[d_prv][d_cns][c] << endl;
+				}
+			}
+		}
+	}
+	
+	cout << endl << "State " << endl;
+	for (uint32_t d=0; d<deviceVector.size(); d++) {
+		
+		if (START_Idle[d] == 1) {
+			cout << "\t" << "IDLE[" << d << "]= 1 " << endl;
+		}
+		for (uint32_t c=0; c<channelVector.size(); c++) {
+			if (START_AP[d][c] == 1) {
+				cout << "\t" << "START_AP[" << d << "][" <<  c << "] = 1 " << endl;
+			}
+		}
+		for (uint32_t d_ap=0; d_ap<deviceVector.size(); d_ap++) {
+			if (START_Client[d][d_ap] == 1) {
+				cout << "\t" << "START_Client[" << d << "][" << d_ap << "] = 1 " << endl;
+			}
+		}
+	}
+}
+
+uint32_t d2dOptimizer::buildThreads() {
+	//debug output of the constraint generation is only readable if it is not interleaved
+	if (debugConstraints || numThreads < 1) {
+		return 1;
+	}
+	return numThreads;
+}
+
+d2dVarBlock d2dOptimizer::addVarBlock(const std::string &name, const std::vector<std::string> &labels, const std::vector<uint64_t> &dims, char type) {
+	uint64_t count = 1;
+	for (uint32_t i = 0; i<dims.size(); i++) {
+		count *= dims[i];
+	}
+	
+	std::vector<std::string> names;
+	if (setVariableNames && count > 0) {
+		// e.g. y[d_prv-0][d_cns-1][n-0][c-0][t-3]
+		names.resize(count);
+		uint64_t inner = count / dims[0];
+		runParallel(dims[0], buildThreads(), [&](uint32_t begin, uint32_t end, uint32_t) {
+			for (uint64_t i = begin * inner; i < end * inner; i++) {
+				std::vector<uint64_t> idx(dims.size());
+				uint64_t rest = i;
+				for (int32_t k = dims.size() - 1; k >= 0; k--) {
+					idx[k] = rest % dims[k];
+					rest /= dims[k];
+				}
+				std::stringstream sstm;
+				sstm << name;
+				for (uint32_t k = 0; k<dims.size(); k++) {
+					sstm << "[" << labels[k] << "-" << idx[k] << "]";
+				}
+				names[i] = sstm.str();
+			}
+		});
+	}
+	
+	double ub = type == D2D_BINARY ? 1.0 : D2D_INFINITY;
+	d2dVar base = backend->addVars(count, 0.0, ub, type, setVariableNames ? &names : NULL);
+	return d2dVarBlock(base, dims);
+}
+
+void d2dOptimizer::addConstrsParallel(uint32_t count, uint64_t rowsPerIndex, uint64_t termsPerIndex,
+										const std::function<void(d2dConstraintBuffer &, uint32_t)> &generator) {
+	uint32_t threads = std::min(buildThreads(), count);
+	if (count == 0) {
+		return;
+	}
+	
+	if (threads <= 1) {
+		d2dConstraintBuffer conBuf(setConstraintNames);
+		conBuf.reserve(std::min<uint64_t>(rowsPerIndex * count, D2D_CONSTR_FLUSH_TERMS), 
+						std::min<uint64_t>(termsPerIndex * count, D2D_CONSTR_FLUSH_TERMS));
+		for (uint32_t i = 0; i<count; i++) {
+			generator(conBuf, i);
+			conBuf.flushIfFull(backend);
+		}
+		conBuf.flush(backend);
+		return;
+	}
+	
+	// The index range is processed in rounds of one block per thread. Each thread fills its own buffer,
+	// afterwards the buffers are handed to the model in index order, the resulting model does not
+	// depend on the number of threads or the block size. The block size is limited so that the buffers
+	// of a round hold about D2D_CONSTR_FLUSH_TERMS terms, in the first round by termsPerIndex and then
+	// by the most terms per index of the previous round.
+	uint32_t numBlocks = threads * D2D_BUILD_BLOCKS_PER_THREAD;
+	uint32_t maxBlockSize = (count + numBlocks - 1) / numBlocks;
+	uint64_t blockTerms = D2D_CONSTR_FLUSH_TERMS / threads;
+	uint32_t blockSize = maxBlockSize;
+	if (termsPerIndex > 0) {
+		blockSize = std::max<uint64_t>(1, std::min<uint64_t>(maxBlockSize, blockTerms / termsPerIndex));
+	}
+	
+	std::vector<d2dConstraintBuffer> buffers(threads, d2dConstraintBuffer(setConstraintNames));
+	for (uint32_t i = 0; i<threads; i++) {
+		buffers[i].reserve(std::min<uint64_t>(rowsPerIndex * blockSize, D2D_CONSTR_FLUSH_TERMS), 
+							std::min<uint64_t>(termsPerIndex * blockSize, blockTerms));
+	}
+	
+	for (uint32_t roundBegin = 0; roundBegin < count; ) {
+		uint32_t roundCount = std::min<uint64_t>(count - roundBegin, (uint64_t)blockSize * threads);
+		uint32_t roundBlocks = (roundCount + blockSize - 1) / blockSize;
+		std::vector<uint32_t> indices(threads, 0);
+		runParallel(roundBlocks, threads, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+			for (uint32_t block = begin; block < end; block++) {
+				uint32_t first	= roundBegin + block * blockSize;
+				uint32_t last	= std::min(count, first + blockSize);
+				for (uint32_t i = first; i<last; i++) {
+					generator(buffers[thread], i);
+				}
+				indices[thread] += last - first;
+			}
+		});
+		uint64_t maxTerms = 0;
+		for (uint32_t i = 0; i<threads; i++) {
+			if (indices[i] > 0) {
+				maxTerms = std::max<uint64_t>(maxTerms, (buffers[i].numTerms() + indices[i] - 1) / indices[i]);
+			}
+			buffers[i].flush(backend);
+		}
+		roundBegin += roundCount;
+		if (maxTerms > 0) {
+			blockSize = std::max<uint64_t>(1, std::min<uint64_t>(maxBlockSize, blockTerms / maxTerms));
+		}
+	}
+}
+
+void d2dOptimizer::computeMulticastRates() {
+	multicastRates.clear();
+	for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
+			for (uint32_t c = 0; c<channelVector.size(); c++) {	
+				if (L[d_prv][d_cns][c] > 0) {
+					multicastRates.push_back(L[d_prv][d_cns][c]);
+				}
+			}
+		}
+	}
+	std::sort(multicastRates.begin(), multicastRates.end());
+	multicastRates.erase(std::unique(multicastRates.begin(), multicastRates.end()), multicastRates.end());
+}
+
+int32_t d2dOptimizer::optimize() {
+	try {
+		int32_t status;
+		bool cached = solutionCache != NULL && solutionCache->lookup(this, schedule, status);
+		//the mode of this instance, the estimator decides again for every instance
+		int32_t selected = mode;
+		if (!cached && mode == D2D_MODE_AUTO) {
+			d2dModelEstimator estimator(this);
+			selected = estimator.selectMode();
+		}
+		if (cached) {
+			cout << "Schedule from solution cache, utility " << schedule.utility << endl;
+			if (debugResults) {
+				schedule.print(cout);
+			}
+		} else if (selected == D2D_MODE_MATCHING) {
+			d2dMatchingHeuristic heuristic(this);
+			heuristic.run(schedule);
+			if (debugResults) {
+				schedule.print(cout);
+			}
+			status = D2D_STATUS_FEASIBLE;
+		} else if (selected == D2D_MODE_LAGRANGIAN) {
+			//the clusters have their own models, the model of the whole instance is not built
+			d2dLagrangian lagrangian(this);
+			lagrangian.maxClusterSize = maxClusterSize;
+			status = lagrangian.run(schedule);
+			if (debugResults && (status == D2D_STATUS_OPTIMAL || status == D2D_STATUS_FEASIBLE)) {
+				schedule.print(cout);
+			}
+		} else {
+			if (useTemplate && templateBuilt && builtShape == templateShape()) {
+				updateModel();
+			} else {
+				buildModel();
+			}
+			if (useMatchingStart || selected == D2D_MODE_LNS) {
+				d2dMatchingHeuristic heuristic(this);
+				heuristic.run(schedule);
+				cout << "MIP start utility " << schedule.utility << endl;
+			}
+			
+			if (selected == D2D_MODE_LNS) {
+				d2dLNS lns(this);
+				status = lns.run(schedule);
+				if (debugResults) {
+					printResults();
+				}
+			} else if (selected == D2D_MODE_PORTFOLIO) {
+				d2dPortfolio portfolio(this);
+				status = portfolio.run(schedule);
+				if (debugResults) {
+					printResults();
+				}
+			} else if (selected == D2D_MODE_LP) {
+				d2dLPRounding rounding(this);
+				status = rounding.run(schedule);
+				if (status == D2D_STATUS_OPTIMAL || status == D2D_STATUS_FEASIBLE) {
+					scheduleToValues(schedule, solution);
+					if (debugResults) {
+						printResults();
+					}
+				}
+			} else {
+				if (useMatchingStart) {
+					setStart(schedule);
+				}
+				status = solve();
+			}
+		}
+		
+		if (validateSchedule && (status == D2D_STATUS_OPTIMAL || status == D2D_STATUS_FEASIBLE)) {
+			d2dValidator validator(this);
+			bool valid = validator.validate(schedule);
+			validator.print(cout);
+			if (!valid) {
+				return D2D_STATUS_ERROR;
+			}
+		}
+		if (solutionCache != NULL && !cached && (status == D2D_STATUS_OPTIMAL || status == D2D_STATUS_FEASIBLE)) {
+			solutionCache->insert(schedule, status);
+		}
+		return status;
+	} catch (exception& e)	{
+		cout << e.what() << endl;
+		return D2D_STATUS_ERROR;
+	} catch(...) {
+		cout << "Exception during optimization" << endl;
+		return D2D_STATUS_ERROR;
+	}
+}
+
+void d2dOptimizer::buildModel() {
+	uint64_t numDev 	= deviceVector.size();
+	uint64_t numChan	= channelVector.size();
+	uint64_t numCont	= contentVector.size();
+	uint64_t numT 		= settings.numTimeSlots;
+	
+	backend->clear();
+	solution.clear();
+	templateBuilt = useTemplate;
+	if (useTemplate) {
+		builtShape = templateShape();
+	}
+	
+	// Create variables
+	// each family is one contiguous block of columns, added with a single addVars call
+	//y[d_prv][d_cns][n][c][t]
+	y = addVarBlock("y", {"d_prv", "d_cns", "n", "c", "t"}, {numDev, numDev, numCont, numChan, numT}, D2D_BINARY);
+	
+	//s[d][c][t]
+	s = addVarBlock("s", {"d", "c", "t"}, {numDev, numChan, numT}, D2D_BINARY);
+	
+	//r[d][c][t]
+	r = addVarBlock("r", {"d", "c", "t"}, {numDev, numChan, numT}, D2D_BINARY);
+	
+	//h[d_prv][d_cns][n][c][t]
+	h = addVarBlock("h", {"d_prv", "d_cns", "n", "c", "t"}, {numDev, numDev, numCont, numChan, numT}, D2D_BINARY);
+	
+	//p[d][n][t] 
+	p = addVarBlock("p", {"d", "n", "t"}, {numDev, numCont, numT}, D2D_BINARY);
+	
+	// State Variables		
+	S_Idle 		= addVarBlock("S_Idle", {"d", "t"}, {numDev, numT}, D2D_BINARY);
+	S_StartAP	= addVarBlock("S_StartAP", {"d", "c", "t"}, {numDev, numChan, numT}, D2D_BINARY);
+	S_SwitchAP	= addVarBlock("S_SwitchAP", {"d", "c", "t"}, {numDev, numChan, numT}, D2D_BINARY);
+	S_AP		= addVarBlock("S_AP", {"d", "c", "t"}, {numDev, numChan, numT}, D2D_BINARY);
+	
+	S_StartClient	= addVarBlock("S_StartClient", {"d", "d_ap", "t"}, {numDev, numDev, numT}, D2D_BINARY);
+	S_JoinAP		= addVarBlock("S_JoinAP", {"d", "d_ap", "t"}, {numDev, numDev, numT}, D2D_BINARY);
+	S_Client		= addVarBlock("S_Client", {"d", "d_ap", "t"}, {numDev, numDev, numT}, D2D_BINARY);
+	
+	//m[d_prv][n][c][t][k], one rate class per distinct link speed
+	multicastRates.clear();
+	m = d2dVarBlock();
+	if (multicast) {
+		computeMulticastRates();
+		m = addVarBlock("m", {"d_prv", "n", "c", "t", "k"}, {numDev, numCont, numChan, numT, multicastRates.size()}, D2D_BINARY);
+	}
+	uint64_t numRates = multicastRates.size();
+	
+	cout << "Num Vars " <<  backend->numVars() << endl;
+	
+	buildObjective();
+	
+	
+	cout << "Adding constraints...." << endl;
+	
+	//Content availability, if a content is available at a device in the beginning of a super slot
+	// it should be available the whole duration of the super slot
+	//C1
+	if (debugConstraints)
+		cout << "p-start constraint" << endl;
+	//bounds of p in template mode
+	addConstrsParallel(useTemplate ? 0 : deviceVector.size(), numCont * numT, numCont * numT, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t n = 0; n<contentVector.size(); n++) {	
+			
+			if (P[d][n] == 1) {
 				
-					for (uint32_t c = 0; c<channelVector.size(); c++) {	
-						y[d_prv][d_cns][n][c] =  new GRBVar[settings.numTimeSlots];
-					
-						for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+					//p_start1 C1 
+					conBuf.addTerm(p(d, n, t), 1.0);
+					conBuf.endRow(D2D_EQUAL, 1.0);
+					if (setConstraintNames) {
+						std::stringstream sstm;
+						sstm << "p_start1_d-" << d << "_n-" << n << "_t-"<< t;
+						conBuf.nameRow(sstm.str());
+					}
+				}
+			} else {
+				//p_start0 C2 
+				conBuf.addTerm(p(d, n, 0), 1.0);
+				conBuf.endRow(D2D_EQUAL, 0.0);
+				if (setConstraintNames) {
+					std::stringstream sstm;
+					sstm << "p_start0_d-" << d << "_n-" << n;
+					conBuf.nameRow(sstm.str());
+				}
+			}
+		}
+	});
+	
+	if (debugConstraints)
+		cout << "p-next constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numCont * numT, numCont * numT * 2, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t n = 0; n<contentVector.size(); n++) {	
+			for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
+				
+				//p_next C3
+				conBuf.addTerm(p(d, n, t), 1.0);
+				conBuf.addTerm(p(d, n, t-1), -1.0);
+				for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {	
+					for (uint32_t c = 0; c<channelVector.size(); c++) {
+						
+						if (L[d_prv][d][c] > 0 && !multicast) {
+							int64_t t_duration = ceil( (double)S[n] / (double)L[d_prv][d][c]);
 							
+							int64_t t_start = t - t_duration;
+							
+							if (t_start >= 0) {
+								conBuf.addTerm(y(d_prv, d, n, c, t_start), -1.0);
+								if (debugConstraints)
+									cout << "y[d_prv-" << d_prv << "][d-" << d << "][n-" << n <<  "][c-" << c << "][t_start-" << t_start << "]" << endl;
+							}
+						} else if (L[d_prv][d][c] > 0) {
+							//multicast, the transmission may use any rate up to the link speed, an arrival 
+							//before the end of the chosen transmission is excluded by MC5
+							int64_t lastDuration = -1;
+							for (uint32_t k = 0; k<numRates && multicastRates[k] <= L[d_prv][d][c]; k++) {
+								int64_t t_start = t - multicastDuration(n, k);
+								if (t_start >= 0 && t_start != t - lastDuration) {
+									conBuf.addTerm(y(d_prv, d, n, c, t_start), -1.0);
+								}
+								lastDuration = multicastDuration(n, k);
+							}
+						}
+					}
+				}
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+				if (setConstraintNames) {
+					std::stringstream sstm;
+					sstm << "p_next[d-" << d << "][n-" << n << "][t-" << t << "]";
+					conBuf.nameRow(sstm.str());
+				}
+			}
+		}
+	});
+	
+	if (debugConstraints)
+		cout << "c4 - c11 constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numDev * numCont * numChan * numT * 5, numDev * numCont * numChan * numT * 6, [&](d2dConstraintBuffer &conBuf, uint32_t d_prv) {
+		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
+			for (uint32_t n = 0; n<contentVector.size(); n++) {	
+				for (uint32_t c = 0; c<channelVector.size(); c++) {	
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						
+						if (debugConstraints)
+							cout << "d_prv " << d_prv << " d_cns " << d_cns << " n " << n << " c " << c << " t " << t << endl;
+						
+						d2dVar y_var = y(d_prv, d_cns, n, c, t);
+						//
+						//	Content provider must have the content C4
+						//
+						conBuf.addTerm(y_var, 1.0);
+						conBuf.addTerm(p(d_prv, n, t), -1.0);
+						conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+						if (setConstraintNames) {
 							std::stringstream sstm;
-							if (setVariableNames) {
-								sstm << "y[d_prv-" << d_prv << "][d_cns-" << d_cns << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+							sstm << "ProvideContent[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+							conBuf.nameRow(sstm.str());
+						}
+						
+						//
+						//	Content cosnumer must be interested C5, bound of y in template mode
+						//
+						if (!useTemplate) {
+							conBuf.addTerm(y_var, 1.0);
+							conBuf.endRow(D2D_LESS_EQUAL, I[d_cns][n]);
+							if (setConstraintNames) {
+								std::stringstream sstm;
+								sstm << "InterestContent[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+								conBuf.nameRow(sstm.str());
 							}
-							y[d_prv][d_cns][n][c][t] =  model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
 						}
+						
+						//
+						//	Content provider and consumer must be able to use the channel C6
+						//
+						conBuf.addTerm(y_var, 2.0);
+						conBuf.endRow(D2D_LESS_EQUAL, W[d_cns][c] +  W[d_prv][c]);
+						if (setConstraintNames) {
+							std::stringstream sstm;
+							sstm << "ChannelSupport[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";	
+							conBuf.nameRow(sstm.str());
+						}
+						
+						//
+						// Connectivity requirement C7
+						// (1 - y) + L >= 1
+						///
+						conBuf.addTerm(y_var, 1.0);
+						conBuf.endRow(D2D_LESS_EQUAL, (double)L[d_prv][d_cns][c]);
+						if (setConstraintNames) {
+							std::stringstream sstm;
+							sstm << "Connectivity[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+							conBuf.nameRow(sstm.str());
+						}
+														
+						//helper variables
+						//set for all time slots in which content exchange occur
+						if (L[d_prv][d_cns][c] > 0) {
+							int64_t t_max_new = t + ceil( (double)S[n] / (double)L[d_prv][d_cns][c]);
+							
+							//only schedule if t_max_new is not larger than superslot length
+							if (t_max_new <= settings.numTimeSlots) {
+							
+								for (int64_t t_new = t; t_new < t_max_new; t_new++) {	
+									// C9
+									//helper variable sending mode
+									conBuf.addTerm(s(d_prv, c, t_new), 1.0);
+									conBuf.addTerm(y_var, -1.0);
+									conBuf.endRow(D2D_GREATER_EQUAL, 0.0);
+									if (setConstraintNames) {
+										std::stringstream sstm;
+										sstm << "s_helper[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+										conBuf.nameRow(sstm.str());
+									}
+									
+									//C 10
+									//helper variable receiving mode
+									conBuf.addTerm(r(d_cns, c, t_new), 1.0);
+									conBuf.addTerm(y_var, -1.0);
+									conBuf.endRow(D2D_GREATER_EQUAL, 0.0);
+									if (setConstraintNames) {
+										std::stringstream sstm;
+										sstm << "r_helper[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+										conBuf.nameRow(sstm.str());
+									}
+									
+									// C11
+									//helper variable exchange mode
+									conBuf.addTerm(h(d_prv, d_cns, n, c, t_new), 1.0);
+									conBuf.addTerm(y_var, -1.0);
+									conBuf.endRow(D2D_GREATER_EQUAL, 0.0);
+									if (setConstraintNames) {
+										std::stringstream sstm;
+										sstm << "h_helper[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+										conBuf.nameRow(sstm.str());
+									}
+								}									
+	
+							} 						
+							//
+							// Content exchange must fit into superslot C9
+							//
+
+							// A content exchange must fit into super slot. An exchange cannot be scheduled at the end of a super slot, if the transfer cannot be finished within the super slot.
+							// C8
+							conBuf.addTerm(y_var, (((double) t) / ((double) settings.numTimeSlots)) * settings.tau + ((double)S[n]) / ((double)L[d_prv][d_cns][c]));
+							conBuf.endRow(D2D_LESS_EQUAL, settings.tau);
+							if (setConstraintNames) {
+								std::stringstream sstm;
+								sstm << "ExchangeMustFit[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+								conBuf.nameRow(sstm.str());
+							}
+							
+							//the exchange must end by the deadline of the consumer
+							if (!meetsDeadline(d_cns, n, t_max_new)) {
+								conBuf.addTerm(y_var, 1.0);
+								conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+								if (setConstraintNames) {
+									std::stringstream sstm;
+									sstm << "Deadline[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+									conBuf.nameRow(sstm.str());
+								}
+							}
+						}	
+					}
+				}
+			}
+		}
+	});
+	
+	
+	// Half-duplex constraint
+	// C12
+	if (debugConstraints)
+		cout << "Half-duplex constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numT, numT * numChan * 2, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (int64_t t = 0; t<settings.numTimeSlots; t++) {
+			for (uint32_t c = 0; c<channelVector.size(); c++) {
+				conBuf.addTerm(s(d, c, t), 1.0);
+				conBuf.addTerm(r(d, c, t), 1.0);
+			}
+			conBuf.endRow(D2D_LESS_EQUAL, 1.0);
+			if (setConstraintNames) {
+				std::stringstream sstm;
+				sstm << "half-duplex[d-" << d << "][t-" << t << "]";
+				conBuf.nameRow(sstm.str());
+			}
+		}
+	});
+	
+	//received content must fit into the storage of the consumer, only for devices with a capacity
+	if (debugConstraints)
+		cout << "storage capacity constraint" << endl;
+	addConstrsParallel(deviceVector.size(), 0, 0, [&](d2dConstraintBuffer &conBuf, uint32_t d_cns) {
+		int64_t storage = freeStorage(d_cns);
+		if (storage < 0) {
+			return;
+		}
+		for (uint32_t n = 0; n<contentVector.size(); n++) {	
+			//in template mode the terms of these exchanges are fixed to 0 by the bounds
+			if (!useTemplate && (I[d_cns][n] != 1 || P[d_cns][n] == 1)) {
+				continue;
+			}
+			for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+				for (uint32_t c = 0; c<channelVector.size(); c++) {
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						conBuf.addTerm(y(d_prv, d_cns, n, c, t), (double)S[n]);
 					}
 				}
 			}
 		}
-		
-		//s[d][c][t]
-		s = new GRBVar**[deviceVector.size()];
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			s[d] = new GRBVar*[channelVector.size()];
-
-			for (uint32_t c = 0; c<channelVector.size(); c++) {	
-				s[d][c] =  new GRBVar[settings.numTimeSlots];
-				
-				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				
-					std::stringstream sstm;
-					if (setVariableNames) {
-						sstm << "s[d-" << d << "][c-" << c << "][t-" << t << "]";
+		conBuf.endRow(D2D_LESS_EQUAL, (double)storage);
+		if (setConstraintNames) {
+			std::stringstream sstm;
+			sstm << "Storage[d_c-" << d_cns << "]";
+			conBuf.nameRow(sstm.str());
+		}
+	});
+	
+	//each consumer should only receive the content once
+	// C13
+	if (debugConstraints)
+		cout << "Consumer content only once constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numCont, numCont * numDev * numChan * numT, [&](d2dConstraintBuffer &conBuf, uint32_t d_cns) {
+		for (uint32_t n = 0; n<contentVector.size(); n++) {	
+			
+			for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+				for (uint32_t c = 0; c<channelVector.size(); c++) {
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						conBuf.addTerm(y(d_prv, d_cns, n, c, t), 1.0);
 					}
-					s[d][c][t] = model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
 				}
 			}
+			//in template mode content held by the consumer is excluded by the bounds of y
+			conBuf.endRow(D2D_LESS_EQUAL, useTemplate ? 1 : 1 - P[d_cns][n]);
+			if (setConstraintNames) {
+				std::stringstream sstm;
+				sstm << "CnsContentOnce[d_c-" << d_cns << "][n-" << n << "]";
+				conBuf.nameRow(sstm.str());
+			}
 		}
-		
-		//r[d][c][t]
-		r = new GRBVar**[deviceVector.size()];
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			r[d] = new GRBVar*[channelVector.size()];
+	});
 
-			for (uint32_t c = 0; c<channelVector.size(); c++) {	
-				r[d][c] =  new GRBVar[settings.numTimeSlots];
-				
-				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				
-					std::stringstream sstm;
-					if (setVariableNames) {
-						sstm << "r[d-" << d << "][c-" << c << "][t-" << t << "]";
+	//a provider can only  serve one consumer in each time slot and channel
+	// C14
+	if (debugConstraints)
+		cout << "Provider only one consumer constraint" << endl;
+	if (!multicast) {
+		addConstrsParallel(deviceVector.size(), numT, numT * numDev * numCont * numChan, [&](d2dConstraintBuffer &conBuf, uint32_t d_prv) {
+			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+				for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {
+					for (uint32_t n = 0; n<contentVector.size(); n++) {	
+						for (uint32_t c = 0; c<channelVector.size(); c++) {
+							//with airtime sharing each exchange takes its share of the slot
+							double share = airtimeSharing && L[d_prv][d_cns][c] > 0 ? airtimeShare(d_prv, d_cns, n, c) : 1.0;
+							conBuf.addTerm(h(d_prv, d_cns, n, c, t), share);
+						}
 					}
-					r[d][c][t] = model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
+				}
+				conBuf.endRow(D2D_LESS_EQUAL, 1.0);
+				if (setConstraintNames) {
+					std::stringstream sstm;
+					sstm << "PrvOnlyOneConsumer[d_p-" << d_prv << "][t-" << t << "]";
+					conBuf.nameRow(sstm.str());
 				}
 			}
-		}
-	
-		//h[d_prv][d_cns][n][c][t]
-		h = new GRBVar****[deviceVector.size()];
-		for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
-			h[d_prv] = new GRBVar***[deviceVector.size()];
-			
-			for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
-				h[d_prv][d_cns] = new GRBVar**[contentVector.size()];
-				
+		});
+	} else {
+		//multicast, a provider sends one transmission at a time, which may be received by several consumers
+		addConstrsParallel(deviceVector.size(), numT, 0, [&](d2dConstraintBuffer &conBuf, uint32_t d_prv) {
+			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
 				for (uint32_t n = 0; n<contentVector.size(); n++) {	
-					h[d_prv][d_cns][n] = new GRBVar*[channelVector.size()];
-					
 					for (uint32_t c = 0; c<channelVector.size(); c++) {
-						
-						h[d_prv][d_cns][n][c] = new GRBVar[settings.numTimeSlots];
-						for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-						
-							std::stringstream sstm;
-							if (setVariableNames) {
-								sstm << "h[d_prv-" << d_prv << "][d_cns-" << d_cns << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+						for (uint32_t k = 0; k<numRates; k++) {
+							for (int64_t t_start = std::max<int64_t>(0, t - multicastDuration(n, k) + 1); t_start <= t; t_start++) {
+								conBuf.addTerm(m(d_prv, n, c, t_start, k), 1.0);
 							}
-							h[d_prv][d_cns][n][c][t] = model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
 						}
 					}
 				}
+				conBuf.endRow(D2D_LESS_EQUAL, 1.0);
+				if (setConstraintNames) {
+					std::stringstream sstm;
+					sstm << "PrvOneTransmission[d_p-" << d_prv << "][t-" << t << "]";
+					conBuf.nameRow(sstm.str());
+				}
 			}
-		}
-		
-		//p[d][n][t] 
-		p = new GRBVar**[deviceVector.size()];
+		});
 		
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			
-			p[d] = new GRBVar*[contentVector.size()];
+		if (debugConstraints)
+			cout << "multicast transmission constraint" << endl;
+		addConstrsParallel(deviceVector.size(), 0, 0, [&](d2dConstraintBuffer &conBuf, uint32_t d_prv) {
 			for (uint32_t n = 0; n<contentVector.size(); n++) {	
-			
-				p[d][n] = new GRBVar[settings.numTimeSlots];
+				for (uint32_t c = 0; c<channelVector.size(); c++) {
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						for (uint32_t k = 0; k<numRates; k++) {
+							int64_t duration = multicastDuration(n, k);
+							//MC1 the transmission must fit into the superslot
+							if (!multicastFits(n, k, t)) {
+								conBuf.addTerm(m(d_prv, n, c, t, k), 1.0);
+								conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+								continue;
+							}
+							//MC2 sending mode during the transmission
+							for (int64_t t_new = t; t_new < t + duration; t_new++) {
+								conBuf.addTerm(s(d_prv, c, t_new), 1.0);
+								conBuf.addTerm(m(d_prv, n, c, t, k), -1.0);
+								conBuf.endRow(D2D_GREATER_EQUAL, 0.0);
+							}
+						}
+						
+						for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
+							if (L[d_prv][d_cns][c] <= 0) {
+								continue;
+							}
+							//MC3 a consumer receives a transmission at a rate up to its link speed, ending by its deadline
+							d2dVar y_var = y(d_prv, d_cns, n, c, t);
+							conBuf.addTerm(y_var, 1.0);
+							for (uint32_t k = 0; k<numRates && multicastRates[k] <= L[d_prv][d_cns][c]; k++) {
+								if (meetsDeadline(d_cns, n, t + multicastDuration(n, k))) {
+									conBuf.addTerm(m(d_prv, n, c, t, k), -1.0);
+								}
+							}
+							conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+							if (setConstraintNames) {
+								std::stringstream sstm;
+								sstm << "ReceiveTransmission[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
+								conBuf.nameRow(sstm.str());
+							}
+							
+							//MC4, MC5 at a rate below the link speed the consumer receives (r, h) and 
+							//does not hold the content (p) until the end of the transmission
+							int64_t pairDuration = exchangeDuration(d_prv, d_cns, n, c);
+							for (uint32_t k = 0; k<numRates && multicastRates[k] < L[d_prv][d_cns][c]; k++) {
+								int64_t duration = multicastDuration(n, k);
+								for (int64_t t_new = t + pairDuration; t_new < t + duration && t + duration <= settings.numTimeSlots; t_new++) {
+									//MC4
+									conBuf.addTerm(r(d_cns, c, t_new), 1.0);
+									conBuf.addTerm(y_var, -1.0);
+									conBuf.addTerm(m(d_prv, n, c, t, k), -1.0);
+									conBuf.endRow(D2D_GREATER_EQUAL, -1.0);
+									conBuf.addTerm(h(d_prv, d_cns, n, c, t_new), 1.0);
+									conBuf.addTerm(y_var, -1.0);
+									conBuf.addTerm(m(d_prv, n, c, t, k), -1.0);
+									conBuf.endRow(D2D_GREATER_EQUAL, -1.0);
+									//MC5
+									conBuf.addTerm(p(d_cns, n, t_new), 1.0);
+									conBuf.addTerm(y_var, 1.0);
+									conBuf.addTerm(m(d_prv, n, c, t, k), 1.0);
+									conBuf.endRow(D2D_LESS_EQUAL, 2.0);
+								}
+							}
+						}
+					}
+				}
+			}
+		});
+	}
+	
+	//a consumer can only be served by one provider in each time slot and channel
+	// C15
+	if (debugConstraints)
+		cout << "Consumer only one provider constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numT, numT * numDev * numCont * numChan, [&](d2dConstraintBuffer &conBuf, uint32_t d_cns) {
+		for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+			for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+				for (uint32_t n = 0; n<contentVector.size(); n++) {	
+					for (uint32_t c = 0; c<channelVector.size(); c++) {
+						conBuf.addTerm(h(d_prv, d_cns, n, c, t), 1.0);
+					}
+				}
+			}
+			conBuf.endRow(D2D_LESS_EQUAL, 1.0);
+			if (setConstraintNames) {
+				std::stringstream sstm;
+				sstm << "CnsServedByOnePrv[d_c-" << d_cns << "][t-" << t << "]";
+				conBuf.nameRow(sstm.str());
+			}
+		}
+	});
+	
+	//interference avoidance constraint
+	// C16
+	// (1 - s) + (1 - X) + (1 - r) + sum h >= 1
+	// rows with X = 0 are always satisfied and therefore skipped, only the pairs of interferenceList are visited
+	if (debugConstraints)
+		cout << "interference constraint" << endl;
+	updateInterferenceList();
+	addConstrsParallel(deviceVector.size(), 0, 0, [&](d2dConstraintBuffer &conBuf, uint32_t d_tx) {
+		for (uint32_t c_tx = 0; c_tx < channelVector.size(); c_tx++) {	
+			const std::vector< std::pair<uint32_t, uint32_t> > &receivers = interferenceList[d_tx * numChan + c_tx];
+			for (uint32_t i = 0; i<receivers.size(); i++) {	
+				uint32_t d_rx = receivers[i].first;
+				uint32_t c_rx = receivers[i].second;
 				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				
-					std::stringstream sstm;
-					if (setVariableNames) {
-						sstm << "p[d-" << d << "][n-" << n << "][t-" << t  << "]";
+					conBuf.addTerm(s(d_tx, c_tx, t), -1.0);
+					conBuf.addTerm(r(d_rx, c_rx, t), -1.0);
+					for (uint32_t n = 0; n<contentVector.size(); n++) {
+								
+						//exchange channel should be the transmitting channel
+						conBuf.addTerm(h(d_tx, d_rx, n, c_tx, t), 1.0);
+					}
+					conBuf.endRow(D2D_GREATER_EQUAL, -1.0);
+					if (setConstraintNames) {
+						std::stringstream sstm;
+						sstm << "Interference[d_tx-" << d_tx << "][c_tx-" << c_tx << "][d_rx-" << d_rx << "][c_rx-" << c_rx << "][t-" << t << "]";
+						conBuf.nameRow(sstm.str());
 					}
-					p[d][n][t] = model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
 				}
 			}
 		}
+	});
+	
+	// state constraints
+	
+	//each device in one state max..
+	// C 17
+	if (debugConstraints)
+		cout << "one state max constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numT, numT * (1 + 3 * numChan + 3 * numDev), [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+			
+			conBuf.addTerm(S_Idle(d, t), 1.0);
+			for (uint32_t c = 0; c < channelVector.size(); c++) {
+				conBuf.addTerm(S_StartAP(d, c, t), 1.0);
+				conBuf.addTerm(S_SwitchAP(d, c, t), 1.0);
+				conBuf.addTerm(S_AP(d, c, t), 1.0);
+			}
+			
+			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+				conBuf.addTerm(S_StartClient(d, d_ap, t), 1.0);
+				conBuf.addTerm(S_JoinAP(d, d_ap, t), 1.0);
+				conBuf.addTerm(S_Client(d, d_ap, t), 1.0);
+			}
+			
+			conBuf.endRow(D2D_EQUAL, 1.0);
+		}
+	});
+	
+	// allowed state changes to S_Idle
+	if (debugConstraints)
+		cout << "state transition to S_Idle constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numT, numT * 2, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
 		
-		// State Variables		
-		S_Idle 		= new GRBVar*[deviceVector.size()]; 
-		S_StartAP	= new GRBVar**[deviceVector.size()]; 
-		S_SwitchAP	= new GRBVar**[deviceVector.size()]; 
-		S_AP		= new GRBVar**[deviceVector.size()]; 
+		//C18
+		if (!useTemplate) {
+			conBuf.addTerm(S_Idle(d, 0), 1.0);
+			conBuf.endRow(D2D_LESS_EQUAL, START_Idle[d]);
+		}
 		
-		S_StartClient	= new GRBVar**[deviceVector.size()]; 
-		S_JoinAP		= new GRBVar**[deviceVector.size()]; 
-		S_Client		= new GRBVar**[deviceVector.size()]; 
+		for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
+			//C19
+			conBuf.addTerm(S_Idle(d, t), 1.0);
+			conBuf.addTerm(S_Idle(d, t-1), -1.0);
+			conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+		}	
+	});
+	
+	// allowed state changes to S_StartAP
+	if (debugConstraints)
+		cout << "state transition to S_StartAP constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numChan * numT, numChan * numT * (2 + numChan + numDev), [&](d2dConstraintBuffer &conBuf, uint32_t d) {
 		
+		//Constraint transitions to state S_StartAP for t = 0
+		int sumStartStates = START_Idle[d];
+		for (uint32_t c_ap = 0; c_ap < channelVector.size(); c_ap++) {
+			sumStartStates +=  START_AP[d][c_ap];	
+		}
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			sumStartStates += START_Client[d][d_ap];	
+		}
 		
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
+		for (uint32_t c = 0; c < channelVector.size(); c++) {
 			
-			S_Idle[d] =  new GRBVar[settings.numTimeSlots]; 
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				std::stringstream sstm;
-				if (setVariableNames) {
-					sstm << "S_Idle[d-" << d << "][t-" << t  << "]";
-				}
-				S_Idle[d][t] = model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
+			// C20
+			if (!useTemplate) {
+				conBuf.addTerm(S_StartAP(d, c, 0), 1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, sumStartStates);
 			}
+						
+			for (int64_t t = 1; t<settings.numTimeSlots - settings.kappa_startAP - 1; t++) {	
 			
-			S_StartAP[d]	= new GRBVar*[channelVector.size()]; 
-			S_SwitchAP[d]	= new GRBVar*[channelVector.size()]; 
-			S_AP[d]			= new GRBVar*[channelVector.size()]; 
-			for (uint32_t c = 0; c<channelVector.size(); c++) {	
-				
-				S_StartAP[d][c]		= new GRBVar[settings.numTimeSlots]; 
-				S_SwitchAP[d][c]	= new GRBVar[settings.numTimeSlots]; 
-				S_AP[d][c]			= new GRBVar[settings.numTimeSlots]; 
-				
-				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-					std::stringstream sstm;
-					if (setVariableNames) {
-						sstm << "S_StartAP[d-" << d << "][c-" << c <<"][t-" << t  << "]";
-					}
-					S_StartAP[d][c][t] 	= model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
-					
-					if (setVariableNames) {					
-						sstm.str("");
-						sstm << "S_SwitchAP[d-" << d << "][c-" << c << "][t-" << t  << "]";
-					}
-					S_SwitchAP[d][c][t] = model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
-					
-					if (setVariableNames) {
-						sstm.str("");
-						sstm << "S_AP[d-" << d << "][c-" << c << "][t-" << t  << "]";
-					}
-					S_AP[d][c][t] 		= model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
+				//C21	
+				conBuf.addTerm(S_StartAP(d, c, t), 1.0);
+				conBuf.addTerm(S_Idle(d, t-1), -1.0);
+				for (uint32_t c_ap = 0; c_ap < channelVector.size(); c_ap++) {
+					conBuf.addTerm(S_AP(d, c_ap, t-1), -1.0);
+				}
+				for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+					conBuf.addTerm(S_Client(d, d_ap, t-1), -1.0);
 				}
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
 			}
 			
-			S_StartClient[d]	= new GRBVar*[deviceVector.size()]; 
-			S_JoinAP[d]			= new GRBVar*[deviceVector.size()]; 
-			S_Client[d]			= new GRBVar*[deviceVector.size()]; 
-			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-				
-				S_StartClient[d][d_ap]	= new GRBVar[settings.numTimeSlots]; 
-				S_JoinAP[d][d_ap]		= new GRBVar[settings.numTimeSlots]; 
-				S_Client[d][d_ap]		= new GRBVar[settings.numTimeSlots];
-
-				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-					std::stringstream sstm;
-					if (setVariableNames) {
-						sstm << "S_StartClient[d-" << d << "][d_ap-" << d_ap << "][t-" << t  << "]";
-					}
-					S_StartClient[d][d_ap][t]	= model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
-					
-					if (setVariableNames) {
-						sstm.str("");
-						sstm << "S_JoinAP[d-" << d << "][d_ap-" << d_ap << "][t-" << t  << "]";
-					}
-					S_JoinAP[d][d_ap][t]		= model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
-					
-					if (setVariableNames) {
-						sstm.str("");
-						sstm << "S_Client[d-" << d << "][d_ap-" << d_ap << "][t-" << t  << "]";
-					}
-					S_Client[d][d_ap][t]		= model->addVar(0.0, 1.0, 0.0, GRB_BINARY, sstm.str());
+			//S_StartAP not allowed if start AP cannot be finished in the super slot
+			// C22
+			for (int64_t t = settings.numTimeSlots - settings.kappa_startAP - 1; t<settings.numTimeSlots; t++) {	
+				if (t >= 0) {
+					conBuf.addTerm(S_StartAP(d, c, t), 1.0);
+					conBuf.endRow(D2D_EQUAL, 0.0);
 				}
 			}			
 		}
+	});
+
 	
-		model->update();
+	//Constraint transitions to state S_SwitchAP
+	if (debugConstraints)
+		cout << "state transition to S_SwitchAP constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numChan * numT * 2, numChan * numT * (settings.kappa_startAP + 4), [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t c = 0; c < channelVector.size(); c++) {
+			//C23
+			conBuf.addTerm(S_SwitchAP(d, c, 0), 1.0);
+			conBuf.addTerm(S_StartAP(d, c, 0), -1.0);
+			conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+		}
 		
-		cout << "Num Vars " <<  model->get(GRB_IntAttr_NumVars) << endl;
-	
-		GRBLinExpr objExpr = 0;
-		for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
-			for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
-				for (uint32_t n = 0; n<contentVector.size(); n++) {	
-					for (uint32_t c = 0; c<channelVector.size(); c++) {	
-						for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-							
-							objExpr += y[d_prv][d_cns][n][c][t] * U[d_prv][d_cns][n];
-						}
-					}
+		for (uint32_t c = 0; c < channelVector.size(); c++) {
+			
+			for (int64_t t = 0; t<settings.numTimeSlots - settings.kappa_startAP - 1; t++) {	
+				
+				//C24
+				conBuf.addTerm(S_StartAP(d, c, t), settings.kappa_startAP);
+				for (int64_t t_sw = t; t_sw <= t + settings.kappa_startAP; t_sw++) {
+					conBuf.addTerm(S_SwitchAP(d, c, t_sw), -1.0);
 				}
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			}
+			
+			for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
+				//C25
+				conBuf.addTerm(S_SwitchAP(d, c, t), 1.0);
+				conBuf.addTerm(S_SwitchAP(d, c, t-1), -1.0);
+				conBuf.addTerm(S_StartAP(d, c, t-1), -1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			}
+		}	
+	});
+	
+	//Constraint transitions to state S_AP
+	if (debugConstraints)
+		cout << "state transition to S_AP constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numChan * numT, numChan * numT * 3, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t c = 0; c < channelVector.size(); c++) {
+			//Constraint transitions to state S_AP t = 0
+			//C26
+			if (!useTemplate) {
+				conBuf.addTerm(S_AP(d, c, 0), 1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, START_AP[d][c]);
+			}
+			
+			for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
+				//C27
+				conBuf.addTerm(S_AP(d, c, t), 1.0);
+				conBuf.addTerm(S_AP(d, c, t-1), -1.0);
+				conBuf.addTerm(S_SwitchAP(d, c, t-1), -1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
 			}
 		}
+	});
+
+	//Constraint transitions to state S_StartClient
+	if (debugConstraints)
+		cout << "state transition to S_StartClient constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numDev * numT, numDev * numT * (2 + numChan + numDev), [&](d2dConstraintBuffer &conBuf, uint32_t d) {
 		
-		model->setObjective(objExpr, GRB_MAXIMIZE );
-		model->update();
-		
-		
-		cout << "Adding constraints...." << endl;
+		//Constraint transitions to state S_Client for t = 0
+		int sumStartStates = START_Idle[d];
+		for (uint32_t c = 0; c < channelVector.size(); c++) {
+			sumStartStates +=  START_AP[d][c];	
+		}
+		for (uint32_t d_prev_ap = 0; d_prev_ap < deviceVector.size(); d_prev_ap++) {
+			sumStartStates += START_Client[d][d_prev_ap];	
+		}
 		
-		//Content availability, if a content is available at a device in the beginning of a super slot
-		// it should be available the whole duration of the super slot
-		//C1
-		if (debugConstraints)
-			cout << "p-start constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			for (uint32_t n = 0; n<contentVector.size(); n++) {	
-				std::stringstream sstm;
-				
-				if (P[d][n] == 1) {
-					
-					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-						//p_start1 C1 
-						if (setConstraintNames) {
-							sstm << "p_start1_d-" << d << "_n-" << n << "_t-"<< t << endl;
-						}
-						model->addConstr(p[d][n][t] == 1, sstm.str());
-					}
-				} else {
-					if (setConstraintNames) {
-						sstm << "p_start0_d-" << d << "_n-" << n << endl;
-					}
-					//p_start0 C2 
-					model->addConstr(p[d][n][0] == 0, sstm.str());
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			
+			//C28
+			if (!useTemplate) {
+				conBuf.addTerm(S_StartClient(d, d_ap, 0), 1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, sumStartStates);
+			}
+			
+			for (int64_t t = 1; t<settings.numTimeSlots - settings.kappa_startClient - 1; t++) {	
+			
+				//C29
+				conBuf.addTerm(S_StartClient(d, d_ap, t), 1.0);
+				conBuf.addTerm(S_Idle(d, t-1), -1.0);
+				for (uint32_t c = 0; c < channelVector.size(); c++) {
+					conBuf.addTerm(S_AP(d, c, t-1), -1.0);
+				}
+				for (uint32_t d_prev_ap = 0; d_prev_ap < deviceVector.size(); d_prev_ap++) {
+					conBuf.addTerm(S_Client(d, d_prev_ap, t-1), -1.0);
+				}
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			}
+			
+			//S_StartClient not allowed if not enough time slots to complete join process
+			for (int64_t t = settings.numTimeSlots - settings.kappa_startClient - 1; t<settings.numTimeSlots; t++) {
+				//C30
+				if (t >= 0) {
+					conBuf.addTerm(S_StartClient(d, d_ap, t), 1.0);
+					conBuf.endRow(D2D_EQUAL, 0.0);
 				}
 			}
 		}
-		
-		if (debugConstraints)
-			cout << "p-next constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			for (uint32_t n = 0; n<contentVector.size(); n++) {	
-				for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
-					
-					GRBLinExpr conExpr = 0;	
-					for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {	
-						for (uint32_t c = 0; c<channelVector.size(); c++) {
-							
-							if (L[d_prv][d][c] > 0) {
-								int64_t t_duration = ceil( (double)S[n] / (double)L[d_prv][d][c]);
-								
-								int64_t t_start = t - t_duration;
-								
-								if (t_start >= 0) {
-									conExpr += y[d_prv][d][n][c][t_start];
-									if (debugConstraints)
-										cout << "y[d_prv-" << d_prv << "][d-" << d << "][n-" << n <<  "][c-" << c << "][t_start-" << t_start << "]" << endl;
-								}
-							}
-						}
-					}
-					//p_next C3
-					model->addConstr(p[d][n][t] <= p[d][n][t-1] + conExpr, "p_next");				
+	});
+	
+	//Constraint transitions to state S_JoinAP
+	if (debugConstraints)
+		cout << "state transition to S_JoinAP constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numDev * numT * 2, numDev * numT * (settings.kappa_startClient + 4), [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			
+			//C31
+			conBuf.addTerm(S_JoinAP(d, d_ap, 0), 1.0);
+			conBuf.addTerm(S_StartClient(d, d_ap, 0), -1.0);
+			conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			
+			for (int64_t t = 0; t<settings.numTimeSlots - settings.kappa_startClient - 1; t++) {	
+				
+				//C32
+				conBuf.addTerm(S_StartClient(d, d_ap, t), settings.kappa_startClient);
+				for (int64_t t_sw = t; t_sw <= t + settings.kappa_startClient; t_sw++) {
+					conBuf.addTerm(S_JoinAP(d, d_ap, t_sw), -1.0);
 				}
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			}
+			
+			for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
+				//C33
+				conBuf.addTerm(S_JoinAP(d, d_ap, t), 1.0);
+				conBuf.addTerm(S_JoinAP(d, d_ap, t-1), -1.0);
+				conBuf.addTerm(S_StartClient(d, d_ap, t-1), -1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			}				
+		}
+	});
+	
+	//Constraint transitions to state S_Client
+	if (debugConstraints)
+		cout << "state transition to S_Client constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numDev * numT, numDev * numT * 3, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			//Constraint transitions to state S_Client t = 0
+			//C34
+			if (!useTemplate) {
+				conBuf.addTerm(S_Client(d, d_ap, 0), 1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, START_Client[d][d_ap]);
 			}
+			
+			for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
+				//C35
+				conBuf.addTerm(S_Client(d, d_ap, t), 1.0);
+				conBuf.addTerm(S_Client(d, d_ap, t-1), -1.0);
+				conBuf.addTerm(S_JoinAP(d, d_ap, t-1), -1.0);
+				conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+			}	
 		}
+	});
+	
+	//only one ap per channel
+	if (debugConstraints)
+		cout << "APperChan constraint" << endl;
+	if (!channelReuse) {
+		addConstrsParallel(channelVector.size(), numT, numT * numDev, [&](d2dConstraintBuffer &conBuf, uint32_t c) {
 		
-		if (debugConstraints)
-			cout << "c4 - c11 constraint" << endl;		
-		for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
-			for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
-				for (uint32_t n = 0; n<contentVector.size(); n++) {	
-					for (uint32_t c = 0; c<channelVector.size(); c++) {	
-						for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-							
-							if (debugConstraints)
-								cout << "d_prv " << d_prv << " d_cns " << d_cns << " n " << n << " c " << c << " t " << t << endl;
-							
+			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+				
+				for (uint32_t d = 0; d<deviceVector.size(); d++) {	
+					conBuf.addTerm(S_AP(d, c, t), 1.0);
+				}
+				//C36
+				conBuf.endRow(D2D_LESS_EQUAL, 1.0);
+				if (setConstraintNames) {
+					std::stringstream sstm;
+					sstm << "APperChan[c-" << c << "][t-" << t << "]";
+					conBuf.nameRow(sstm.str());
+				}
+			}	
+		});
+	} else {
+		//spatial reuse, only APs interfering with each other exclude each other
+		//each pair is added by the lower device unless only the higher device interferes with it
+		updateInterferenceList();
+		addConstrsParallel(deviceVector.size(), 0, 0, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+			for (uint32_t c = 0; c < channelVector.size(); c++) {	
+				const std::vector< std::pair<uint32_t, uint32_t> > &receivers = interferenceList[d * numChan + c];
+				for (uint32_t i = 0; i<receivers.size(); i++) {	
+					uint32_t d_int = receivers[i].first;
+					if (receivers[i].second != c || (d_int < d && X[d_int][c][d][c] == 1)) {
+						continue;
+					}
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						//C36
+						conBuf.addTerm(S_AP(d, c, t), 1.0);
+						conBuf.addTerm(S_AP(d_int, c, t), 1.0);
+						conBuf.endRow(D2D_LESS_EQUAL, 1.0);
+						if (setConstraintNames) {
 							std::stringstream sstm;
-							//
-							//	Content provider must have the content C4
-							//
-							if (setConstraintNames) {
-								sstm << "ProvideContent[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-							}
-							model->addConstr(y[d_prv][d_cns][n][c][t] <= p[d_prv][n][t] , "ProvideContent");
-							
-							//
-							//	Content cosnumer must be interested C5
-							//
-							if (setConstraintNames) {
-								sstm.str("");
-								sstm << "InterestContent[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-							}
-							model->addConstr(y[d_prv][d_cns][n][c][t] <= I[d_cns][n], "InterestContent");
-							
-							//
-							//	Content provider and consumer must be able to use the channel C6
-							//
-							if (setConstraintNames) {
-								sstm.str("");
-								sstm << "ChannelSupport[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";	
-							}
-							model->addConstr(2*y[d_prv][d_cns][n][c][t] <= W[d_cns][c] +  W[d_prv][c] , "ChannelSupport");
-							
-							//
-							// Connectivity requirement C7
-							///
-							
-							if (setConstraintNames) {
-								sstm.str("");
-								sstm << "Connectivity[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-							}
-							model->addConstr( (1 - y[d_prv][d_cns][n][c][t]) + ceil(L[d_prv][d_cns][c]) >= 1, sstm.str());
-															
-							//helper variables
-							//set for all time slots in which content exchange occur
-							if (L[d_prv][d_cns][c] > 0) {
-								int64_t t_max_new = t + ceil( (double)S[n] / (double)L[d_prv][d_cns][c]);
-								
-								//only schedule if t_max_new is not larger than superslot length
-								if (t_max_new <= settings.numTimeSlots) {
-								
-									for (int64_t t_new = t; t_new < t_max_new; t_new++) {	
-										// C9
-										//helper variable sending mode
-										if (setConstraintNames) {
-											sstm.str("");
-											sstm << "s_helper[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-											//sstm << "_t-n-" << t_new << "_S-n-" << S[n] << "_L-" << L[d_prv][d_cns][c];
-										}
-										model->addConstr( s[d_prv][c][t_new] >=  y[d_prv][d_cns][n][c][t], sstm.str());
-										
-										//C 10
-										//helper variable receiving mode
-										if (setConstraintNames) {
-											sstm.str("");
-											sstm << "r_helper[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-										}
-										model->addConstr( r[d_cns][c][t_new] >=  y[d_prv][d_cns][n][c][t], sstm.str());
-										
-										// C11
-										//helper variable exchange mode
-										if (setConstraintNames) {
-											sstm.str("");
-											sstm << "h_helper[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-										}
-										model->addConstr( h[d_prv][d_cns][n][c][t_new] >=  y[d_prv][d_cns][n][c][t], sstm.str());
-											
-									}									
-	
-								} 						
-								//
-								// Content exchange must fit into superslot C9
-								//
-
-								// A content exchange must fit into super slot. An exchange cannot be scheduled at the end of a super slot, if the transfer cannot be finished within the super slot.
-								// C8
-								if (setConstraintNames) {
-									sstm.str("");
-									sstm << "ExchangeMustFit[d_p-" << d_prv << "][d_c-" << d_cns  << "][n-" << n << "][c-" << c << "][t-" << t << "]";
-								}
-								model->addConstr(y[d_prv][d_cns][n][c][t] * ( (((double) t) / ((double) settings.numTimeSlots)) * settings.tau + ((double)S[n]) / ((double)L[d_prv][d_cns][c])) <= settings.tau , sstm.str());				
-							}	
+							sstm << "APperChan[d-" << d << "][d_int-" << d_int << "][c-" << c << "][t-" << t << "]";
+							conBuf.nameRow(sstm.str());
 						}
 					}
 				}
 			}
+		});
+	}
+	
+	//Clients can only connect to APs
+	if (debugConstraints)
+		cout << "ClientsConnectAP constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numDev * numT * 3, numDev * numT * 3 * (1 + numChan), [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+			
+				//C36 - C38
+				d2dVar clientStates[3] = { S_StartClient(d, d_ap, t), S_JoinAP(d, d_ap, t), S_Client(d, d_ap, t) };
+				for (int i = 0; i<3; i++) {
+					conBuf.addTerm(clientStates[i], 1.0);
+					for (uint32_t c = 0; c<channelVector.size(); c++) {	
+						conBuf.addTerm(S_AP(d_ap, c, t), -1.0);
+					}
+					conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+					if (setConstraintNames) {
+						std::stringstream sstm;
+						sstm << "ClientsConnectAP[d-" << d << "][d_ap-" << d_ap << "][t-" << t << "][" << i << "]";
+						conBuf.nameRow(sstm.str());
+					}
+				}
+			}
 		}
-		
-		
-		// Half-duplex constraint
-		// C12
-		if (debugConstraints)
-			cout << "Half-duplex constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {	
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {
-				GRBLinExpr conExpr = 0;	
-				for (uint32_t c = 0; c<channelVector.size(); c++) {
-						conExpr += s[d][c][t] + r[d][c][t];
+	});
+	
+	//a client cant connect to itself
+	if (debugConstraints)
+		cout << "NoSelfService constraint" << endl;
+	addConstrsParallel(deviceVector.size(), numT * 3, numT * 3, [&](d2dConstraintBuffer &conBuf, uint32_t d) {
+		for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+			//C39 - C41
+			d2dVar clientStates[3] = { S_StartClient(d, d, t), S_JoinAP(d, d, t), S_Client(d, d, t) };
+			for (int i = 0; i<3; i++) {
+				conBuf.addTerm(clientStates[i], 1.0);
+				conBuf.endRow(D2D_EQUAL, 0.0);
+				if (setConstraintNames) {
+					std::stringstream sstm;
+					sstm << "NoSelfService[d-" << d << "][t-" << t << "][" << i << "]";
+					conBuf.nameRow(sstm.str());
 				}
-				model->addConstr(conExpr <= 1 ,"half-duplex");
 			}
 		}
-		
-		//each consumer should only receive the content once
-		// C13
-		if (debugConstraints)
-			cout << "Consumer content only once constraint" << endl;
+	});
+	
+	
+	// if content exchange, one device must be AP and the other client of this AP
+	// with channelReuse two APs on the same channel also satisfy C42, the exchange additionally requires
+	// one device to be client of the other
+	if (debugConstraints)
+		cout << "one device AP, one client, constraint" << endl;
+	uint64_t connectRows = channelReuse ? 2 : 1;
+	addConstrsParallel(deviceVector.size(), numDev * numCont * numChan * numT * connectRows, numDev * numCont * numChan * numT * (2 + 3 * connectRows), [&](d2dConstraintBuffer &conBuf, uint32_t d_prv) {
 		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
 			for (uint32_t n = 0; n<contentVector.size(); n++) {	
-				
-				GRBLinExpr conExpr = 0;	
-				for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
 					for (uint32_t c = 0; c<channelVector.size(); c++) {
-						for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-							conExpr += y[d_prv][d_cns][n][c][t];
+								
+						//C42
+						conBuf.addTerm(h(d_prv, d_cns, n, c, t), 2.0);
+						conBuf.addTerm(S_AP(d_prv, c, t), -1.0);
+						conBuf.addTerm(S_AP(d_cns, c, t), -1.0);
+						conBuf.addTerm(S_Client(d_cns, d_prv, t), -1.0);
+						conBuf.addTerm(S_Client(d_prv, d_cns, t), -1.0);
+						conBuf.endRow(D2D_LESS_EQUAL, 0.0);
+						
+						if (channelReuse) {
+							conBuf.addTerm(h(d_prv, d_cns, n, c, t), 1.0);
+							conBuf.addTerm(S_Client(d_cns, d_prv, t), -1.0);
+							conBuf.addTerm(S_Client(d_prv, d_cns, t), -1.0);
+							conBuf.endRow(D2D_LESS_EQUAL, 0.0);
 						}
 					}
 				}
-				model->addConstr(P[d_cns][n] + conExpr <= 1 ,"CnsContentOnce");
 			}
 		}
+	});
+	
+	cout << "Num Constraints " <<  backend->numConstrs() << endl;
+	
+	varLb.assign(backend->numVars(), 0.0);
+	varUb.assign(backend->numVars(), 1.0);
+	if (useTemplate) {
+		setTemplateBounds();
+	}
+}
 
-		//a provider can only  serve one consumer in each time slot and channel
-		// C14
-		if (debugConstraints)
-			cout << "Provider only one consumer constraint" << endl;
-		for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				GRBLinExpr conExpr = 0;	
-				for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {
-					for (uint32_t n = 0; n<contentVector.size(); n++) {	
-						for (uint32_t c = 0; c<channelVector.size(); c++) {
-							conExpr += h[d_prv][d_cns][n][c][t];
-						}
-					}
+void d2dOptimizer::buildObjective() {
+	// only non-zero utilities contribute to the objective
+	std::vector<double> objCoeffs;
+	std::vector<d2dVar> objVars;
+	for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
+			for (uint32_t n = 0; n<contentVector.size(); n++) {	
+				if (U[d_prv][d_cns][n] == 0.0) {
+					continue;
 				}
-				model->addConstr(conExpr <= 1, "PrvOnlyOneConsumer");
-			}
-		}
-		
-		//a consumer can only be served by one provider in each time slot and channel
-		// C15
-		if (debugConstraints)
-			cout << "Consumer only one provider constraint" << endl;
-		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				GRBLinExpr conExpr = 0;	
-				for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
-					for (uint32_t n = 0; n<contentVector.size(); n++) {	
-						for (uint32_t c = 0; c<channelVector.size(); c++) {
-							conExpr += h[d_prv][d_cns][n][c][t];
-						}
+				for (uint32_t c = 0; c<channelVector.size(); c++) {	
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						objCoeffs.push_back(exchangeUtility(d_prv, d_cns, n, c, t));
+						objVars.push_back(y(d_prv, d_cns, n, c, t));
 					}
 				}
-				model->addConstr(conExpr <= 1, "CnsServedByOnePrv");
 			}
 		}
-		
-		//interference avoidance constraint
-		// C16
-		if (debugConstraints)
-			cout << "interference constraint" << endl;
-		for (uint32_t d_tx = 0; d_tx<deviceVector.size(); d_tx++) {
-			for (uint32_t c_tx = 0; c_tx < channelVector.size(); c_tx++) {	
-				for (uint32_t d_rx = 0; d_rx<deviceVector.size(); d_rx++) {	
-					if (d_tx == d_rx) {
-						continue;
-					}
-					for (uint32_t c_rx = 0; c_rx < channelVector.size(); c_rx++) {	
-						for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-							GRBLinExpr sumHExpr = 0;	
-							for (uint32_t n = 0; n<contentVector.size(); n++) {
-										
-								//exchange channel should be the transmitting channel
-								sumHExpr +=  h[d_tx][d_rx][n][c_tx][t];
-							}
-							model->addConstr((1 -  s[d_tx][c_tx][t]) + (1 - X[d_tx][c_tx][d_rx][c_rx]) + (1 - r[d_rx][c_rx][t]) + sumHExpr >= 1, "Interference");
-						}
-					}
-				}
+	}
+	
+	//roles at the end of the superslot carried into the next one
+	uint32_t numDev 	= deviceVector.size();
+	uint32_t numChan 	= channelVector.size();
+	int64_t tEnd 		= settings.numTimeSlots - 1;
+	for (uint32_t d = 0; d<numDev && tEnd >= 0; d++) {
+		for (uint32_t c = 0; c<numChan && !terminalAP.empty(); c++) {
+			if (terminalAP[d * numChan + c] != 0.0) {
+				objCoeffs.push_back(terminalAP[d * numChan + c]);
+				objVars.push_back(S_AP(d, c, tEnd));
 			}
 		}
-		
-		// state constraints
-		
-		//each device in one state max..
-		// C 17
-		if (debugConstraints)
-			cout << "one state max constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				
-				GRBLinExpr sumAPStates = 0;	 
-				for (uint32_t c = 0; c < channelVector.size(); c++) {
-					sumAPStates += S_StartAP[d][c][t] +   S_SwitchAP[d][c][t] + S_AP[d][c][t];	
-					//sumAPStates +=   S_SwitchAP[d][c][t] + S_AP[d][c][t];	
-				}
-				
-				GRBLinExpr sumClientStates = 0;	 
-				for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-					sumClientStates += S_StartClient[d][d_ap][t] +  S_JoinAP[d][d_ap][t] + S_Client[d][d_ap][t];	
-					//sumClientStates +=   S_JoinAP[d][d_ap][t] + S_Client[d][d_ap][t];
-				}
-				
-				model->addConstr(S_Idle[d][t] + sumAPStates + sumClientStates == 1);
+		for (uint32_t d_ap = 0; d_ap<numDev && !terminalClient.empty(); d_ap++) {
+			if (terminalClient[d * numDev + d_ap] != 0.0) {
+				objCoeffs.push_back(terminalClient[d * numDev + d_ap]);
+				objVars.push_back(S_Client(d, d_ap, tEnd));
 			}
 		}
-		
-		// allowed state changes to S_Idle
-		if (debugConstraints)
-			cout << "state transition to S_Idle constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			
-			//C18
-			model->addConstr(S_Idle[d][0]<= START_Idle[d]);
-			
-			for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
-				//C19
-				model->addConstr(S_Idle[d][t] <= S_Idle[d][t-1]);
-			}	
+	}
+	for (uint32_t i = 0; i<extraObjective.size(); i++) {
+		objVars.push_back(extraObjective[i].first);
+		objCoeffs.push_back(extraObjective[i].second);
+	}
+	backend->setObjective(objVars, objCoeffs, D2D_MAXIMIZE);
+}
+
+uint64_t d2dOptimizer::templateShape() {
+	uint32_t numDev 	= deviceVector.size();
+	uint32_t numChan 	= channelVector.size();
+	uint32_t numCont 	= contentVector.size();
+	updateInterferenceList();
+	
+	uint64_t shape = d2dHashCombine(0, numDev);
+	shape = d2dHashCombine(shape, numChan);
+	shape = d2dHashCombine(shape, numCont);
+	shape = d2dHashCombine(shape, settings.numTimeSlots);
+	shape = d2dHashCombine(shape, d2dHashDouble(settings.tau));
+	shape = d2dHashCombine(shape, settings.kappa_startAP);
+	shape = d2dHashCombine(shape, settings.kappa_startClient);
+	shape = d2dHashCombine(shape, channelReuse);
+	shape = d2dHashCombine(shape, multicast);
+	shape = d2dHashCombine(shape, airtimeSharing);
+	shape = d2dHashCombine(shape, setConstraintNames);
+	shape = d2dHashCombine(shape, setVariableNames);
+	for (uint32_t n = 0; n<numCont; n++) {
+		shape = d2dHashCombine(shape, S[n]);
+	}
+	for (uint32_t d = 0; d<numDev; d++) {
+		shape = d2dHashCombine(shape, freeStorage(d));
+		for (uint32_t n = 0; n<numCont; n++) {
+			shape = d2dHashCombine(shape, D[d][n]);
+		}
+		for (uint32_t c = 0; c<numChan; c++) {
+			shape = d2dHashCombine(shape, W[d][c]);
+			const std::vector< std::pair<uint32_t, uint32_t> > &receivers = interferenceList[d * numChan + c];
+			shape = d2dHashCombine(shape, receivers.size());
+			for (uint32_t i = 0; i<receivers.size(); i++) {
+				shape = d2dHashCombine(d2dHashCombine(shape, receivers[i].first), receivers[i].second);
+			}
 		}
-		
-		// allowed state changes to S_StartAP
-		if (debugConstraints)
-			cout << "state transition to S_StartAP constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {
-			for (uint32_t c = 0; c < channelVector.size(); c++) {
-				
-				//Constraint transitions to state S_StartAP for t = 0
-				GRBLinExpr sumAPStates = 0;	 
-				for (uint32_t c_ap = 0; c_ap < channelVector.size(); c_ap++) {
-					sumAPStates +=  START_AP[d][c_ap];	
-				}
-				GRBLinExpr sumClientStates = 0;	 
-				for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-					sumClientStates += START_Client[d][d_ap];	
-				}
-				// C20
-				model->addConstr(S_StartAP[d][c][0] <=  START_Idle[d] + sumAPStates + sumClientStates);
-							
-				for (int64_t t = 1; t<settings.numTimeSlots - settings.kappa_startAP - 1; t++) {	
-				
-					GRBLinExpr sumAPStates = 0;	 
-					for (uint32_t c_ap = 0; c_ap < channelVector.size(); c_ap++) {
-						sumAPStates +=  S_AP[d][c_ap][t-1];	
-					}
-					GRBLinExpr sumClientStates = 0;	 
-					for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-						sumClientStates += S_Client[d][d_ap][t-1];	
-					}
-					//C21	
-					model->addConstr(S_StartAP[d][c][t] <=  S_Idle[d][t-1] + sumAPStates + sumClientStates);
-				}
-				
-				//S_StartAP not allowed if start AP cannot be finished in the super slot
-				// C22
-				for (int64_t t = settings.numTimeSlots - settings.kappa_startAP - 1; t<settings.numTimeSlots; t++) {	
-					if (t >= 0) {
-						model->addConstr(S_StartAP[d][c][t] == 0);
-					}
-				}			
+		for (uint32_t d_cns = 0; d_cns<numDev; d_cns++) {
+			for (uint32_t c = 0; c<numChan; c++) {
+				shape = d2dHashCombine(shape, L[d][d_cns][c]);
 			}
 		}
+	}
+	return shape;
+}
 
-		
-		//Constraint transitions to state S_SwitchAP
-		if (debugConstraints)
-			cout << "state transition to S_SwitchAP constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {		
-			for (uint32_t c = 0; c < channelVector.size(); c++) {
-				//C23
-				model->addConstr(S_SwitchAP[d][c][0] <=  S_StartAP[d][c][0]);
+void d2dOptimizer::setTemplateBounds() {
+	varLb.assign(backend->numVars(), 0.0);
+	varUb.assign(backend->numVars(), 1.0);
+	
+	for (uint32_t d = 0; d<deviceVector.size(); d++) {
+		for (uint32_t n = 0; n<contentVector.size(); n++) {
+			//C1, C2
+			if (P[d][n] == 1) {
+				for (int64_t t = 0; t<settings.numTimeSlots; t++) {
+					varLb[p(d, n, t)] = 1.0;
+				}
+			} else {
+				varUb[p(d, n, 0)] = 0.0;
 			}
 			
-			for (uint32_t c = 0; c < channelVector.size(); c++) {
-				
-				for (int64_t t = 0; t<settings.numTimeSlots - settings.kappa_startAP - 1; t++) {	
-					
-					GRBLinExpr sumSwitchStates = 0;	 
-					for (int64_t t_sw = t; t_sw <= t + settings.kappa_startAP; t_sw++) {
-						sumSwitchStates += S_SwitchAP[d][c][t_sw];	
+			//C5 and content held by the consumer (C13)
+			if (I[d][n] < 1 || P[d][n] == 1) {
+				for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+					for (uint32_t c = 0; c<channelVector.size(); c++) {
+						for (int64_t t = 0; t<settings.numTimeSlots; t++) {
+							varUb[y(d_prv, d, n, c, t)] = 0.0;
+						}
 					}
-					//C24
-					model->addConstr(settings.kappa_startAP * S_StartAP[d][c][t] <=  sumSwitchStates);
-				}
-				
-				for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
-					//C25
-					model->addConstr(S_SwitchAP[d][c][t] <= S_SwitchAP[d][c][t-1] + S_StartAP[d][c][t-1]);
 				}
-			}	
+			}
 		}
 		
-		//Constraint transitions to state S_AP
-		if (debugConstraints)
-			cout << "state transition to S_AP constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {		
-			for (uint32_t c = 0; c < channelVector.size(); c++) {
-				//Constraint transitions to state S_AP t = 0
-				//C26
-				model->addConstr(S_AP[d][c][0] <=  START_AP[d][c]);
-				
-				for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
-					//C27
-					model->addConstr(S_AP[d][c][t] <=  S_AP[d][c][t-1] + S_SwitchAP[d][c][t-1]);
-				}
-			}
+		//initial states C18, C20, C26, C28, C34
+		int sumStartStates = START_Idle[d];
+		for (uint32_t c = 0; c<channelVector.size(); c++) {
+			sumStartStates += START_AP[d][c];
 		}
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			sumStartStates += START_Client[d][d_ap];
+		}
+		varUb[S_Idle(d, 0)] = std::min(START_Idle[d], 1);
+		for (uint32_t c = 0; c<channelVector.size(); c++) {
+			varUb[S_StartAP(d, c, 0)] 	= std::min(sumStartStates, 1);
+			varUb[S_AP(d, c, 0)] 		= std::min(START_AP[d][c], 1);
+		}
+		for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+			varUb[S_StartClient(d, d_ap, 0)] 	= std::min(sumStartStates, 1);
+			varUb[S_Client(d, d_ap, 0)] 		= std::min(START_Client[d][d_ap], 1);
+		}
+	}
+	backend->setBounds(varLb, varUb);
+}
 
-		//Constraint transitions to state S_StartClient
-		if (debugConstraints)
-			cout << "state transition to S_StartClient constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {	
-			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-				
-				//Constraint transitions to state S_Client for t = 0
-				GRBLinExpr sumAPStates = 0;	 
-				for (uint32_t c = 0; c < channelVector.size(); c++) {
-					sumAPStates +=  START_AP[d][c];	
-				}
-				GRBLinExpr sumClientStates = 0;	 
-				for (uint32_t d_prev_ap = 0; d_prev_ap < deviceVector.size(); d_prev_ap++) {
-					sumClientStates += START_Client[d][d_prev_ap];	
-				}
-				//C28
-				model->addConstr(S_StartClient[d][d_ap][0] <=  START_Idle[d] + sumAPStates + sumClientStates);
-				
-				for (int64_t t = 1; t<settings.numTimeSlots - settings.kappa_startClient - 1; t++) {	
-				
-					GRBLinExpr sumAPStates = 0;	 
-					for (uint32_t c = 0; c < channelVector.size(); c++) {
-						sumAPStates +=  S_AP[d][c][t-1];	
-					}
-					GRBLinExpr sumClientStates = 0;	 
-					for (uint32_t d_prev_ap = 0; d_prev_ap < deviceVector.size(); d_prev_ap++) {
-						sumClientStates += S_Client[d][d_prev_ap][t-1];	
-					}
-					//C29
-					model->addConstr(S_StartClient[d][d_ap][t] <=  S_Idle[d][t-1] + sumAPStates + sumClientStates);
-				}
-				
-				//S_StartClient not allowed if not enough time slots to complete join process
-				for (int64_t t = settings.numTimeSlots - settings.kappa_startClient - 1; t<settings.numTimeSlots; t++) {
-					//C30
-					if (t >= 0) {
-						model->addConstr(S_StartClient[d][d_ap][t] == 0);
+void d2dOptimizer::updateModel() {
+	cout << "Updating model template" << endl;
+	solution.clear();
+	buildObjective();
+	setTemplateBounds();
+}
+
+bool d2dOptimizer::readSolverParameters(const std::string &fname, std::vector< std::pair<std::string, std::string> > &params) {
+	std::ifstream infile(fname.c_str());
+	if (!infile.is_open()) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(infile, line)) {
+		std::istringstream iss(line);
+		std::string param, value;
+		if (!(iss >> param) || param[0] == '#') {
+			continue;
+		}
+		if (!(iss >> value)) {
+			cerr << "missing value of " << param << " in file " << fname << endl;
+			continue;
+		}
+		params.push_back(std::make_pair(param, value));
+	}
+	return true;
+}
+
+int32_t d2dOptimizer::solve() {
+	cout << "optimize..." << endl;
+	std::vector< std::pair<std::string, std::string> > params;
+	if (!parameterFile.empty() && readSolverParameters(parameterFile, params)) {
+		cout << "Solver parameters from " << parameterFile << endl;
+	}
+	params.insert(params.end(), solverParameters.begin(), solverParameters.end());
+	for (uint32_t i = 0; i<params.size(); i++) {
+		backend->setParam(params[i].first, params[i].second);
+	}
+	if (timeLimit > 0.0) {
+		std::stringstream sstm;
+		sstm << timeLimit;
+		backend->setParam("TimeLimit", sstm.str());
+	}
+	int32_t status = backend->optimize();
+	
+	if (backend->hasSolution()) {
+		backend->getValues(solution);
+		getSchedule(schedule);
+	}
+	
+	switch(status) {
+		case D2D_STATUS_OPTIMAL: 
+		case D2D_STATUS_FEASIBLE: 
+			if (debugResults) {
+				printResults();
+			}
+			break;
+		case D2D_STATUS_INFEASIBLE:
+			{
+				cout << "The model is infeasible; computing IIS" << endl;
+				std::vector<std::string> iis;
+				if (backend->computeIIS(iis)) {
+					cout << "\nThe following constraints cannot be satisfied:" << endl;
+					for (uint32_t i = 0; i<iis.size(); i++) {
+						cout << iis[i] << endl;
 					}
 				}
 			}
+			break;
+		case D2D_STATUS_EXPORTED:
+			break;
+		default:
+			cout << "Unknown solver state " << status << endl;	
+	}
+	return status;
+}
+
+void d2dOptimizer::scheduleToValues(const d2dSchedule &schedule, std::vector<double> &values) {
+	values.assign(backend->numVars(), 0.0);
+	
+	for (uint32_t d = 0; d<deviceVector.size(); d++) {
+		for (int64_t t = 0; t<settings.numTimeSlots; t++) {
+			uint32_t arg = schedule.getRoleArg(d, t);
+			switch (schedule.getRole(d, t)) {
+				case D2D_ROLE_IDLE:
+					values[S_Idle(d, t)] = 1.0;
+					break;
+				case D2D_ROLE_STARTAP:
+					values[S_StartAP(d, arg, t)] = 1.0;
+					break;
+				case D2D_ROLE_SWITCHAP:
+					values[S_SwitchAP(d, arg, t)] = 1.0;
+					break;
+				case D2D_ROLE_AP:
+					values[S_AP(d, arg, t)] = 1.0;
+					break;
+				case D2D_ROLE_STARTCLIENT:
+					values[S_StartClient(d, arg, t)] = 1.0;
+					break;
+				case D2D_ROLE_JOINAP:
+					values[S_JoinAP(d, arg, t)] = 1.0;
+					break;
+				case D2D_ROLE_CLIENT:
+					values[S_Client(d, arg, t)] = 1.0;
+					break;
+			}
 		}
 		
-		//Constraint transitions to state S_JoinAP
-		if (debugConstraints)
-			cout << "state transition to S_JoinAP constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {		
-			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-				
-				//C31
-				model->addConstr(S_JoinAP[d][d_ap][0] <=  S_StartClient[d][d_ap][0]);
-				
-				for (int64_t t = 0; t<settings.numTimeSlots - settings.kappa_startClient - 1; t++) {	
-					
-					GRBLinExpr sumSwitchStates = 0;	 
-					for (int64_t t_sw = t; t_sw <= t + settings.kappa_startClient; t_sw++) {
-						sumSwitchStates += S_JoinAP[d][d_ap][t_sw];	
-					}
-					//C32
-					model->addConstr(settings.kappa_startClient * S_StartClient[d][d_ap][t] <=  sumSwitchStates);
+		for (uint32_t n = 0; n<contentVector.size(); n++) {
+			if (P[d][n] == 1) {
+				for (int64_t t = 0; t<settings.numTimeSlots; t++) {
+					values[p(d, n, t)] = 1.0;
 				}
-				
-				for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
-					//C33
-					model->addConstr(S_JoinAP[d][d_ap][t] <= S_JoinAP[d][d_ap][t-1] + S_StartClient[d][d_ap][t-1]);
-				}				
 			}
 		}
-		
-		//Constraint transitions to state S_Client
-		if (debugConstraints)
-			cout << "state transition to S_Client constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {		
-			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-				//Constraint transitions to state S_Client t = 0
-				//C34
-				model->addConstr(S_Client[d][d_ap][0] <=  START_Client[d][d_ap]);
-				
-				for (int64_t t = 1; t<settings.numTimeSlots; t++) {	
-					//C35
-					model->addConstr(S_Client[d][d_ap][t] <=  S_Client[d][d_ap][t-1] + S_JoinAP[d][d_ap][t-1]);
-				}	
+	}
+	
+	//multicast, the rate of a transmission is the slowest link speed of its consumers
+	std::unordered_map<uint64_t, long> transmissionRate;
+	if (multicast) {
+		for (uint32_t i = 0; i<schedule.exchanges.size(); i++) {
+			const d2dExchange &ex = schedule.exchanges[i];
+			uint64_t key = ((ex.d_prv * contentVector.size() + ex.n) * channelVector.size() + ex.c) * settings.numTimeSlots + ex.t;
+			long speed = L[ex.d_prv][ex.d_cns][ex.c];
+			if (transmissionRate.count(key) == 0 || speed < transmissionRate[key]) {
+				transmissionRate[key] = speed;
 			}
 		}
-		
-		//only one ap per channel
-		if (debugConstraints)
-			cout << "APperChan constraint" << endl;
-		for (uint32_t c = 0; c<channelVector.size(); c++) {	
-		
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				
-				GRBLinExpr linExpr = 0;	 
-				for (uint32_t d = 0; d<deviceVector.size(); d++) {	
-					linExpr += S_AP[d][c][t];
-				}
-				//C36
-				model->addConstr(linExpr <= 1, "APperChan");
-			}	
-		}
-		
-		//Clients can only connect to APs
-		if (debugConstraints)
-			cout << "ClientsConnectAP constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {	
-			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-				for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				
-					GRBLinExpr linExpr = 0;	 
-					for (uint32_t c = 0; c<channelVector.size(); c++) {	
-						linExpr += S_AP[d_ap][c][t];
-					}
-					//C36
-					model->addConstr(S_StartClient[d][d_ap][t] <= linExpr, "ClientsConnectAP");
-					//C37
-					model->addConstr(S_JoinAP[d][d_ap][t] <= linExpr, "ClientsConnectAP");
-					//C38
-					model->addConstr(S_Client[d][d_ap][t] <= linExpr, "ClientsConnectAP");
+	}
+	
+	for (uint32_t i = 0; i<schedule.exchanges.size(); i++) {
+		const d2dExchange &ex = schedule.exchanges[i];
+		values[y(ex.d_prv, ex.d_cns, ex.n, ex.c, ex.t)] = 1.0;
+		if (multicast) {
+			//fastest rate class with the duration of the transmission
+			uint64_t key = ((ex.d_prv * contentVector.size() + ex.n) * channelVector.size() + ex.c) * settings.numTimeSlots + ex.t;
+			for (int64_t k = multicastRates.size() - 1; k >= 0; k--) {
+				if (multicastRates[k] <= transmissionRate[key] && multicastDuration(ex.n, k) == ex.duration) {
+					values[m(ex.d_prv, ex.n, ex.c, ex.t, k)] = 1.0;
+					break;
 				}
 			}
 		}
-		
-		//a client cant connect to itself
-		if (debugConstraints)
-			cout << "NoSelfService constraint" << endl;
-		for (uint32_t d = 0; d<deviceVector.size(); d++) {	
-			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				//C39
-				model->addConstr(S_StartClient[d][d][t] == 0, "NoSelfService");
-				//C40
-				model->addConstr(S_JoinAP[d][d][t] == 0, "NoSelfService");
-				//C41
-				model->addConstr(S_Client[d][d][t] == 0, "NoSelfService");	
-			}
+		for (int64_t t = ex.t; t < ex.t + ex.duration && t < settings.numTimeSlots; t++) {
+			values[h(ex.d_prv, ex.d_cns, ex.n, ex.c, t)] = 1.0;
+			values[s(ex.d_prv, ex.c, t)] = 1.0;
+			values[r(ex.d_cns, ex.c, t)] = 1.0;
 		}
-		
-		
-		// if content exchange, one device must be AP and the other client of this AP
-		if (debugConstraints)
-			cout << "one device AP, one client, constraint" << endl;
-		for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {	
-			for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
-				for (uint32_t n = 0; n<contentVector.size(); n++) {	
-					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-						for (uint32_t c = 0; c<channelVector.size(); c++) {
-									
-							//C42
-							model->addConstr(2*h[d_prv][d_cns][n][c][t] <= S_AP[d_prv][c][t] + S_AP[d_cns][c][t] + S_Client[d_cns][d_prv][t] + S_Client[d_prv][d_cns][t]);
-						}
-					}
+		//the content is available at the consumer once the exchange is finished
+		for (int64_t t = ex.t + ex.duration; t < settings.numTimeSlots; t++) {
+			values[p(ex.d_cns, ex.n, t)] = 1.0;
+		}
+	}
+}
+
+void d2dOptimizer::setStart(const d2dSchedule &schedule) {
+	std::vector<double> values;
+	scheduleToValues(schedule, values);
+	backend->setStart(values);
+}
+
+void d2dOptimizer::getSchedule(d2dSchedule &schedule) {
+	getSchedule(solution, schedule);
+}
+
+void d2dOptimizer::getSchedule(const std::vector<double> &values, d2dSchedule &schedule) {
+	schedule.reset(deviceVector.size(), settings.numTimeSlots);
+	
+	for (uint32_t d = 0; d<deviceVector.size(); d++) {
+		for (int64_t t = 0; t<settings.numTimeSlots; t++) {
+			for (uint32_t c = 0; c<channelVector.size(); c++) {
+				if (values[S_StartAP(d, c, t)] > 0.5) {
+					schedule.setRole(d, t, D2D_ROLE_STARTAP, c);
+				} else if (values[S_SwitchAP(d, c, t)] > 0.5) {
+					schedule.setRole(d, t, D2D_ROLE_SWITCHAP, c);
+				} else if (values[S_AP(d, c, t)] > 0.5) {
+					schedule.setRole(d, t, D2D_ROLE_AP, c);
+				}
+			}
+			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
+				if (values[S_StartClient(d, d_ap, t)] > 0.5) {
+					schedule.setRole(d, t, D2D_ROLE_STARTCLIENT, d_ap);
+				} else if (values[S_JoinAP(d, d_ap, t)] > 0.5) {
+					schedule.setRole(d, t, D2D_ROLE_JOINAP, d_ap);
+				} else if (values[S_Client(d, d_ap, t)] > 0.5) {
+					schedule.setRole(d, t, D2D_ROLE_CLIENT, d_ap);
 				}
 			}
 		}
-		
-		model->update();
-		//model->write("debug.lp");
-			
-		cout << "optimize..." << endl;
-		model->optimize();
+	}
 	
-		status = model->get(GRB_IntAttr_Status);
-		switch(status) {
-			case GRB_OPTIMAL: 
-				if (debugResults) {
-					printResults();
-				}
-				break;
-			case GRB_INFEASIBLE:
-				{
-					cout << "The model is infeasible; computing IIS" << endl;
-					deque<string> removed;
-
-					// Loop until we reduce to a model that can be solved
-					model->computeIIS();
-					cout << "\nThe following constraint cannot be satisfied:" << endl;
-					GRBConstr* c = NULL;		 
-					c = model->getConstrs();
-					for (int64_t i = 0; i < model->get(GRB_IntAttr_NumConstrs); ++i) {
-						if (c[i].get(GRB_IntAttr_IISConstr) == 1.0) {
-							cout << c[i].get(GRB_StringAttr_ConstrName) << endl;
-							
-							removed.push_back(c[i].get(GRB_StringAttr_ConstrName));
-							model->remove(c[i]);
-							break;
+	for (uint32_t d_prv = 0; d_prv<deviceVector.size(); d_prv++) {
+		for (uint32_t d_cns = 0; d_cns<deviceVector.size(); d_cns++) {	
+			for (uint32_t n = 0; n<contentVector.size(); n++) {	
+				for (uint32_t c = 0; c<channelVector.size(); c++) {	
+					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
+						if (values[y(d_prv, d_cns, n, c, t)] > 0.5) {
+							int64_t duration = exchangeDuration(d_prv, d_cns, n, c);
+							for (uint32_t k = 0; k<multicastRates.size(); k++) {
+								if (values[m(d_prv, n, c, t, k)] > 0.5) {
+									duration = multicastDuration(n, k);
+								}
+							}
+							schedule.exchanges.push_back(d2dExchange(d_prv, d_cns, n, c, t, duration));
+							schedule.utility += exchangeUtility(d_prv, d_cns, n, c, t);
 						}
 					}
 				}
-				break;
-			default:
-				cout << "Unknown gurobi state " << status << endl;	
+			}
 		}
-					
-	} catch(GRBException e) {
-		cout << "ERROR code = " << e.getErrorCode() << endl;
-		cout << e.getMessage() << endl;
-		return e.getErrorCode();
-	} catch (exception& e)	{
-		cout << e.what() << endl;
-		return -1;
-	} catch(...) {
-		cout << "Exception during optimization" << endl;
-		return -1;
 	}
-	return status;
 }
 
 void d2dOptimizer::printResults() {
@@ -1650,28 +2518,28 @@ void d2dOptimizer::printResults() {
 		cout << "Device " << d << endl;
 		
 		for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-			if (S_Idle[d][t].get(GRB_DoubleAttr_X) > 0.5) { 
+			if (value(S_Idle(d, t)) > 0.5) { 
 				cout << "IDLE " << d << " time " <<  t << endl;					
 			}				
 			for (uint32_t c = 0; c<channelVector.size(); c++) {
-				if (S_AP[d][c][t].get(GRB_DoubleAttr_X) > 0.5) { 
+				if (value(S_AP(d, c, t)) > 0.5) { 
 					cout << "AP " << d << " chan " << c << " time " << t << endl;
 				}
-				if (S_StartAP[d][c][t].get(GRB_DoubleAttr_X) > 0.5) { 
+				if (value(S_StartAP(d, c, t)) > 0.5) { 
 					cout << "StartAP " << d << " chan " << c << " time " << t << endl;
 				}
-				if (S_SwitchAP[d][c][t].get(GRB_DoubleAttr_X) > 0.5) { 
+				if (value(S_SwitchAP(d, c, t)) > 0.5) { 
 					cout << "SwitchAP " << d << " chan " << c << " time " << t << endl;
 				}
 			}
 			for (uint32_t d_ap = 0; d_ap<deviceVector.size(); d_ap++) {
-				if (S_Client[d][d_ap][t].get(GRB_DoubleAttr_X) > 0.5) { 
+				if (value(S_Client(d, d_ap, t)) > 0.5) { 
 					cout << "Client " << d << " AP " << d_ap << " time " << t << endl;
 				}	
-				if (S_StartClient[d][d_ap][t].get(GRB_DoubleAttr_X) > 0.5) { 
+				if (value(S_StartClient(d, d_ap, t)) > 0.5) { 
 					cout << "StartClient " << d << " AP " << d_ap << " time " << t << endl;
 				}	
-				if (S_JoinAP[d][d_ap][t].get(GRB_DoubleAttr_X) > 0.5) { 
+				if (value(S_JoinAP(d, d_ap, t)) > 0.5) { 
 					cout << "JoinAP " << d << " AP " << d_ap << " time " << t << endl;
 				}	
 			}
@@ -1687,7 +2555,7 @@ void d2dOptimizer::printResults() {
 			for (uint32_t n = 0; n<contentVector.size(); n++) {	
 				for (uint32_t c = 0; c<channelVector.size(); c++) {	
 					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-						if (y[d_prv][d_cns][n][c][t].get(GRB_DoubleAttr_X) > 0.5) { 
+						if (value(y(d_prv, d_cns, n, c, t)) > 0.5) { 
 								cout << "PRV " << d_prv << " -> CNS " << d_cns;
 								cout << " CNT " << n << " (size " << S[n] << ") CH " << c << "(speed " << L[d_prv][d_cns][c] << ") TIME " << t << " DUR " << ceil((double)S[n] / (double) L[d_prv][d_cns][c]) << endl;					
 						}
@@ -1705,7 +2573,7 @@ void d2dOptimizer::printResults() {
 			for (uint32_t n = 0; n<contentVector.size(); n++) {	
 				for (uint32_t c = 0; c<channelVector.size(); c++) {	
 					for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-						if ( h[d_prv][d_cns][n][c][t].get(GRB_DoubleAttr_X) > 0.5) {	
+						if ( value(h(d_prv, d_cns, n, c, t)) > 0.5) {	
 							cout << "PRV " << d_prv << " -> CNS " << d_cns << " CNT " << n << " Chan " << c << " Time " << t << endl;
 						
 						}
@@ -1721,10 +2589,10 @@ void d2dOptimizer::printResults() {
 	for (uint32_t d = 0; d<deviceVector.size(); d++) {
 		for (uint32_t c = 0; c<channelVector.size(); c++) {	
 			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				if (s[d][c][t].get(GRB_DoubleAttr_X) > 0.5) {	
+				if (value(s(d, c, t)) > 0.5) {	
 					cout << "TX DEV " << d << " CH " << c << " Time " << t << endl;
 				}	
-				if (r[d][c][t].get(GRB_DoubleAttr_X) > 0.5) {		
+				if (value(r(d, c, t)) > 0.5) {		
 					cout << "RX DEV " << d << " CH " << c << " Time " << t << endl;
 				}
 			}
@@ -1740,7 +2608,7 @@ void d2dOptimizer::printResults() {
 		for (uint32_t n = 0; n<contentVector.size(); n++) {	
 			cout << "\t CNT " << n << endl;				
 			for (int64_t t = 0; t<settings.numTimeSlots; t++) {	
-				if (p[d][n][t].get(GRB_DoubleAttr_X) > 0.5) {
+				if (value(p(d, n, t)) > 0.5) {
 					cout << "\t\tTime " << t << endl;
 				}
 			}
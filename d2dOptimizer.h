@@ -11,15 +11,78 @@
 #include <math.h>  
 #include <string> 
 #include <stdint.h>
+#include <thread>
+#include <functional>
+#include <unordered_map>
+#include <exception>
+#include <cstring>
 
-#include "gurobi_c++.h"
+#include "d2dSolverBackend.h"
+#include "d2dSchedule.h"
+#include "d2dSpatialIndex.h"
+#include "d2dBitMatrix.h"
 
 #define STATE_IDLE 0
 #define STATE_STARTAP 1
 #define STATE_STARTCLIENT 2
 
+// scheduling mode used by optimize()
+// solve the full model
+#define D2D_MODE_MIP 		0
+// d2dMatchingHeuristic only, no solver required
+#define D2D_MODE_MATCHING 	1
+// d2dMatchingHeuristic improved by d2dLNS until timeLimit
+#define D2D_MODE_LNS 		2
+// d2dPortfolio, concurrent MIP variants and heuristics sharing incumbents
+#define D2D_MODE_PORTFOLIO 	3
+// d2dLPRounding, LP relaxation rounded and repaired into a schedule, reports the LP bound
+#define D2D_MODE_LP 		4
+// d2dLagrangian, clusters of devices solved separately with prices on the coupling constraints
+#define D2D_MODE_LAGRANGIAN 5
+// d2dModelEstimator selects MIP, Lagrangian, LNS or matching per optimize() from the predicted model
+// size, memoryBudget and timeLimit
+#define D2D_MODE_AUTO 		6
+
+// discount of the utility by the time slot in which an exchange ends, see decayWeight()
+#define D2D_DECAY_NONE 			0
+// 1 - decayRate * end / numTimeSlots
+#define D2D_DECAY_LINEAR 		1
+// exp(-decayRate * end / numTimeSlots)
+#define D2D_DECAY_EXPONENTIAL 	2
+// 1 - decayRate for exchanges ending after slot decaySlot
+#define D2D_DECAY_STEP 			3
+
+// number of index blocks per thread and constraint family during parallel model construction
+#define D2D_BUILD_BLOCKS_PER_THREAD 4
+
+// solver parameters loaded by solve() if the file exists, written by d2dParameterTuner
+#define D2D_PARAMETER_FILE "d2dSolver.prm"
+
+// rounding tolerance of the summed airtime shares of a provider with airtimeSharing
+#define D2D_AIRTIME_TOLERANCE 1e-9
+
 using namespace std;
 
+// combines the hash h with v (splitmix64 finalizer), used for instance fingerprints
+inline uint64_t d2dHashCombine(uint64_t h, uint64_t v) {
+	h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return h;
+}
+
+// bit pattern of v for d2dHashCombine, 0.0 and -0.0 are equal
+inline uint64_t d2dHashDouble(double v) {
+	uint64_t bits = 0;
+	if (v != 0.0) {
+		memcpy(&bits, &v, sizeof(bits));
+	}
+	return bits;
+}
+
 struct channel {
 	uint64_t id;
 	
@@ -45,8 +108,20 @@ struct device {
 	std::vector<content*> contentProviderVector;
 	std::vector<content*> contentInterestVector;
 	
+	// position in meters, used by computeLinkParameters()
+	bool hasPosition;
+	double x;
+	double y;
+	
+	// storage for content in content size units, -1 = unlimited
+	int64_t capacity;
+	
 	device(uint64_t id) {
-		this->id = id;
+		this->id 			= id;
+		this->hasPosition 	= false;
+		this->x 			= 0.0;
+		this->y 			= 0.0;
+		this->capacity 		= -1;
 	}
 	
 };
@@ -69,6 +144,8 @@ struct d2dSettings {
 	}
 };
 
+class d2dSolutionCache;
+
 class d2dOptimizer {
 	
 	public:
@@ -80,17 +157,111 @@ class d2dOptimizer {
 		bool setVariableNames;
 		bool setConstraintNames;
 		
-		GRBEnv *env;
-		GRBModel *model;
+		// number of threads used to generate variables and constraints (0 = 1 thread)
+		uint32_t numThreads;
+		
+		// owned by the optimizer
+		d2dSolverBackend *backend;
+		
+		// D2D_MODE_*
+		int32_t mode;
+		
+		// use the schedule of d2dMatchingHeuristic as MIP start
+		bool useMatchingStart;
+		
+		// seconds, 0 = no limit; deadline of the whole LNS in D2D_MODE_LNS, of all strategies in
+		// D2D_MODE_PORTFOLIO and of the relaxation in D2D_MODE_LP
+		double timeLimit;
+		
+		// solver parameters set by solve() before the time limit: first those of parameterFile
+		// ("<name> <value>" per line, # comments, as written by d2dParameterTuner) if it exists, then
+		// solverParameters. Empty parameterFile = none, D2D_PARAMETER_FILE by default
+		std::string parameterFile;
+		std::vector< std::pair<std::string, std::string> > solverParameters;
+		
+		// directory prefix of the instance files of readBasicParamters() and readParameters(), e.g. "corpus/1/"
+		std::string dataPrefix;
+		
+		// schedule found by the last optimize()
+		d2dSchedule schedule;
+		
+		// check the schedule with d2dValidator in optimize(), an invalid schedule results in D2D_STATUS_ERROR
+		bool validateSchedule;
+		
+		// template mode: buildModel() expresses the rows depending on P, I and the initial states
+		// (C1, C2, C5, C18, C20, C26, C28, C34, all on a single variable) as variable bounds and C13
+		// without P. A later optimize() on an instance with the same templateShape() then only replaces
+		// the objective and the bounds (updateModel()) instead of rebuilding the model.
+		bool useTemplate;
+		// template model built by the last buildModel() and its templateShape()
+		bool templateBuilt;
+		uint64_t builtShape;
+		// bounds of the variables of the built model, restored after LNS fixings
+		std::vector<double> varLb;
+		std::vector<double> varUb;
+		
+		// devices per cluster in D2D_MODE_LAGRANGIAN, 0 = connected components of the links
+		uint32_t maxClusterSize;
+		
+		// MB available for the model in D2D_MODE_AUTO, 0 = unlimited
+		double memoryBudget;
+		
+		// schedules of earlier instances, optimize() returns the schedule of an equal instance without
+		// building a model and stores new schedules. Not owned, NULL = no cache
+		d2dSolutionCache *solutionCache;
+		
+		// spatial channel reuse: several APs may operate on a channel if they do not interfere with
+		// each other according to X, otherwise at most one AP per channel (C36)
+		bool channelReuse;
+		
+		// multicast: a transmission of content n by an AP is received by all of its clients that start
+		// receiving n in the same slot, at the rate of the slowest receiver (PrvOnlyOneConsumer is replaced)
+		bool multicast;
+		
+		// airtimeSharing: a provider may serve several consumers in the same time slot, each exchange
+		// takes airtimeShare() of the slot and the shares must not exceed the slot (PrvOnlyOneConsumer),
+		// not used with multicast
+		bool airtimeSharing;
+		
+		// D2D_DECAY_*, the utility of an exchange is weighted by decayWeight() of the slot in which it
+		// ends at the link speed of the pair, so that earlier deliveries are preferred
+		int32_t utilityDecay;
+		double decayRate;
+		int64_t decaySlot;
+		
+		// value of ending the superslot as AP on channel c / client of d_ap for the following superslots,
+		// objective coefficient of S_AP[d][c][T-1] at terminalAP[d * numChan + c] and of
+		// S_Client[d][d_ap][T-1] at terminalClient[d * numDev + d_ap]. Set by d2dRollingHorizon, the
+		// utility of the schedule does not include them. Empty = 0
+		std::vector<double> terminalAP;
+		std::vector<double> terminalClient;
+		
+		// further objective coefficients of variables of the built model, added to the utilities by
+		// buildObjective(), e.g. the prices of d2dLagrangian. Empty = none
+		std::vector< std::pair<d2dVar, double> > extraObjective;
 		
 		//Parameters
-		int **P;
-		int **I;
-		int **W;
+		// P[d][n] device d holds content n, I[d][n] device d is interested in content n, W[d][c] device d
+		// supports channel c; packed bitsets per device
+		d2dBitMatrix P;
+		d2dBitMatrix I;
+		d2dBitMatrix W;
 		long ***L;
 		long *S;
 		int ****X;
 		double *** U;
+		// D[d][n] deadline of the interest of device d in content n, an exchange must end by time slot
+		// D (t + duration <= D), -1 = end of the superslot. Optional deadline.dat
+		int64_t **D;
+		
+		// receivers (d_rx, c_rx) with X[d_tx][c_tx][d_rx][c_rx] = 1 in increasing order per
+		// interferenceList[d_tx * numChan + c_tx], without d_rx = d_tx. Filled by readParameters() and
+		// computeLinkParameters(), derived from X by updateInterferenceList() if X was set directly.
+		// Code changing X after the list was filled has to clear it.
+		std::vector< std::vector< std::pair<uint32_t, uint32_t> > > interferenceList;
+		
+		// link speed and interference as function of the distance for computeLinkParameters()
+		d2dRadioModel radio;
 		
 		int *START_Idle;
 		int **START_AP;  	
@@ -99,32 +270,43 @@ class d2dOptimizer {
 		std::vector<channel*> channelVector;
 		std::vector<content*> contentVector;
 		std::vector<device*> deviceVector;
+		// index in deviceVector per device id, rebuilt if devices were appended directly
+		std::unordered_map<uint64_t, uint32_t> deviceIndexById;
 		
-		//Variables
-		GRBVar **S_Idle;
+		//Variables, column indices in the backend model
+		d2dVarBlock S_Idle;
 		
-		GRBVar ***S_StartAP;
-		GRBVar ***S_SwitchAP;
-		GRBVar ***S_AP;
+		d2dVarBlock S_StartAP;
+		d2dVarBlock S_SwitchAP;
+		d2dVarBlock S_AP;
 	
-		GRBVar ***S_StartClient;
-		GRBVar ***S_JoinAP;
-		GRBVar ***S_Client;
+		d2dVarBlock S_StartClient;
+		d2dVarBlock S_JoinAP;
+		d2dVarBlock S_Client;
 		
 		//y[d_prv][d_cns][n][c][t]
-		GRBVar *****y;
+		d2dVarBlock y;
 		
 		//p[d][n][t] 
-		GRBVar ***p;
+		d2dVarBlock p;
 		
 		// h[d_prv][d_cns][n][c][t]
-		GRBVar *****h;
+		d2dVarBlock h;
 		//r[d][c][t]
-		GRBVar ***r;
+		d2dVarBlock r;
 		//s[d][c][t]
-		GRBVar ***s;
+		d2dVarBlock s;
+		
+		//m[d_prv][n][c][t][k], multicast transmission at rate multicastRates[k], only with multicast
+		d2dVarBlock m;
+		// distinct link speeds of L in increasing order, the rate classes of m
+		std::vector<long> multicastRates;
+		
+		//values of all variables after a successful solve()
+		std::vector<double> solution;
 			
 		d2dOptimizer();
+		d2dOptimizer(d2dSolverBackend *backend);
 		~d2dOptimizer();
 		
 		void readBasicParamters();
@@ -141,12 +323,141 @@ class d2dOptimizer {
 		content *getContentById(uint64_t id);
 		int32_t getContentIndexById(uint64_t id);
 		
+		// reads positions.dat if present and computes L and X from the positions, otherwise link_speed.dat and interference.dat
 		void readParameters();
+		// positions.dat, returns false if the file does not exist or cannot be parsed
+		bool readPositions();
+		// interference.dat / link_speed.dat, return false on errors
+		bool readInterference();
+		bool readLinkSpeed();
+		// deadline.dat, returns false if the file does not exist or on errors
+		bool readDeadlines();
+		// sets L and X of all pairs of devices with position within the range of radio, the pairs are
+		// found with d2dSpatialIndex in time linear in the number of devices times the number of neighbors.
+		// Pairs out of range are not changed (0 after allocateParameters()).
+		void computeLinkParameters();
+		// derives interferenceList from X if it was not filled for the current devices and channels
+		void updateInterferenceList();
+		// multicastRates from L, called by buildModel() with multicast
+		void computeMulticastRates();
 		void allocateParameters();
 		void printParameterSimple();
 		void printParameter();
 		void printResults();
+		
+		// computes schedule with the selected mode, for D2D_MODE_MIP buildModel() followed by solve()
 		int32_t optimize();
+		// discards the current backend model and builds variables, objective and constraints
+		void buildModel();
+		// objective of the built model from U, the terminal values and extraObjective
+		void buildObjective();
+		// hash of all data the structure of the template model depends on: sizes, settings, model
+		// options, S, W, L, D, interference, capacities and free storage, but not U, P, I and START_*
+		uint64_t templateShape();
+		// varLb / varUb of the template model from P, I and START_*, passed to the backend
+		void setTemplateBounds();
+		// objective and bounds of the built template model for the current U, P, I and START_*
+		void updateModel();
+		// solves the built model, returns a D2D_STATUS_* value
+		int32_t solve();
+		// appends the parameters of a solver parameter file to params, false if it cannot be opened
+		static bool readSolverParameters(const std::string &fname, std::vector< std::pair<std::string, std::string> > &params);
+		
+		double value(d2dVar var) {
+			return solution[var];
+		}
+		
+		// number of time slots required to send content n from d_prv to d_cns on channel c, -1 without connectivity
+		int64_t exchangeDuration(uint32_t d_prv, uint32_t d_cns, uint32_t n, uint32_t c) {
+			if (L[d_prv][d_cns][c] <= 0) {
+				return -1;
+			}
+			return ceil((double)S[n] / (double)L[d_prv][d_cns][c]);
+		}
+		
+		// fraction of each of its time slots an exchange requires, S[n] / L spread over exchangeDuration()
+		double airtimeShare(uint32_t d_prv, uint32_t d_cns, uint32_t n, uint32_t c) {
+			return (double)S[n] / (double)L[d_prv][d_cns][c] / (double)exchangeDuration(d_prv, d_cns, n, c);
+		}
+		
+		// number of time slots of a multicast transmission of content n at rate multicastRates[k]
+		int64_t multicastDuration(uint32_t n, uint32_t k) {
+			return ceil((double)S[n] / (double)multicastRates[k]);
+		}
+		
+		// MC1, a multicast transmission of n at rate multicastRates[k] started in t ends within the superslot
+		bool multicastFits(uint32_t n, uint32_t k, int64_t t) {
+			return t + multicastDuration(n, k) <= settings.numTimeSlots && 
+				t * settings.slotLengthInSeconds() + (double)S[n] / (double)multicastRates[k] <= settings.tau;
+		}
+		
+		// an exchange started in time slot t is finished within the superslot (C8) and by the deadline
+		bool exchangeFits(uint32_t d_prv, uint32_t d_cns, uint32_t n, uint32_t c, int64_t t) {
+			int64_t duration = exchangeDuration(d_prv, d_cns, n, c);
+			return duration >= 0 && t + duration <= settings.numTimeSlots && meetsDeadline(d_cns, n, t + duration) &&
+					t * settings.slotLengthInSeconds() + (double)S[n] / (double)L[d_prv][d_cns][c] <= settings.tau;
+		}
+		
+		// storage of device d left for content received in the superslot, -1 = unlimited
+		int64_t freeStorage(uint32_t d) {
+			int64_t capacity = deviceVector[d]->capacity;
+			if (capacity < 0) {
+				return -1;
+			}
+			for (uint32_t n = 0; n<contentVector.size(); n++) {
+				capacity -= P[d][n] == 1 ? S[n] : 0;
+			}
+			return std::max<int64_t>(capacity, 0);
+		}
+		
+		bool meetsDeadline(uint32_t d_cns, uint32_t n, int64_t end) {
+			return D[d_cns][n] < 0 || end <= D[d_cns][n];
+		}
+		
+		// weight of the utility of an exchange ending with time slot end - 1, 1 with D2D_DECAY_NONE
+		double decayWeight(int64_t end) {
+			double fraction = (double)end / (double)settings.numTimeSlots;
+			switch (utilityDecay) {
+				case D2D_DECAY_LINEAR:
+					return 1.0 - decayRate * fraction;
+				case D2D_DECAY_EXPONENTIAL:
+					return exp(-decayRate * fraction);
+				case D2D_DECAY_STEP:
+					return end > decaySlot ? 1.0 - decayRate : 1.0;
+				default:
+					return 1.0;
+			}
+		}
+		
+		// discounted utility of an exchange started in time slot t, objective coefficient of y
+		double exchangeUtility(uint32_t d_prv, uint32_t d_cns, uint32_t n, uint32_t c, int64_t t) {
+			if (utilityDecay == D2D_DECAY_NONE || L[d_prv][d_cns][c] <= 0) {
+				return U[d_prv][d_cns][n];
+			}
+			return U[d_prv][d_cns][n] * decayWeight(t + exchangeDuration(d_prv, d_cns, n, c));
+		}
+		
+		// devices a and b cannot both be AP on channel c in the same time slot (C36)
+		bool apConflict(uint32_t a, uint32_t b, uint32_t c) {
+			return !channelReuse || X[a][c][b][c] == 1 || X[b][c][a][c] == 1;
+		}
+		
+		// values of all model variables describing the schedule, requires a built model
+		void scheduleToValues(const d2dSchedule &schedule, std::vector<double> &values);
+		void setStart(const d2dSchedule &schedule);
+		// schedule of the current solution
+		void getSchedule(d2dSchedule &schedule);
+		// schedule of the variable values, indexed by d2dVar
+		void getSchedule(const std::vector<double> &values, d2dSchedule &schedule);
+		
+		uint32_t buildThreads();
+		
+		// adds one variable per index tuple of dims, laid out with the last dimension contiguous
+		d2dVarBlock addVarBlock(const std::string &name, const std::vector<std::string> &labels, const std::vector<uint64_t> &dims, char type);
+		
+		// runs generator(buffer, i) for all i in [0, count) on numThreads threads and adds the rows in index order
+		void addConstrsParallel(uint32_t count, uint64_t rowsPerIndex, uint64_t termsPerIndex, 
+								const std::function<void(d2dConstraintBuffer &, uint32_t)> &generator);
 };
 
 #endif
\ No newline at end of file
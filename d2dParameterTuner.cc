@@ -0,0 +1,179 @@
+#include "d2dParameterTuner.h"
+
+#include <chrono>
+#include <iomanip>
+
+d2dParameterTuner::d2dParameterTuner(d2dOptimizer *opt) {
+	this->opt 		= opt;
+	timeLimit 		= 60.0;
+	targetGap 		= 0.01;
+	createBackend 	= createDefaultBackend;
+	best 			= -1;
+
+	//defaults, then the parameters the model is most sensitive to: feasibility vs. bound focus,
+	//heuristic effort, cut generation and presolve
+	candidates.push_back(d2dParameterSet());
+	candidates.push_back(d2dParameterSet{{"MIPFocus", "1"}});
+	candidates.push_back(d2dParameterSet{{"MIPFocus", "2"}});
+	candidates.push_back(d2dParameterSet{{"MIPFocus", "3"}});
+	candidates.push_back(d2dParameterSet{{"Heuristics", "0.2"}});
+	candidates.push_back(d2dParameterSet{{"Cuts", "2"}});
+	candidates.push_back(d2dParameterSet{{"Presolve", "2"}});
+	candidates.push_back(d2dParameterSet{{"MIPFocus", "1"}, {"Heuristics", "0.2"}});
+	candidates.push_back(d2dParameterSet{{"Presolve", "2"}, {"Cuts", "2"}});
+}
+
+bool d2dParameterTuner::readCorpus(const std::string &fname) {
+	std::ifstream infile(fname.c_str());
+	if (!infile.is_open()) {
+		cerr << "Cannot open " << fname << endl;
+		return false;
+	}
+	std::string line;
+	while (std::getline(infile, line)) {
+		std::istringstream iss(line);
+		std::string dir;
+		if (!(iss >> dir) || dir[0] == '#') {
+			continue;
+		}
+		if (dir[dir.size() - 1] != '/') {
+			dir += "/";
+		}
+		instances.push_back(dir);
+	}
+	return true;
+}
+
+bool d2dParameterTuner::readCandidates(const std::string &fname) {
+	std::ifstream infile(fname.c_str());
+	if (!infile.is_open()) {
+		cerr << "Cannot open " << fname << endl;
+		return false;
+	}
+	std::vector<d2dParameterSet> read;
+	std::string line;
+	while (std::getline(infile, line)) {
+		std::istringstream iss(line);
+		std::string token;
+		if (!(iss >> token) || token[0] == '#') {
+			continue;
+		}
+		d2dParameterSet params;
+		do {
+			size_t pos = token.find('=');
+			if (pos != std::string::npos && pos > 0) {
+				params.push_back(std::make_pair(token.substr(0, pos), token.substr(pos + 1)));
+			} else if (token != "default") {
+				cerr << "wrong parameter " << token << " in file " << fname << endl;
+			}
+		} while (iss >> token);
+		read.push_back(params);
+	}
+	if (read.empty()) {
+		cerr << "No candidates in file " << fname << endl;
+		return false;
+	}
+	candidates = read;
+	return true;
+}
+
+double d2dParameterTuner::measure(uint32_t k, uint32_t i) {
+	d2dOptimizer run(createBackend());
+	run.settings 		= opt->settings;
+	run.channelReuse 	= opt->channelReuse;
+	run.multicast 		= opt->multicast;
+	run.airtimeSharing 	= opt->airtimeSharing;
+	run.utilityDecay 	= opt->utilityDecay;
+	run.decayRate 		= opt->decayRate;
+	run.decaySlot 		= opt->decaySlot;
+	run.numThreads 		= opt->numThreads;
+	run.timeLimit 		= timeLimit;
+	run.debug 			= false;
+	run.debugResults 	= false;
+	run.dataPrefix 		= instances[i];
+	//only the parameters of the candidate
+	run.parameterFile.clear();
+	run.solverParameters = candidates[k];
+	std::stringstream gap;
+	gap << targetGap;
+	run.solverParameters.push_back(std::make_pair("MIPGap", gap.str()));
+
+	run.readBasicParamters();
+	if (run.deviceVector.empty()) {
+		cout << "No devices in instance " << instances[i] << endl;
+		return -1.0;
+	}
+	run.allocateParameters();
+	run.readParameters();
+	run.buildModel();
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	int32_t status = run.solve();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	switch (status) {
+		case D2D_STATUS_OPTIMAL:
+			return elapsed;
+		case D2D_STATUS_FEASIBLE:
+		case D2D_STATUS_NO_SOLUTION:
+			return 2.0 * timeLimit;
+		default:
+			cout << "Instance " << instances[i] << " failed with status " << status << endl;
+			return -1.0;
+	}
+}
+
+int32_t d2dParameterTuner::run() {
+	best = -1;
+	score.assign(candidates.size(), 0.0);
+	reached.assign(candidates.size(), 0);
+	if (instances.empty() || candidates.empty()) {
+		cout << "Parameter tuning requires instances and candidates" << endl;
+		return D2D_STATUS_ERROR;
+	}
+	cout << "Tuning " << candidates.size() << " parameter sets on " << instances.size() << " instances, "
+		 << timeLimit << " s per run, target gap " << targetGap * 100.0 << "%" << endl;
+
+	for (uint32_t k = 0; k<candidates.size(); k++) {
+		double logSum = 0.0;
+		for (uint32_t i = 0; i<instances.size(); i++) {
+			double time = measure(k, i);
+			if (time < 0.0) {
+				return D2D_STATUS_ERROR;
+			}
+			reached[k] += time <= timeLimit ? 1 : 0;
+			logSum += log(time + D2D_TUNER_TIME_SHIFT);
+		}
+		score[k] = exp(logSum / (double)instances.size()) - D2D_TUNER_TIME_SHIFT;
+		if (best < 0 || score[k] < score[best]) {
+			best = k;
+		}
+
+		cout << "parameter set " << k << " (";
+		for (uint32_t j = 0; j<candidates[k].size(); j++) {
+			cout << (j > 0 ? " " : "") << candidates[k][j].first << "=" << candidates[k][j].second;
+		}
+		cout << (candidates[k].empty() ? "default" : "") << "): " << std::fixed << std::setprecision(2) << score[k]
+			 << " s, " << reached[k] << "/" << instances.size() << " within the gap" << endl;
+		cout.unsetf(std::ios_base::floatfield);
+		cout << std::setprecision(6);
+	}
+	cout << "Best parameter set " << best << endl;
+	return D2D_STATUS_OPTIMAL;
+}
+
+bool d2dParameterTuner::write(const std::string &fname) {
+	if (best < 0) {
+		return false;
+	}
+	std::ofstream outfile(fname.c_str());
+	if (!outfile.is_open()) {
+		cerr << "Cannot open " << fname << endl;
+		return false;
+	}
+	outfile << "# d2dParameterTuner: " << instances.size() << " instances, " << timeLimit << " s per run, target gap "
+			<< targetGap << ", " << score[best] << " s to the gap, " << reached[best] << " runs within the gap" << endl;
+	for (uint32_t j = 0; j<candidates[best].size(); j++) {
+		outfile << candidates[best][j].first << " " << candidates[best][j].second << endl;
+	}
+	return outfile.good();
+}
@@ -0,0 +1,60 @@
+#ifndef D2DPARAMETERTUNER_H
+#define D2DPARAMETERTUNER_H
+
+#include "d2dOptimizer.h"
+
+// shift in seconds of the geometric mean of the solve times, so that very short runs do not dominate
+#define D2D_TUNER_TIME_SHIFT 1.0
+
+// solver parameters as (name, value), e.g. ("MIPFocus", "1")
+typedef std::vector< std::pair<std::string, std::string> > d2dParameterSet;
+
+// Tuning of the solver parameters over a corpus of stored instances. Every candidate parameter set
+// solves the model of every instance in D2D_MODE_MIP with the parameters of the candidate and MIPGap
+// targetGap. The time to the target gap is the solve time of a run the solver proves to be within the
+// gap (D2D_STATUS_OPTIMAL), runs that end without it count twice the time limit. The build time of
+// the model does not depend on the parameters and is not measured. The candidate with the smallest
+// shifted geometric mean of the times wins and is written as parameter file, which d2dOptimizer loads
+// in solve() (d2dOptimizer::parameterFile).
+class d2dParameterTuner {
+
+	public:
+		// settings and model options of the instances (settings, channelReuse, multicast,
+		// airtimeSharing, utility decay, numThreads), not changed
+		d2dOptimizer *opt;
+
+		// dataPrefix of each instance, the directory of its .dat files
+		std::vector<std::string> instances;
+		// first candidate = solver defaults
+		std::vector<d2dParameterSet> candidates;
+		// seconds per run
+		double timeLimit;
+		// relative MIP gap a run has to reach
+		double targetGap;
+		// backend of each run, createDefaultBackend() by default
+		std::function<d2dSolverBackend*()> createBackend;
+
+		// per candidate after run(): shifted geometric mean of the times and number of runs within the gap
+		std::vector<double> score;
+		std::vector<uint32_t> reached;
+		int32_t best;
+
+		d2dParameterTuner(d2dOptimizer *opt);
+
+		// one instance directory per line, # comments, false if the file cannot be opened
+		bool readCorpus(const std::string &fname);
+		// one candidate per line as <name>=<value> separated by blanks, "default" = no parameters,
+		// # comments; replaces the built-in candidates, false if the file cannot be opened or is empty
+		bool readCandidates(const std::string &fname);
+
+		// runs all candidates on all instances, returns a D2D_STATUS_* value, best is -1 on errors
+		int32_t run();
+		// writes the parameters of the best candidate in the format of d2dOptimizer::readSolverParameters()
+		bool write(const std::string &fname);
+
+	private:
+		// seconds to the target gap of candidate k on instance i, a negative value on errors
+		double measure(uint32_t k, uint32_t i);
+};
+
+#endif
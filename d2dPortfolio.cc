@@ -0,0 +1,213 @@
+#include "d2dPortfolio.h"
+#include "d2dMatchingHeuristic.h"
+#include "d2dValidator.h"
+#include "d2dLNS.h"
+#include "d2dLPRounding.h"
+
+d2dPortfolio::d2dPortfolio(d2dOptimizer *opt) {
+	this->opt 		= opt;
+	strategies 		= { D2D_PORTFOLIO_MIP, D2D_PORTFOLIO_MIP_FEASIBLE, D2D_PORTFOLIO_MIP_BOUND, D2D_PORTFOLIO_LNS, D2D_PORTFOLIO_LP };
+	bestStrategy 	= -1;
+	version 		= 0;
+	bestSource 		= -1;
+	optimal 		= false;
+}
+
+void d2dPortfolio::offer(const d2dSchedule &schedule, int32_t source) {
+	std::lock_guard<std::mutex> lock(mutex);
+	d2dValidator validator(opt);
+	if (!validator.validate(schedule) || (version > 0 && validator.utility <= best.utility + 1e-6)) {
+		return;
+	}
+	best 			= schedule;
+	best.utility 	= validator.utility;
+	opt->scheduleToValues(best, bestValues);
+	bestSource 		= source;
+	version++;
+	cout << "Portfolio incumbent utility " << best.utility << " from " << (source < 0 ? -1 : strategies[source]) << endl;
+}
+
+void d2dPortfolio::offerValues(const std::vector<double> &values, int32_t source) {
+	d2dSchedule schedule;
+	opt->getSchedule(values, schedule);
+	offer(schedule, source);
+}
+
+bool d2dPortfolio::poll(std::vector<double> *values, d2dSchedule *schedule, int32_t source, uint64_t &seen) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (version == seen) {
+		return false;
+	}
+	seen = version;
+	if (bestSource == source) {
+		return false;
+	}
+	if (values != NULL) {
+		*values = bestValues;
+	}
+	if (schedule != NULL) {
+		*schedule = best;
+	}
+	return true;
+}
+
+void d2dPortfolio::finish(int32_t source) {
+	std::lock_guard<std::mutex> lock(mutex);
+	optimal = true;
+	stop 	= true;
+	for (uint32_t i = 0; i<backends.size(); i++) {
+		if (backends[i] != NULL && (int32_t)i != source) {
+			backends[i]->interrupt();
+		}
+	}
+}
+
+void d2dPortfolio::runMip(uint32_t i) {
+	d2dSolverBackend *backend = backends[i];
+	switch (strategies[i]) {
+		case D2D_PORTFOLIO_MIP_FEASIBLE:
+			backend->setParam("MIPFocus", "1");
+			backend->setParam("Heuristics", "0.5");
+			break;
+		case D2D_PORTFOLIO_MIP_BOUND:
+			backend->setParam("MIPFocus", "3");
+			backend->setParam("Cuts", "2");
+			break;
+	}
+
+	uint64_t seen = 0;
+	std::vector<double> start;
+	poll(&start, NULL, i, seen);
+	if (!start.empty()) {
+		backend->setStart(start);
+	}
+	backend->setIncumbentCallbacks(
+		[this, i](const std::vector<double> &values, double /*objective*/) {
+			offerValues(values, i);
+		},
+		[this, i, &seen](std::vector<double> &values) {
+			return poll(&values, NULL, i, seen);
+		});
+
+	int32_t status = stop ? D2D_STATUS_UNKNOWN : backend->optimize();
+	backend->setIncumbentCallbacks(d2dIncumbentFound(), d2dIncumbentPoll());
+	if (status == D2D_STATUS_EXPORTED) {
+		cout << "Portfolio strategy " << strategies[i] << " requires a solver backend" << endl;
+		return;
+	}
+	if (backend->hasSolution()) {
+		std::vector<double> values;
+		backend->getValues(values);
+		offerValues(values, i);
+	}
+	if (status == D2D_STATUS_OPTIMAL && !stop) {
+		finish(i);
+	}
+}
+
+void d2dPortfolio::runLNS(uint32_t i) {
+	d2dLNS lns(opt);
+	lns.backend = backends[i];
+	lns.stop 	= &stop;
+	uint64_t seen = 0;
+	lns.found = [this, i](const d2dSchedule &schedule) {
+		offer(schedule, i);
+	};
+	lns.poll = [this, i, &seen](d2dSchedule &schedule) {
+		return poll(NULL, &schedule, i, seen);
+	};
+
+	d2dSchedule schedule;
+	if (!poll(NULL, &schedule, i, seen)) {
+		cout << "Portfolio LNS skipped without start schedule" << endl;
+		return;
+	}
+	if (lns.run(schedule) == D2D_STATUS_OPTIMAL && !stop) {
+		finish(i);
+	}
+}
+
+void d2dPortfolio::runLP(uint32_t i) {
+	d2dLPRounding rounding(opt);
+	rounding.backend = backends[i];
+	d2dSchedule schedule;
+	int32_t status = rounding.run(schedule);
+	if (status != D2D_STATUS_OPTIMAL && status != D2D_STATUS_FEASIBLE) {
+		return;
+	}
+	offer(schedule, i);
+	if (status == D2D_STATUS_OPTIMAL && !stop) {
+		finish(i);
+	}
+}
+
+int32_t d2dPortfolio::run(d2dSchedule &schedule) {
+	stop 		= false;
+	optimal 	= false;
+	version 	= 0;
+	bestSource 	= -1;
+	best.reset(opt->deviceVector.size(), opt->settings.numTimeSlots);
+	//computed before the threads start, the validator would compute them on demand
+	if (opt->multicast && opt->multicastRates.empty()) {
+		opt->computeMulticastRates();
+	}
+
+	d2dSchedule start;
+	d2dMatchingHeuristic heuristic(opt);
+	heuristic.run(start);
+	offer(start, -1);
+
+	//each strategy solves a copy of the model, without copies only the first one runs on the model of opt
+	backends.assign(strategies.size(), NULL);
+	uint32_t numMip = 0;
+	for (uint32_t i = 0; i<strategies.size(); i++) {
+		backends[i] = opt->backend->clone();
+		if (backends[i] == NULL && i == 0) {
+			backends[i] = opt->backend;
+		}
+		if (backends[i] == NULL) {
+			cout << "Portfolio strategy " << strategies[i] << " skipped, the backend cannot be copied" << endl;
+		} else if (strategies[i] != D2D_PORTFOLIO_LNS) {
+			numMip++;
+		}
+	}
+
+	//the cores are divided among the MIPs and the LP
+	std::stringstream threads;
+	threads << std::max<uint32_t>(1, std::thread::hardware_concurrency() / std::max<uint32_t>(numMip, 1));
+	std::stringstream limit;
+	limit << opt->timeLimit;
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i<strategies.size(); i++) {
+		if (backends[i] == NULL) {
+			continue;
+		}
+		if (opt->timeLimit > 0.0) {
+			backends[i]->setParam("TimeLimit", limit.str());
+		}
+		if (strategies[i] == D2D_PORTFOLIO_LNS) {
+			workers.push_back(std::thread(&d2dPortfolio::runLNS, this, i));
+		} else {
+			backends[i]->setParam("Threads", threads.str());
+			workers.push_back(std::thread(strategies[i] == D2D_PORTFOLIO_LP ? &d2dPortfolio::runLP : &d2dPortfolio::runMip, this, i));
+		}
+	}
+	for (uint32_t i = 0; i<workers.size(); i++) {
+		workers[i].join();
+	}
+	for (uint32_t i = 0; i<backends.size(); i++) {
+		if (backends[i] != opt->backend) {
+			delete backends[i];
+		}
+	}
+	backends.clear();
+
+	schedule 		= best;
+	opt->solution 	= bestValues;
+	bestStrategy 	= bestSource < 0 ? -1 : strategies[bestSource];
+	cout << "Portfolio utility " << best.utility << " from strategy " << bestStrategy << (optimal ? " (optimal)" : "") << endl;
+	if (version == 0) {
+		return D2D_STATUS_NO_SOLUTION;
+	}
+	return optimal ? D2D_STATUS_OPTIMAL : D2D_STATUS_FEASIBLE;
+}
@@ -0,0 +1,74 @@
+#ifndef D2DPORTFOLIO_H
+#define D2DPORTFOLIO_H
+
+#include <mutex>
+#include <atomic>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// concurrent strategies of d2dPortfolio
+// MIP with the default solver parameters
+#define D2D_PORTFOLIO_MIP 			0
+// MIP emphasizing good solutions early (MIPFocus 1, Heuristics 0.5)
+#define D2D_PORTFOLIO_MIP_FEASIBLE 	1
+// MIP emphasizing the bound (MIPFocus 3, Cuts 2)
+#define D2D_PORTFOLIO_MIP_BOUND 	2
+// d2dLNS
+#define D2D_PORTFOLIO_LNS 			3
+// d2dLPRounding, ends the portfolio if the rounded schedule meets the LP bound
+#define D2D_PORTFOLIO_LP 			4
+
+// Races several strategies on the model of d2dOptimizer in parallel threads. d2dMatchingHeuristic
+// runs first and its schedule is the start of all strategies. Each strategy solves its own copy of
+// the model (d2dSolverBackend::clone()) and shares incumbents:
+// every new solution is checked by d2dValidator and becomes the common incumbent if it is better,
+// which is injected into the running MIPs and picked up by the LNS; d2dLPRounding offers its schedule
+// once. The portfolio ends at
+// opt->timeLimit or as soon as one strategy proves optimality, the others are interrupted.
+// Without copies of the backend only the first strategy runs, on the model of opt.
+class d2dPortfolio {
+
+	public:
+		d2dOptimizer *opt;
+
+		// D2D_PORTFOLIO_*, one thread each
+		std::vector<int32_t> strategies;
+
+		// D2D_PORTFOLIO_* that found the best schedule, -1 = d2dMatchingHeuristic
+		int32_t bestStrategy;
+
+		d2dPortfolio(d2dOptimizer *opt);
+
+		// best valid schedule found, requires a built model, returns a D2D_STATUS_* value
+		int32_t run(d2dSchedule &schedule);
+
+	private:
+		std::mutex mutex;
+		std::atomic<bool> stop;
+
+		// common incumbent, version counts its improvements
+		d2dSchedule best;
+		std::vector<double> bestValues;
+		uint64_t version;
+		// index in strategies of the best schedule, -1 = d2dMatchingHeuristic
+		int32_t bestSource;
+		bool optimal;
+
+		// backend per strategy, NULL if skipped
+		std::vector<d2dSolverBackend*> backends;
+
+		// replaces the incumbent by schedule / the schedule of values if it is valid and better
+		void offer(const d2dSchedule &schedule, int32_t source);
+		void offerValues(const std::vector<double> &values, int32_t source);
+		// incumbent found by another strategy since version seen
+		bool poll(std::vector<double> *values, d2dSchedule *schedule, int32_t source, uint64_t &seen);
+		// one strategy proved optimality, interrupts all others
+		void finish(int32_t source);
+
+		void runMip(uint32_t i);
+		void runLNS(uint32_t i);
+		void runLP(uint32_t i);
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "d2dRollingHorizon.h"
+#include "d2dContentChunker.h"
+
+d2dRollingHorizon::d2dRollingHorizon(uint32_t horizon, uint32_t coarsening) {
+	this->horizon 		= std::max<uint32_t>(horizon, 1);
+	this->coarsening 	= std::max<uint32_t>(coarsening, 1);
+	weight 				= 0.5;
+	mode 				= D2D_MODE_MIP;
+	timeLimit 			= 0.0;
+	plannedUtility 		= 0.0;
+}
+
+void d2dRollingHorizon::buildWindow(d2dOptimizer *opt, d2dOptimizer *window) {
+	//a single chunk per content copies the instance
+	long maxSize = 1;
+	for (uint32_t n = 0; n<opt->contentVector.size(); n++) {
+		maxSize = std::max(maxSize, opt->S[n]);
+	}
+	d2dContentChunker copy(maxSize);
+	copy.split(opt, window);
+
+	int64_t numT = opt->settings.numTimeSlots;
+	window->settings.numTimeSlots 		= (horizon * numT + coarsening - 1) / coarsening;
+	window->settings.tau 				= horizon * opt->settings.tau;
+	window->settings.kappa_startAP 		= (opt->settings.kappa_startAP + coarsening - 1) / coarsening;
+	window->settings.kappa_startClient 	= (opt->settings.kappa_startClient + coarsening - 1) / coarsening;
+	for (uint32_t d = 0; d<window->deviceVector.size(); d++) {
+		for (uint32_t n = 0; n<window->contentVector.size(); n++) {
+			if (window->D[d][n] >= 0) {
+				window->D[d][n] /= coarsening;
+			}
+		}
+		for (uint32_t d_cns = 0; d_cns<window->deviceVector.size(); d_cns++) {
+			for (uint32_t c = 0; c<window->channelVector.size(); c++) {
+				window->L[d][d_cns][c] *= coarsening;
+			}
+		}
+	}
+
+	window->mode 			= mode;
+	window->timeLimit 		= timeLimit > 0.0 ? timeLimit : opt->timeLimit;
+	window->numThreads 		= opt->numThreads;
+	window->channelReuse 	= opt->channelReuse;
+	window->multicast 		= opt->multicast;
+	window->airtimeSharing 	= opt->airtimeSharing;
+	window->debug 			= false;
+	window->debugResults 	= false;
+	//the plan only guides the terminal values
+	window->validateSchedule = false;
+}
+
+int32_t d2dRollingHorizon::plan(d2dOptimizer *opt) {
+	uint32_t numDev 	= opt->deviceVector.size();
+	uint32_t numChan 	= opt->channelVector.size();
+	opt->terminalAP.assign(numDev * numChan, 0.0);
+	opt->terminalClient.assign(numDev * numDev, 0.0);
+	plannedUtility = 0.0;
+	if (horizon <= 1) {
+		return D2D_STATUS_OPTIMAL;
+	}
+
+	d2dOptimizer window(mode == D2D_MODE_MATCHING ? new d2dFileBackend("") : createDefaultBackend());
+	buildWindow(opt, &window);
+	int32_t status = window.optimize();
+	if (status != D2D_STATUS_OPTIMAL && status != D2D_STATUS_FEASIBLE) {
+		cout << "Rolling horizon: no plan for the window (status " << status << ")" << endl;
+		return status;
+	}
+
+	//last window slot of the committed superslot
+	const d2dSchedule &schedule = window.schedule;
+	int64_t boundary = (opt->settings.numTimeSlots + coarsening - 1) / coarsening - 1;
+	for (uint32_t i = 0; i<schedule.exchanges.size(); i++) {
+		const d2dExchange &ex = schedule.exchanges[i];
+		if (ex.t <= boundary) {
+			continue;
+		}
+		double value = weight * window.U[ex.d_prv][ex.d_cns][ex.n];
+		plannedUtility += window.U[ex.d_prv][ex.d_cns][ex.n];
+		//roles already held at the boundary that the exchange uses
+		for (int side = 0; side<2; side++) {
+			uint32_t d = side == 0 ? ex.d_prv : ex.d_cns;
+			uint8_t role = schedule.getRole(d, boundary);
+			uint32_t arg = schedule.getRoleArg(d, boundary);
+			if (role != schedule.getRole(d, ex.t) || arg != schedule.getRoleArg(d, ex.t)) {
+				continue;
+			}
+			if (role == D2D_ROLE_AP) {
+				opt->terminalAP[d * numChan + arg] += value;
+			} else if (role == D2D_ROLE_CLIENT) {
+				opt->terminalClient[d * numDev + arg] += value;
+			}
+		}
+	}
+	cout << "Rolling horizon: planned utility " << plannedUtility << " after the superslot" << endl;
+	return status;
+}
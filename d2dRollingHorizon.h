@@ -0,0 +1,45 @@
+#ifndef D2DROLLINGHORIZON_H
+#define D2DROLLINGHORIZON_H
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// Rolling-horizon planning for d2dSimulator. Before each superslot the instance is planned over a
+// window of horizon superslots at a coarser resolution: a window slot spans coarsening time slots,
+// the link speeds are scaled accordingly, so the window model has horizon / coarsening times the
+// time slots of a superslot. Only the committed superslot is then scheduled at full resolution by
+// the optimizer, with the plan as terminal values (d2dOptimizer::terminalAP / terminalClient): an AP
+// or client role at the end of the superslot is worth weight times the utility of the exchanges the
+// plan schedules in the later superslots with that role, so role changes that have to be set up
+// again and transfers prepared for the next superslot are priced in.
+// The window assumes that no interests arrive and that links do not change. Terminal values enter
+// the objective of the model based modes; d2dMatchingHeuristic ignores them.
+class d2dRollingHorizon {
+
+	public:
+		// superslots of the window including the committed one, 1 = no terminal values
+		uint32_t horizon;
+		// time slots per window slot
+		uint32_t coarsening;
+		// discount of the planned utility after the committed superslot
+		double weight;
+		// D2D_MODE_* used to solve the window, with a backend of createDefaultBackend()
+		int32_t mode;
+		// seconds for the window, 0 = timeLimit of the optimizer
+		double timeLimit;
+
+		// utility of the plan after the committed superslot, of the last plan()
+		double plannedUtility;
+
+		d2dRollingHorizon(uint32_t horizon, uint32_t coarsening);
+
+		// plans the window starting with the instance of opt and sets the terminal values of opt,
+		// returns the D2D_STATUS_* value of the window, the terminal values are 0 without a plan
+		int32_t plan(d2dOptimizer *opt);
+
+	private:
+		// copies the instance of opt into the empty optimizer window at the window resolution
+		void buildWindow(d2dOptimizer *opt, d2dOptimizer *window);
+};
+
+#endif
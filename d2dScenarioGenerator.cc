@@ -0,0 +1,285 @@
+#include "d2dScenarioGenerator.h"
+
+d2dScenarioGenerator::d2dScenarioGenerator() {
+	seed 			= 1;
+	numDevices 		= 100;
+	numChannels 	= 3;
+	numContent 		= 10;
+
+	placement 			= D2D_PLACEMENT_UNIFORM;
+	areaPerDevice 		= 100.0;
+	devicesPerCluster 	= 20;
+	clusterRadius 		= 10.0;
+	venueOccupancy 		= 0.8;
+
+	channelProbability 	= 0.7;
+	holdProbability 	= 0.2;
+	interestProbability = 0.3;
+	popularitySkew 		= 0.8;
+	minContentSize 		= 1;
+	maxContentSize 		= 5;
+	maxUtility 			= 10;
+}
+
+void d2dScenarioGenerator::placeUniform(double side) {
+	for (uint32_t d = 0; d<numDevices; d++) {
+		posX[d] = uniform() * side;
+		posY[d] = uniform() * side;
+	}
+}
+
+void d2dScenarioGenerator::placeClustered(double side) {
+	uint32_t numClusters = std::max<uint32_t>(1, numDevices / std::max<uint32_t>(devicesPerCluster, 1));
+	std::vector<double> centerX(numClusters);
+	std::vector<double> centerY(numClusters);
+	for (uint32_t k = 0; k<numClusters; k++) {
+		centerX[k] = uniform() * side;
+		centerY[k] = uniform() * side;
+	}
+	std::normal_distribution<double> offset(0.0, clusterRadius);
+	for (uint32_t d = 0; d<numDevices; d++) {
+		uint32_t k = rng() % numClusters;
+		posX[d] = std::min(std::max(centerX[k] + offset(rng), 0.0), side);
+		posY[d] = std::min(std::max(centerY[k] + offset(rng), 0.0), side);
+	}
+}
+
+void d2dScenarioGenerator::placeVenue() {
+	//blocks of 20 seats per row (0.5 m apart) separated by 2 m aisles, rows 0.9 m apart
+	const uint32_t seatsPerBlock 	= 20;
+	const double seatSpacing 		= 0.5;
+	const double rowSpacing 		= 0.9;
+	const double aisleWidth 		= 2.0;
+
+	uint64_t numSeats = ceil(numDevices / std::max(std::min(venueOccupancy, 1.0), 0.01));
+	//roughly square hall
+	double blockWidth = seatsPerBlock * seatSpacing + aisleWidth;
+	uint32_t blocksPerRow = std::max<uint32_t>(1, ceil(sqrt(numSeats * rowSpacing / seatsPerBlock / blockWidth)));
+	uint32_t seatsPerRow = blocksPerRow * seatsPerBlock;
+	uint64_t numRows = (numSeats + seatsPerRow - 1) / seatsPerRow;
+	numSeats = numRows * seatsPerRow;
+
+	//random subset of the seats
+	std::vector<uint64_t> seats(numSeats);
+	for (uint64_t i = 0; i<numSeats; i++) {
+		seats[i] = i;
+	}
+	for (uint32_t d = 0; d<numDevices; d++) {
+		std::swap(seats[d], seats[d + rng() % (numSeats - d)]);
+		uint64_t row 	= seats[d] / seatsPerRow;
+		uint32_t seat 	= seats[d] % seatsPerRow;
+		posX[d] = (seat / seatsPerBlock) * blockWidth + (seat % seatsPerBlock) * seatSpacing + (uniform() - 0.5) * 0.2;
+		posY[d] = row * rowSpacing + (uniform() - 0.5) * 0.2;
+	}
+}
+
+bool d2dScenarioGenerator::interferes(uint32_t tx, uint32_t c_tx, uint32_t rx, uint32_t c_rx, double dist) const {
+	if (!supports[tx * numChannels + c_tx] || !supports[rx * numChannels + c_rx]) {
+		return false;
+	}
+	return radio.interferes(c_tx, c_rx, dist);
+}
+
+void d2dScenarioGenerator::generate() {
+	rng.seed(seed);
+	radio.sortRates();
+
+	posX.assign(numDevices, 0.0);
+	posY.assign(numDevices, 0.0);
+	double side = sqrt(numDevices * areaPerDevice);
+	switch (placement) {
+		case D2D_PLACEMENT_CLUSTERED:
+			placeClustered(side);
+			break;
+		case D2D_PLACEMENT_VENUE:
+			placeVenue();
+			break;
+		default:
+			placeUniform(side);
+	}
+
+	sizes.resize(numContent);
+	std::vector<double> popularity(numContent);
+	for (uint32_t n = 0; n<numContent; n++) {
+		sizes[n] 		= minContentSize + rng() % (maxContentSize - minContentSize + 1);
+		popularity[n] 	= 1.0 / pow(n + 1, popularitySkew);
+	}
+
+	supports.assign((uint64_t)numDevices * numChannels, 0);
+	holds.assign((uint64_t)numDevices * numContent, 0);
+	interested.assign((uint64_t)numDevices * numContent, 0);
+	utility.assign((uint64_t)numDevices * numContent, 0.0);
+	for (uint32_t d = 0; d<numDevices; d++) {
+		bool anyChannel = false;
+		for (uint32_t c = 0; c<numChannels; c++) {
+			supports[d * numChannels + c] = uniform() < channelProbability;
+			anyChannel = anyChannel || supports[d * numChannels + c];
+		}
+		if (!anyChannel && numChannels > 0) {
+			supports[d * numChannels + rng() % numChannels] = 1;
+		}
+		for (uint32_t n = 0; n<numContent; n++) {
+			if (uniform() < holdProbability * popularity[n]) {
+				holds[d * numContent + n] = 1;
+			} else if (uniform() < interestProbability * popularity[n]) {
+				interested[d * numContent + n] 	= 1;
+				utility[d * numContent + n] 	= 1 + rng() % std::max<uint32_t>(maxUtility, 1);
+			}
+		}
+	}
+
+	index.build(posX, posY, radio.range());
+}
+
+void d2dScenarioGenerator::fill(d2dOptimizer *opt) {
+	for (uint32_t c = 0; c<numChannels; c++) {
+		opt->addChannel(c);
+	}
+	for (uint32_t n = 0; n<numContent; n++) {
+		opt->addContent(n, sizes[n]);
+	}
+	for (uint32_t d = 0; d<numDevices; d++) {
+		opt->addDevice(d);
+	}
+	opt->allocateParameters();
+
+	for (uint32_t n = 0; n<numContent; n++) {
+		opt->S[n] = sizes[n];
+	}
+	for (uint32_t d = 0; d<numDevices; d++) {
+		for (uint32_t c = 0; c<numChannels; c++) {
+			opt->W[d][c] = supports[d * numChannels + c];
+		}
+		for (uint32_t n = 0; n<numContent; n++) {
+			opt->P[d][n] = holds[d * numContent + n];
+			opt->I[d][n] = interested[d * numContent + n];
+		}
+	}
+
+	for (uint32_t d = 0; d<numDevices; d++) {
+		opt->deviceVector[d]->hasPosition 	= true;
+		opt->deviceVector[d]->x 			= posX[d];
+		opt->deviceVector[d]->y 			= posY[d];
+	}
+	opt->radio = radio;
+	opt->computeLinkParameters();
+
+	double linkRange = radio.rateTable.empty() ? 0.0 : radio.rateTable.back().distance;
+	std::vector<uint32_t> near;
+	for (uint32_t a = 0; a<numDevices; a++) {
+		index.neighbors(a, linkRange, near);
+		for (uint32_t i = 0; i<near.size(); i++) {
+			for (uint32_t n = 0; n<numContent; n++) {
+				opt->U[a][near[i]][n] = utility[near[i] * numContent + n];
+			}
+		}
+	}
+}
+
+bool d2dScenarioGenerator::writeFiles(const std::string &dir, bool writePositions) {
+	std::string prefix = dir.empty() ? "" : dir + "/";
+	std::ofstream channels((prefix + "channels.dat").c_str());
+	std::ofstream contents((prefix + "content.dat").c_str());
+	std::ofstream devices((prefix + "devices.dat").c_str());
+	std::ofstream utilities((prefix + "utility.dat").c_str());
+	std::ofstream states((prefix + "state.dat").c_str());
+	//positions.dat replaces the link speed and interference tables
+	std::ofstream positions;
+	std::ofstream links;
+	std::ofstream interference;
+	if (writePositions) {
+		positions.open((prefix + "positions.dat").c_str());
+	} else {
+		links.open((prefix + "link_speed.dat").c_str());
+		interference.open((prefix + "interference.dat").c_str());
+	}
+	if (!channels.is_open() || !contents.is_open() || !devices.is_open() || !utilities.is_open() || !states.is_open() ||
+		positions.is_open() != writePositions || links.is_open() == writePositions || interference.is_open() == writePositions) {
+		cerr << "Cannot write scenario files to " << (dir.empty() ? "." : dir) << endl;
+		return false;
+	}
+
+	channels << "#channelID" << endl;
+	for (uint32_t c = 0; c<numChannels; c++) {
+		channels << c << "\n";
+	}
+
+	contents << "#contentID contentSize" << endl;
+	for (uint32_t n = 0; n<numContent; n++) {
+		contents << n << "\t" << sizes[n] << "\n";
+	}
+
+	devices << "#deviceID (list of supported channel IDs) (list of available content IDs) (list of interested content IDs)" << endl;
+	states << "#deviceID deviceState channelID/deviceID of AP/dummy (for Idle)" << endl;
+	states << "# 0 = Idle(default), 1 = AP, 2 = Client" << endl;
+	for (uint32_t d = 0; d<numDevices; d++) {
+		devices << d;
+		const std::vector<char> *lists[3] = { &supports, &holds, &interested };
+		uint32_t lengths[3] = { numChannels, numContent, numContent };
+		for (uint32_t l = 0; l<3; l++) {
+			devices << "\t";
+			bool empty = true;
+			for (uint32_t i = 0; i<lengths[l]; i++) {
+				if ((*lists[l])[(uint64_t)d * lengths[l] + i]) {
+					devices << (empty ? "" : ",") << i;
+					empty = false;
+				}
+			}
+			if (empty) {
+				devices << "-";
+			}
+		}
+		devices << "\n";
+		states << d << "\t" << STATE_IDLE << "\t0\n";
+	}
+
+	if (writePositions) {
+		positions << "#deviceID x y (meters)" << endl;
+		positions.precision(12);
+		for (uint32_t d = 0; d<numDevices; d++) {
+			positions << d << "\t" << posX[d] << "\t" << posY[d] << "\n";
+		}
+	} else {
+		links << "#contentProviderID contentConsumerID  channelID linkSpeed(0=no connectivity)" << endl;
+		interference << "#transmittingDeviceID transmittingChannelID receivingDeviceID (List of interferred channel IDs)" << endl;
+	}
+	utilities << "#contentProviderID contentConsumerID contentID utilityValue" << endl;
+	double linkRange = radio.rateTable.empty() ? 0.0 : radio.rateTable.back().distance;
+	//only the utilities are written for the pairs in link range with positions
+	double range = writePositions ? linkRange : radio.range();
+	std::vector<uint32_t> near;
+	for (uint32_t a = 0; a<numDevices; a++) {
+		index.neighbors(a, range, near);
+		for (uint32_t i = 0; i<near.size(); i++) {
+			uint32_t b = near[i];
+			double dist = index.distance(a, b);
+			long speed = radio.linkSpeed(dist);
+			for (uint32_t c = 0; c<numChannels && !writePositions; c++) {
+				if (speed > 0 && supports[a * numChannels + c] && supports[b * numChannels + c]) {
+					links << a << "\t" << b << "\t" << c << "\t" << speed << "\n";
+				}
+				bool empty = true;
+				for (uint32_t c_rx = 0; c_rx<numChannels; c_rx++) {
+					if (interferes(a, c, b, c_rx, dist)) {
+						if (empty) {
+							interference << a << "\t" << c << "\t" << b << "\t";
+						}
+						interference << (empty ? "" : ",") << c_rx;
+						empty = false;
+					}
+				}
+				if (!empty) {
+					interference << "\n";
+				}
+			}
+			if (speed > 0) {
+				for (uint32_t n = 0; n<numContent; n++) {
+					if (interested[b * numContent + n]) {
+						utilities << a << "\t" << b << "\t" << n << "\t" << utility[b * numContent + n] << "\n";
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+#ifndef D2DSCENARIOGENERATOR_H
+#define D2DSCENARIOGENERATOR_H
+
+#include <random>
+
+#include "d2dOptimizer.h"
+#include "d2dSpatialIndex.h"
+
+// device placement of d2dScenarioGenerator
+// uniform in a square area
+#define D2D_PLACEMENT_UNIFORM 	0
+// gaussian groups around uniformly placed centers
+#define D2D_PLACEMENT_CLUSTERED 1
+// seats in rows and blocks separated by aisles, e.g. a stadium or lecture hall
+#define D2D_PLACEMENT_VENUE 	2
+
+// Seeded generator of instances with spatial structure. Devices are placed in a plane, the link
+// speed L and interference X follow from the distances through radio. Content popularity follows
+// a Zipf distribution. Neighbors are found with d2dSpatialIndex, so the run time is linear in the
+// number of devices times the number of neighbors. The instance is either written as .dat files
+// or filled into an optimizer, the latter allocates the dense parameter arrays of d2dOptimizer.
+class d2dScenarioGenerator {
+
+	public:
+		uint32_t seed;
+		uint32_t numDevices;
+		uint32_t numChannels;
+		uint32_t numContent;
+
+		// D2D_PLACEMENT_*
+		int32_t placement;
+		// square meters per device, determines the side of the square area
+		double areaPerDevice;
+		uint32_t devicesPerCluster;
+		// standard deviation of the distance to the cluster center in meters
+		double clusterRadius;
+		// fraction of occupied seats
+		double venueOccupancy;
+
+		d2dRadioModel radio;
+
+		double channelProbability;
+		// probability to hold / be interested in the most popular content, scaled by popularity for the others
+		double holdProbability;
+		double interestProbability;
+		// Zipf exponent of the content popularity
+		double popularitySkew;
+		long minContentSize;
+		long maxContentSize;
+		// utility of a satisfied interest is drawn from [1, maxUtility]
+		uint32_t maxUtility;
+
+		// instance created by generate()
+		std::vector<double> posX;
+		std::vector<double> posY;
+		// supports[d * numChannels + c], holds / interested / utility [d * numContent + n]
+		std::vector<char> supports;
+		std::vector<char> holds;
+		std::vector<char> interested;
+		std::vector<double> utility;
+		std::vector<long> sizes;
+
+		d2dScenarioGenerator();
+
+		void generate();
+
+		// adds channels, content and devices with index ids and positions to an empty optimizer,
+		// sets all parameters and computes L and X with the radio model
+		void fill(d2dOptimizer *opt);
+		// writes channels.dat, content.dat, devices.dat, utility.dat, state.dat (all devices Idle) and
+		// either positions.dat or link_speed.dat and interference.dat into directory dir
+		bool writeFiles(const std::string &dir, bool writePositions = false);
+
+	private:
+		std::mt19937 rng;
+
+		d2dSpatialIndex index;
+
+		double uniform() {
+			return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+		}
+
+		void placeUniform(double side);
+		void placeClustered(double side);
+		void placeVenue();
+		bool interferes(uint32_t tx, uint32_t c_tx, uint32_t rx, uint32_t c_rx, double dist) const;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "d2dSchedule.h"
+
+d2dSchedule::d2dSchedule() {
+	numDevices 		= 0;
+	numTimeSlots 	= 0;
+	utility 		= 0.0;
+}
+
+void d2dSchedule::reset(uint32_t numDevices, int64_t numTimeSlots) {
+	this->numDevices 	= numDevices;
+	this->numTimeSlots 	= numTimeSlots;
+
+	role.assign(numDevices * numTimeSlots, D2D_ROLE_IDLE);
+	roleArg.assign(numDevices * numTimeSlots, 0);
+	exchanges.clear();
+	utility = 0.0;
+}
+
+const char* d2dSchedule::roleName(uint8_t role) {
+	switch (role) {
+		case D2D_ROLE_IDLE:
+			return "IDLE";
+		case D2D_ROLE_STARTAP:
+			return "StartAP";
+		case D2D_ROLE_SWITCHAP:
+			return "SwitchAP";
+		case D2D_ROLE_AP:
+			return "AP";
+		case D2D_ROLE_STARTCLIENT:
+			return "StartClient";
+		case D2D_ROLE_JOINAP:
+			return "JoinAP";
+		case D2D_ROLE_CLIENT:
+			return "Client";
+		default:
+			return "Unknown";
+	}
+}
+
+void d2dSchedule::print(std::ostream &out) const {
+	out << "STATES" << endl;
+	out << "------" << endl;
+	for (uint32_t d = 0; d<numDevices; d++) {
+		out << "Device " << d << endl;
+		for (int64_t t = 0; t<numTimeSlots; t++) {
+			uint8_t r = getRole(d, t);
+			out << roleName(r) << " " << d;
+			if (r == D2D_ROLE_STARTAP || r == D2D_ROLE_SWITCHAP || r == D2D_ROLE_AP) {
+				out << " chan " << getRoleArg(d, t);
+			} else if (r != D2D_ROLE_IDLE) {
+				out << " AP " << getRoleArg(d, t);
+			}
+			out << " time " << t << endl;
+		}
+		out << endl;
+	}
+
+	out << "content exchanges" << endl;
+	out << "------" << endl;
+	for (uint32_t i = 0; i<exchanges.size(); i++) {
+		const d2dExchange &ex = exchanges[i];
+		out << "PRV " << ex.d_prv << " -> CNS " << ex.d_cns << " CNT " << ex.n << " CH " << ex.c << " TIME " << ex.t << " DUR " << ex.duration << endl;
+	}
+	out << "Utility " << utility << endl;
+}
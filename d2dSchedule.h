@@ -0,0 +1,80 @@
+#ifndef D2DSCHEDULE_H
+#define D2DSCHEDULE_H
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+// role of a device in one time slot, the argument of a role is the channel
+// for the AP roles and the device index of the AP for the client roles
+#define D2D_ROLE_IDLE 			0
+#define D2D_ROLE_STARTAP 		1
+#define D2D_ROLE_SWITCHAP 		2
+#define D2D_ROLE_AP 			3
+#define D2D_ROLE_STARTCLIENT 	4
+#define D2D_ROLE_JOINAP 		5
+#define D2D_ROLE_CLIENT 		6
+
+using namespace std;
+
+// content n is sent from d_prv to d_cns on channel c in the time slots [t, t + duration)
+// with multicast, the receivers of one transmission are exchanges with equal d_prv, n, c, t and duration
+struct d2dExchange {
+	uint32_t d_prv;
+	uint32_t d_cns;
+	uint32_t n;
+	uint32_t c;
+	int64_t t;
+	int64_t duration;
+
+	d2dExchange(uint32_t d_prv, uint32_t d_cns, uint32_t n, uint32_t c, int64_t t, int64_t duration) {
+		this->d_prv 	= d_prv;
+		this->d_cns 	= d_cns;
+		this->n 		= n;
+		this->c 		= c;
+		this->t 		= t;
+		this->duration 	= duration;
+	}
+};
+
+// Solver independent representation of the schedule of one superslot, produced by the
+// optimizer or one of the heuristics.
+class d2dSchedule {
+
+	public:
+		uint32_t numDevices;
+		int64_t numTimeSlots;
+
+		// role[d * numTimeSlots + t]
+		std::vector<uint8_t> role;
+		std::vector<uint32_t> roleArg;
+
+		std::vector<d2dExchange> exchanges;
+
+		// sum of the utility of all exchanges
+		double utility;
+
+		d2dSchedule();
+
+		// all devices idle, no exchanges
+		void reset(uint32_t numDevices, int64_t numTimeSlots);
+
+		uint8_t getRole(uint32_t d, int64_t t) const {
+			return role[d * numTimeSlots + t];
+		}
+
+		uint32_t getRoleArg(uint32_t d, int64_t t) const {
+			return roleArg[d * numTimeSlots + t];
+		}
+
+		void setRole(uint32_t d, int64_t t, uint8_t newRole, uint32_t arg) {
+			role[d * numTimeSlots + t] 		= newRole;
+			roleArg[d * numTimeSlots + t] 	= arg;
+		}
+
+		static const char* roleName(uint8_t role);
+
+		void print(std::ostream &out) const;
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "d2dScheduleEncoder.h"
+
+d2dScheduleEncoder::d2dScheduleEncoder(d2dOptimizer *opt) {
+	this->opt = opt;
+}
+
+static bool earlierExchange(const d2dTimelineExchange &a, const d2dTimelineExchange &b) {
+	return a.t < b.t;
+}
+
+void d2dScheduleEncoder::slice(const d2dSchedule &schedule, std::vector<d2dDeviceTimeline> &timelines) const {
+	timelines.assign(schedule.numDevices, d2dDeviceTimeline());
+	for (uint32_t d = 0; d<schedule.numDevices; d++) {
+		d2dDeviceTimeline &timeline = timelines[d];
+		timeline.device 		= opt->deviceVector[d]->id;
+		timeline.numTimeSlots 	= schedule.numTimeSlots;
+		for (int64_t t = 0; t<schedule.numTimeSlots; t++) {
+			uint8_t r 		= schedule.getRole(d, t);
+			uint32_t arg 	= schedule.getRoleArg(d, t);
+			if (t > 0 && r == schedule.getRole(d, t-1) && arg == schedule.getRoleArg(d, t-1)) {
+				continue;
+			}
+			d2dStateChange change;
+			change.t 	= t;
+			change.role = r;
+			change.arg 	= 0;
+			if (r == D2D_ROLE_STARTAP || r == D2D_ROLE_SWITCHAP || r == D2D_ROLE_AP) {
+				change.arg = opt->channelVector[arg]->id;
+			} else if (r != D2D_ROLE_IDLE) {
+				change.arg = opt->deviceVector[arg]->id;
+			}
+			timeline.states.push_back(change);
+		}
+	}
+
+	//the receivers of one multicast transmission become one sending entry of the provider
+	std::vector<uint32_t> order(schedule.exchanges.size());
+	for (uint32_t i = 0; i<order.size(); i++) {
+		order[i] = i;
+	}
+	const std::vector<d2dExchange> &ex = schedule.exchanges;
+	std::sort(order.begin(), order.end(), [&ex](uint32_t a, uint32_t b) {
+		if (ex[a].d_prv != ex[b].d_prv) return ex[a].d_prv < ex[b].d_prv;
+		if (ex[a].t != ex[b].t) return ex[a].t < ex[b].t;
+		if (ex[a].n != ex[b].n) return ex[a].n < ex[b].n;
+		if (ex[a].c != ex[b].c) return ex[a].c < ex[b].c;
+		if (ex[a].duration != ex[b].duration) return ex[a].duration < ex[b].duration;
+		return ex[a].d_cns < ex[b].d_cns;
+	});
+	for (uint32_t i = 0; i<order.size(); i++) {
+		const d2dExchange &cur = ex[order[i]];
+		std::vector<d2dTimelineExchange> &sent = timelines[cur.d_prv].exchanges;
+		if (i == 0 || !(ex[order[i-1]].d_prv == cur.d_prv && ex[order[i-1]].t == cur.t && ex[order[i-1]].n == cur.n &&
+						ex[order[i-1]].c == cur.c && ex[order[i-1]].duration == cur.duration)) {
+			d2dTimelineExchange entry;
+			entry.receive 	= false;
+			entry.t 		= cur.t;
+			entry.duration 	= cur.duration;
+			entry.n 		= opt->contentVector[cur.n]->id;
+			entry.c 		= opt->channelVector[cur.c]->id;
+			sent.push_back(entry);
+		}
+		sent.back().peers.push_back(opt->deviceVector[cur.d_cns]->id);
+
+		d2dTimelineExchange entry;
+		entry.receive 	= true;
+		entry.t 		= cur.t;
+		entry.duration 	= cur.duration;
+		entry.n 		= opt->contentVector[cur.n]->id;
+		entry.c 		= opt->channelVector[cur.c]->id;
+		entry.peers.push_back(opt->deviceVector[cur.d_prv]->id);
+		timelines[cur.d_cns].exchanges.push_back(entry);
+	}
+	for (uint32_t d = 0; d<schedule.numDevices; d++) {
+		std::stable_sort(timelines[d].exchanges.begin(), timelines[d].exchanges.end(), earlierExchange);
+	}
+}
+
+void d2dScheduleEncoder::putVarint(uint64_t value, std::vector<uint8_t> &out) {
+	while (value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+bool d2dScheduleEncoder::getVarint(const uint8_t *data, size_t size, size_t &pos, uint64_t &value) {
+	value = 0;
+	for (uint32_t shift = 0; shift < 64 && pos < size; shift += 7) {
+		uint8_t byte = data[pos++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void d2dScheduleEncoder::encode(const d2dDeviceTimeline &timeline, std::vector<uint8_t> &out) {
+	out.push_back(D2D_DISPATCH_MAGIC);
+	out.push_back(D2D_DISPATCH_VERSION);
+	putVarint(timeline.device, out);
+	putVarint(timeline.numTimeSlots, out);
+
+	putVarint(timeline.states.size(), out);
+	int64_t last = 0;
+	for (uint32_t i = 0; i<timeline.states.size(); i++) {
+		const d2dStateChange &change = timeline.states[i];
+		putVarint(change.t - last, out);
+		out.push_back(change.role);
+		if (change.role != D2D_ROLE_IDLE) {
+			putVarint(change.arg, out);
+		}
+		last = change.t;
+	}
+
+	putVarint(timeline.exchanges.size(), out);
+	last = 0;
+	for (uint32_t i = 0; i<timeline.exchanges.size(); i++) {
+		const d2dTimelineExchange &entry = timeline.exchanges[i];
+		out.push_back(entry.receive ? 1 : 0);
+		putVarint(entry.t - last, out);
+		putVarint(entry.duration, out);
+		putVarint(entry.n, out);
+		putVarint(entry.c, out);
+		putVarint(entry.peers.size(), out);
+		for (uint32_t k = 0; k<entry.peers.size(); k++) {
+			putVarint(entry.peers[k], out);
+		}
+		last = entry.t;
+	}
+}
+
+bool d2dScheduleEncoder::decode(const uint8_t *data, size_t size, d2dDeviceTimeline &timeline) {
+	if (size < 2 || data[0] != D2D_DISPATCH_MAGIC || data[1] > D2D_DISPATCH_VERSION) {
+		return false;
+	}
+	size_t pos = 2;
+	uint64_t value = 0;
+	uint64_t count = 0;
+	if (!getVarint(data, size, pos, timeline.device) || !getVarint(data, size, pos, value)) {
+		return false;
+	}
+	timeline.numTimeSlots = value;
+
+	timeline.states.clear();
+	if (!getVarint(data, size, pos, count)) {
+		return false;
+	}
+	int64_t last = 0;
+	for (uint64_t i = 0; i<count; i++) {
+		d2dStateChange change;
+		change.arg = 0;
+		if (!getVarint(data, size, pos, value) || pos >= size) {
+			return false;
+		}
+		change.t 	= last + value;
+		change.role = data[pos++];
+		if (change.role != D2D_ROLE_IDLE && !getVarint(data, size, pos, change.arg)) {
+			return false;
+		}
+		last = change.t;
+		timeline.states.push_back(change);
+	}
+
+	timeline.exchanges.clear();
+	if (!getVarint(data, size, pos, count)) {
+		return false;
+	}
+	last = 0;
+	for (uint64_t i = 0; i<count; i++) {
+		d2dTimelineExchange entry;
+		uint64_t duration 	= 0;
+		uint64_t numPeers 	= 0;
+		if (pos >= size) {
+			return false;
+		}
+		entry.receive = data[pos++] != 0;
+		if (!getVarint(data, size, pos, value) || !getVarint(data, size, pos, duration) || !getVarint(data, size, pos, entry.n) ||
+			!getVarint(data, size, pos, entry.c) || !getVarint(data, size, pos, numPeers) || numPeers > size - pos) {
+			return false;
+		}
+		entry.t 		= last + value;
+		entry.duration 	= duration;
+		entry.peers.resize(numPeers);
+		for (uint64_t k = 0; k<numPeers; k++) {
+			if (!getVarint(data, size, pos, entry.peers[k])) {
+				return false;
+			}
+		}
+		last = entry.t;
+		timeline.exchanges.push_back(entry);
+	}
+	return pos == size;
+}
+
+bool d2dScheduleEncoder::write(const d2dSchedule &schedule, const std::string &fileName) const {
+	std::vector<d2dDeviceTimeline> timelines;
+	slice(schedule, timelines);
+
+	std::vector<uint8_t> out;
+	std::vector<uint8_t> message;
+	out.push_back(D2D_DISPATCH_MAGIC);
+	out.push_back(D2D_DISPATCH_VERSION);
+	putVarint(timelines.size(), out);
+	for (uint32_t d = 0; d<timelines.size(); d++) {
+		message.clear();
+		encode(timelines[d], message);
+		putVarint(message.size(), out);
+		out.insert(out.end(), message.begin(), message.end());
+	}
+
+	std::ofstream file(fileName.c_str(), std::ios::binary);
+	if (!file.is_open()) {
+		cerr << "Cannot write dispatch file " << fileName << endl;
+		return false;
+	}
+	file.write((const char*)out.data(), out.size());
+	return file.good();
+}
+
+bool d2dScheduleEncoder::read(const std::string &fileName, std::vector<d2dDeviceTimeline> &timelines) {
+	std::ifstream file(fileName.c_str(), std::ios::binary);
+	if (!file.is_open()) {
+		cerr << "Cannot read dispatch file " << fileName << endl;
+		return false;
+	}
+	std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	timelines.clear();
+	size_t pos = 2;
+	uint64_t count = 0;
+	if (in.size() < 2 || in[0] != D2D_DISPATCH_MAGIC || in[1] > D2D_DISPATCH_VERSION || !getVarint(in.data(), in.size(), pos, count)) {
+		cerr << "Invalid dispatch file " << fileName << endl;
+		return false;
+	}
+	for (uint64_t i = 0; i<count; i++) {
+		uint64_t length = 0;
+		timelines.push_back(d2dDeviceTimeline());
+		if (!getVarint(in.data(), in.size(), pos, length) || length > in.size() - pos ||
+			!decode(in.data() + pos, length, timelines.back())) {
+			cerr << "Invalid dispatch file " << fileName << endl;
+			return false;
+		}
+		pos += length;
+	}
+	return pos == in.size();
+}
@@ -0,0 +1,76 @@
+#ifndef D2DSCHEDULEENCODER_H
+#define D2DSCHEDULEENCODER_H
+
+#include <iterator>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// version of the binary dispatch format, decode() rejects messages of a newer version
+#define D2D_DISPATCH_VERSION 	1
+#define D2D_DISPATCH_MAGIC 		0xD2
+
+// role of the device from slot t on, arg is the channel id for the AP roles and the device id of
+// the AP for the client roles, 0 for Idle
+struct d2dStateChange {
+	int64_t t;
+	uint8_t role;
+	uint64_t arg;
+};
+
+// exchange of content n on channel c in the slots [t, t + duration), sent to all peers (several
+// receivers of one multicast transmission) or received from the single peer
+struct d2dTimelineExchange {
+	bool receive;
+	int64_t t;
+	int64_t duration;
+	uint64_t n;
+	uint64_t c;
+	std::vector<uint64_t> peers;
+};
+
+// commands of one device for one superslot, all ids are the ids of the instance
+struct d2dDeviceTimeline {
+	uint64_t device;
+	int64_t numTimeSlots;
+	// sorted by t, the first change is at slot 0
+	std::vector<d2dStateChange> states;
+	// sorted by t
+	std::vector<d2dTimelineExchange> exchanges;
+};
+
+// Cuts a d2dSchedule into per-device timelines and encodes them as small binary messages for the
+// control plane. A message holds only the role changes and the exchanges of the device:
+//   magic, version, device id, numTimeSlots,
+//   number of state changes, per change: slot delta, role, arg (not for Idle)
+//   number of exchanges, per exchange: receive flag, slot delta, duration, content id, channel id,
+//   number of peers, peer ids
+// All integers except magic, version, role and flag are unsigned LEB128 varints, the slots are
+// delta encoded against the previous entry. A dispatch file holds magic, version, the number of
+// messages and each message prefixed by its length in bytes.
+class d2dScheduleEncoder {
+
+	public:
+		// opt provides the ids of devices, channels and content
+		d2dScheduleEncoder(d2dOptimizer *opt);
+
+		// one timeline per device of the schedule, in device order
+		void slice(const d2dSchedule &schedule, std::vector<d2dDeviceTimeline> &timelines) const;
+
+		// appends the message of timeline to out
+		static void encode(const d2dDeviceTimeline &timeline, std::vector<uint8_t> &out);
+		// false for a truncated or malformed message or an unsupported version
+		static bool decode(const uint8_t *data, size_t size, d2dDeviceTimeline &timeline);
+
+		// writes the messages of all devices of schedule into a dispatch file
+		bool write(const d2dSchedule &schedule, const std::string &fileName) const;
+		static bool read(const std::string &fileName, std::vector<d2dDeviceTimeline> &timelines);
+
+	private:
+		d2dOptimizer *opt;
+
+		static void putVarint(uint64_t value, std::vector<uint8_t> &out);
+		static bool getVarint(const uint8_t *data, size_t size, size_t &pos, uint64_t &value);
+};
+
+#endif
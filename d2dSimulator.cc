@@ -0,0 +1,407 @@
+#include "d2dSimulator.h"
+
+d2dRandomInterestModel::d2dRandomInterestModel(double probability, uint32_t seed) {
+	this->probability = probability;
+	rng.seed(seed);
+}
+
+void d2dRandomInterestModel::arrivals(d2dOptimizer *opt, uint32_t /*superslot*/, std::vector< std::pair<uint32_t, uint32_t> > &interests) {
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	for (uint32_t d = 0; d<opt->deviceVector.size(); d++) {
+		for (uint32_t n = 0; n<opt->contentVector.size(); n++) {
+			if (opt->P[d][n] == 0 && opt->I[d][n] == 0 && uniform(rng) < probability) {
+				interests.push_back(std::make_pair(d, n));
+			}
+		}
+	}
+}
+
+d2dRandomLinkModel::d2dRandomLinkModel(double availability, uint32_t seed) {
+	this->availability = availability;
+	rng.seed(seed);
+}
+
+void d2dRandomLinkModel::move(d2dOptimizer *opt, uint32_t /*superslot*/) {
+	uint32_t numDev 	= opt->deviceVector.size();
+	uint32_t numChan 	= opt->channelVector.size();
+	if (initialL.empty()) {
+		initialL.resize((uint64_t)numDev * numDev * numChan);
+		for (uint32_t d_prv = 0; d_prv<numDev; d_prv++) {
+			for (uint32_t d_cns = 0; d_cns<numDev; d_cns++) {
+				for (uint32_t c = 0; c<numChan; c++) {
+					initialL[((uint64_t)d_prv * numDev + d_cns) * numChan + c] = opt->L[d_prv][d_cns][c];
+				}
+			}
+		}
+	}
+
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	for (uint32_t d_prv = 0; d_prv<numDev; d_prv++) {
+		for (uint32_t d_cns = 0; d_cns<numDev; d_cns++) {
+			for (uint32_t c = 0; c<numChan; c++) {
+				long speed = initialL[((uint64_t)d_prv * numDev + d_cns) * numChan + c];
+				opt->L[d_prv][d_cns][c] = speed > 0 && uniform(rng) < availability ? speed : 0;
+			}
+		}
+	}
+}
+
+d2dPopularityCachePolicy::d2dPopularityCachePolicy(double cacheFraction, uint32_t numItems, double prefetchUtility) {
+	this->cacheFraction 	= cacheFraction;
+	this->numItems 			= numItems;
+	this->prefetchUtility 	= prefetchUtility;
+	smoothing 	= 0.5;
+	numCont 	= 0;
+}
+
+void d2dPopularityCachePolicy::place(d2dOptimizer *opt, uint32_t /*superslot*/, const std::vector< std::pair<uint32_t, uint32_t> > &arrivals) {
+	uint32_t numDev 	= opt->deviceVector.size();
+	uint32_t numChan 	= opt->channelVector.size();
+	if (popularity.empty()) {
+		numCont = opt->contentVector.size();
+		popularity.assign(numCont, 0.0);
+		pending.assign((uint64_t)numDev * numCont, 0);
+		cached.assign((uint64_t)numDev * numCont, 0);
+	}
+	for (uint32_t n = 0; n<numCont; n++) {
+		popularity[n] *= smoothing;
+	}
+	for (uint32_t i = 0; i<arrivals.size(); i++) {
+		popularity[arrivals[i].second] += 1.0;
+	}
+
+	//delivered prefetches are cached
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (uint32_t n = 0; n<numCont; n++) {
+			if (pending[d * numCont + n] && opt->P[d][n] == 1) {
+				pending[d * numCont + n] 	= 0;
+				cached[d * numCont + n] 	= 1;
+				resetUtility(opt, d, n);
+			}
+		}
+	}
+
+	std::vector<uint32_t> ranked(numCont);
+	for (uint32_t n = 0; n<numCont; n++) {
+		ranked[n] = n;
+	}
+	std::stable_sort(ranked.begin(), ranked.end(), [&](uint32_t a, uint32_t b) {
+		return popularity[a] > popularity[b];
+	});
+	std::vector<char> popular(numCont, 0);
+	for (uint32_t i = 0; i<std::min(numItems, numCont) && popularity[ranked[i]] > 0.0; i++) {
+		popular[ranked[i]] = 1;
+	}
+
+	//devices with the most neighbors are caches
+	std::vector< std::pair<uint32_t, uint32_t> > neighbors(numDev);
+	for (uint32_t d = 0; d<numDev; d++) {
+		uint32_t count = 0;
+		for (uint32_t e = 0; e<numDev; e++) {
+			bool link = false;
+			for (uint32_t c = 0; c<numChan && !link; c++) {
+				link = opt->L[d][e][c] > 0;
+			}
+			count += e != d && link;
+		}
+		neighbors[d] = std::make_pair(count, d);
+	}
+	std::stable_sort(neighbors.begin(), neighbors.end(), [](const std::pair<uint32_t, uint32_t> &a, const std::pair<uint32_t, uint32_t> &b) {
+		return a.first > b.first;
+	});
+	std::vector<char> isCache(numDev, 0);
+	for (uint32_t i = 0; i<std::min<uint32_t>(cacheFraction * numDev, numDev); i++) {
+		isCache[neighbors[i].second] = 1;
+	}
+
+	for (uint32_t d = 0; d<numDev; d++) {
+		//withdraw prefetches and drop cached content that is no longer popular
+		for (uint32_t n = 0; n<numCont; n++) {
+			uint64_t i = (uint64_t)d * numCont + n;
+			if (isCache[d] && popular[n]) {
+				continue;
+			}
+			if (pending[i]) {
+				opt->I[d][n] 	= 0;
+				pending[i] 		= 0;
+				resetUtility(opt, d, n);
+			}
+			if (cached[i]) {
+				opt->P[d][n] 	= 0;
+				cached[i] 		= 0;
+			}
+		}
+
+		//requests of the user take precedence over cached content, the least popular is dropped first
+		int64_t storage = opt->freeStorage(d);
+		if (storage >= 0) {
+			int64_t requested = 0;
+			for (uint32_t n = 0; n<numCont; n++) {
+				requested += opt->I[d][n] == 1 && opt->P[d][n] == 0 && !pending[d * numCont + n] ? opt->S[n] : 0;
+			}
+			for (int64_t r = numCont - 1; r >= 0 && storage < requested; r--) {
+				uint32_t n = ranked[r];
+				if (cached[d * numCont + n]) {
+					opt->P[d][n] 				= 0;
+					cached[d * numCont + n] 	= 0;
+					storage 					+= opt->S[n];
+				}
+			}
+			storage -= requested;
+		}
+
+		if (!isCache[d]) {
+			continue;
+		}
+		for (uint32_t r = 0; r<numCont && popular[ranked[r]]; r++) {
+			uint32_t n = ranked[r];
+			//held, requested or prefetched already
+			if (opt->P[d][n] == 1 || opt->I[d][n] == 1) {
+				continue;
+			}
+			if (storage >= 0 && storage < opt->S[n]) {
+				continue;
+			}
+			if (storage >= 0) {
+				storage -= opt->S[n];
+			}
+			addPrefetch(opt, d, n);
+		}
+	}
+}
+
+void d2dPopularityCachePolicy::addPrefetch(d2dOptimizer *opt, uint32_t d, uint32_t n) {
+	opt->I[d][n] 				= 1;
+	pending[d * numCont + n] 	= 1;
+	//the previous utility of each provider is restored by resetUtility()
+	std::vector< std::pair<uint32_t, double> > &saved = savedUtility[std::make_pair(d, n)];
+	for (uint32_t d_prv = 0; d_prv<opt->deviceVector.size(); d_prv++) {
+		if (d_prv != d) {
+			saved.push_back(std::make_pair(d_prv, opt->U[d_prv][d][n]));
+			opt->U[d_prv][d][n] = prefetchUtility;
+		}
+	}
+}
+
+void d2dPopularityCachePolicy::resetUtility(d2dOptimizer *opt, uint32_t d, uint32_t n) {
+	std::map< std::pair<uint32_t, uint32_t>, std::vector< std::pair<uint32_t, double> > >::iterator it = savedUtility.find(std::make_pair(d, n));
+	if (it == savedUtility.end()) {
+		return;
+	}
+	for (uint32_t i = 0; i<it->second.size(); i++) {
+		opt->U[it->second[i].first][d][n] = it->second[i].second;
+	}
+	savedUtility.erase(it);
+}
+
+void d2dPopularityCachePolicy::claim(d2dOptimizer *opt, uint32_t d, uint32_t n) {
+	pending[d * numCont + n] = 0;
+	resetUtility(opt, d, n);
+}
+
+d2dSimulator::d2dSimulator(d2dOptimizer *opt, d2dInterestModel *interestModel, d2dMobilityModel *mobilityModel) {
+	this->opt 			= opt;
+	this->interestModel = interestModel;
+	this->mobilityModel = mobilityModel;
+	this->chunker 		= NULL;
+	this->cachePolicy 	= NULL;
+	this->horizon 		= NULL;
+}
+
+void d2dSimulator::addInterests(uint32_t superslot, std::vector< std::pair<uint32_t, uint32_t> > &arrivals) {
+	if (interestModel == NULL) {
+		return;
+	}
+	uint32_t numCont = opt->contentVector.size();
+	std::vector< std::pair<uint32_t, uint32_t> > interests;
+	interestModel->arrivals(opt, superslot, interests);
+	for (uint32_t i = 0; i<interests.size(); i++) {
+		uint32_t d = interests[i].first;
+		uint32_t n = interests[i].second;
+		uint32_t last = n + 1;
+		if (chunker != NULL) {
+			if (n != chunker->firstChunk[contentOf(n)]) {
+				continue;
+			}
+			last = chunker->firstChunk[contentOf(n) + 1];
+		}
+		if (opt->P[d][n] != 0 || (opt->I[d][n] != 0 && !prefetch(d, n))) {
+			continue;
+		}
+		for (uint32_t k = n; k<last; k++) {
+			if (opt->P[d][k] == 0) {
+				if (prefetch(d, k)) {
+					cachePolicy->claim(opt, d, k);
+				}
+				opt->I[d][k] 			= 1;
+				arrival[d * numCont + k] = superslot * opt->settings.tau;
+			}
+		}
+		arrivals.push_back(std::make_pair(d, n));
+	}
+}
+
+void d2dSimulator::apply(const d2dSchedule &schedule, uint32_t superslot, d2dSuperslotStats &slotStats) {
+	uint32_t numCont = opt->contentVector.size();
+	double slotLength = opt->settings.slotLengthInSeconds();
+	//last delivery per device and content of the unchunked instance in this superslot
+	std::map< std::pair<uint32_t, uint32_t>, double > delivered;
+	for (uint32_t i = 0; i<schedule.exchanges.size(); i++) {
+		const d2dExchange &ex = schedule.exchanges[i];
+		opt->P[ex.d_cns][ex.n] = 1;
+		opt->I[ex.d_cns][ex.n] = 0;
+
+		slotStats.bytes += opt->S[ex.n];
+		slotStats.exchanges++;
+		if (prefetch(ex.d_cns, ex.n)) {
+			slotStats.prefetches++;
+			continue;
+		}
+		double end = superslot * opt->settings.tau + (ex.t + ex.duration) * slotLength;
+		std::pair<uint32_t, uint32_t> key(ex.d_cns, contentOf(ex.n));
+		delivered[key] = std::max(delivered[key], end);
+	}
+	for (std::map< std::pair<uint32_t, uint32_t>, double >::iterator it = delivered.begin(); it != delivered.end(); it++) {
+		uint32_t d = it->first.first;
+		uint32_t n = it->first.second;
+		if (chunker == NULL) {
+			latencies.push_back(it->second - arrival[d * numCont + n]);
+		} else if (chunker->complete(opt, d, n)) {
+			latencies.push_back(it->second - arrival[d * numCont + chunker->firstChunk[n]]);
+		}
+	}
+	slotStats.utility = schedule.utility;
+}
+
+void d2dSimulator::carryRoles(const d2dSchedule &schedule) {
+	int64_t t = schedule.numTimeSlots - 1;
+	for (uint32_t d = 0; d<opt->deviceVector.size(); d++) {
+		for (uint32_t c = 0; c<opt->channelVector.size(); c++) {
+			opt->START_AP[d][c] = 0;
+		}
+		for (uint32_t d_ap = 0; d_ap<opt->deviceVector.size(); d_ap++) {
+			opt->START_Client[d][d_ap] = 0;
+		}
+		opt->START_Idle[d] = 1;
+
+		if (t < 0) {
+			continue;
+		}
+		uint8_t role = schedule.getRole(d, t);
+		uint32_t arg = schedule.getRoleArg(d, t);
+		if (role == D2D_ROLE_AP) {
+			opt->START_AP[d][arg] 	= 1;
+			opt->START_Idle[d] 		= 0;
+		} else if (role == D2D_ROLE_CLIENT && schedule.getRole(arg, t) == D2D_ROLE_AP) {
+			opt->START_Client[d][arg] 	= 1;
+			opt->START_Idle[d] 			= 0;
+		}
+	}
+}
+
+uint64_t d2dSimulator::pendingInterests() {
+	uint64_t count = 0;
+	std::vector<uint32_t> wanted;
+	for (uint32_t d = 0; d<opt->deviceVector.size(); d++) {
+		//interested and not held, a chunked content counts once
+		wanted.clear();
+		opt->I.columns(d, &opt->P, d, wanted);
+		int64_t last = -1;
+		for (uint32_t i = 0; i<wanted.size(); i++) {
+			uint32_t n = wanted[i];
+			if (!prefetch(d, n) && contentOf(n) != last) {
+				last = contentOf(n);
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+void d2dSimulator::run(uint32_t numSuperslots) {
+	stats.clear();
+	latencies.clear();
+	//interests of the instance arrive at time 0
+	arrival.assign(opt->deviceVector.size() * opt->contentVector.size(), 0.0);
+
+	for (uint32_t k = 0; k<numSuperslots; k++) {
+		std::vector< std::pair<uint32_t, uint32_t> > arrivals;
+		addInterests(k, arrivals);
+		if (mobilityModel != NULL) {
+			mobilityModel->move(opt, k);
+		}
+		if (cachePolicy != NULL) {
+			cachePolicy->place(opt, k, arrivals);
+		}
+
+		d2dSuperslotStats slotStats;
+		slotStats.superslot = k;
+		slotStats.exchanges = 0;
+		slotStats.prefetches = 0;
+		slotStats.bytes 	= 0;
+		slotStats.utility 	= 0.0;
+
+		std::clock_t cpuBegin = std::clock();
+		std::chrono::steady_clock::time_point wallBegin = std::chrono::steady_clock::now();
+		if (horizon != NULL) {
+			horizon->plan(opt);
+		}
+		slotStats.status = opt->optimize();
+		slotStats.cpuSeconds 	= (double)(std::clock() - cpuBegin) / CLOCKS_PER_SEC;
+		slotStats.wallSeconds 	= std::chrono::duration<double>(std::chrono::steady_clock::now() - wallBegin).count();
+
+		if (slotStats.status != D2D_STATUS_OPTIMAL && slotStats.status != D2D_STATUS_FEASIBLE) {
+			cout << "Superslot " << k << ": no schedule (status " << slotStats.status << "), simulation stopped" << endl;
+			slotStats.pendingInterests = pendingInterests();
+			stats.push_back(slotStats);
+			break;
+		}
+
+		apply(opt->schedule, k, slotStats);
+		carryRoles(opt->schedule);
+		slotStats.pendingInterests = pendingInterests();
+		stats.push_back(slotStats);
+	}
+}
+
+void d2dSimulator::print(std::ostream &out) {
+	uint64_t bytes = 0;
+	double cpuSeconds = 0.0;
+	out << "SIMULATION" << endl;
+	out << "------" << endl;
+	for (uint32_t i = 0; i<stats.size(); i++) {
+		const d2dSuperslotStats &s = stats[i];
+		out << "superslot " << s.superslot << " status " << s.status << " exchanges " << s.exchanges << " bytes " << s.bytes
+			<< " utility " << s.utility << " cpu " << s.cpuSeconds << " s wall " << s.wallSeconds << " s pending " << s.pendingInterests;
+		if (cachePolicy != NULL) {
+			out << " prefetches " << s.prefetches;
+		}
+		out << endl;
+		bytes 		+= s.bytes;
+		cpuSeconds 	+= s.cpuSeconds;
+	}
+
+	double seconds = stats.size() * opt->settings.tau;
+	out << "simulated " << seconds << " s, delivered " << bytes << " bytes, " << (seconds > 0.0 ? bytes / seconds : 0.0) << " bytes/s" << endl;
+	if (stats.size() > 0) {
+		out << "scheduler cpu " << cpuSeconds / stats.size() << " s per superslot" << endl;
+	}
+
+	if (latencies.empty()) {
+		out << "no deliveries" << endl;
+		return;
+	}
+	std::vector<double> sorted(latencies);
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (uint32_t i = 0; i<sorted.size(); i++) {
+		sum += sorted[i];
+	}
+	const double quantiles[4] = { 0.5, 0.9, 0.99, 1.0 };
+	out << "latency mean " << sum / sorted.size() << " s";
+	for (uint32_t i = 0; i<4; i++) {
+		size_t index = std::min(sorted.size() - 1, (size_t)ceil(quantiles[i] * sorted.size()) - 1);
+		out << " p" << quantiles[i] * 100 << " " << sorted[index];
+	}
+	out << " (" << sorted.size() << " deliveries)" << endl;
+}
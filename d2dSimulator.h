@@ -0,0 +1,191 @@
+#ifndef D2DSIMULATOR_H
+#define D2DSIMULATOR_H
+
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <map>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+#include "d2dContentChunker.h"
+#include "d2dRollingHorizon.h"
+
+// Adds interests at the beginning of a superslot. Returned pairs (d, n) for content the device
+// already holds or is already interested in are ignored.
+class d2dInterestModel {
+
+	public:
+		virtual ~d2dInterestModel() {}
+
+		virtual void arrivals(d2dOptimizer *opt, uint32_t superslot, std::vector< std::pair<uint32_t, uint32_t> > &interests) = 0;
+};
+
+// Each device becomes interested in each content it does not hold with a fixed probability per superslot.
+class d2dRandomInterestModel : public d2dInterestModel {
+
+	public:
+		double probability;
+
+		d2dRandomInterestModel(double probability, uint32_t seed);
+
+		void arrivals(d2dOptimizer *opt, uint32_t superslot, std::vector< std::pair<uint32_t, uint32_t> > &interests);
+
+	private:
+		std::mt19937 rng;
+};
+
+// Changes the link speeds L and interference X between superslots.
+class d2dMobilityModel {
+
+	public:
+		virtual ~d2dMobilityModel() {}
+
+		virtual void move(d2dOptimizer *opt, uint32_t superslot) = 0;
+};
+
+// Devices do not move.
+class d2dStaticMobilityModel : public d2dMobilityModel {
+
+	public:
+		void move(d2dOptimizer */*opt*/, uint32_t /*superslot*/) {}
+};
+
+// Each link of the initial instance is available with a fixed probability per superslot,
+// e.g. devices moving in and out of range. Available links keep their initial speed.
+class d2dRandomLinkModel : public d2dMobilityModel {
+
+	public:
+		double availability;
+
+		d2dRandomLinkModel(double availability, uint32_t seed);
+
+		void move(d2dOptimizer *opt, uint32_t superslot);
+
+	private:
+		std::mt19937 rng;
+		// initial L[d_prv][d_cns][c], recorded in the first move()
+		std::vector<long> initialL;
+};
+
+// Proactive replication between superslots. The policy adds interests of devices in content they
+// should cache (prefetch interests) and may drop cached content, the scheduler delivers prefetched
+// content like requested content. Prefetch interests do not count as pending or satisfied interests.
+class d2dCachePolicy {
+
+	public:
+		virtual ~d2dCachePolicy() {}
+
+		// called at the beginning of each superslot with the interests that arrived in it
+		virtual void place(d2dOptimizer *opt, uint32_t superslot, const std::vector< std::pair<uint32_t, uint32_t> > &arrivals) = 0;
+		// interest of device d in content n was added by the policy
+		virtual bool prefetch(uint32_t d, uint32_t n) = 0;
+		// the user of device d requests content n that is prefetched for d, the interest becomes a request
+		virtual void claim(d2dOptimizer *opt, uint32_t d, uint32_t n) = 0;
+};
+
+// Places the most popular content on the best connected devices. The popularity of a content is
+// the number of requests per superslot, exponentially smoothed over the superslots. The devices
+// with the most neighbors (L > 0 on any channel) are caches and prefetch the numItems most popular
+// content they do not hold, with utility prefetchUtility for every provider. Content a cache
+// prefetched earlier is dropped when it is no longer among the most popular or storage is needed.
+class d2dPopularityCachePolicy : public d2dCachePolicy {
+
+	public:
+		// fraction of the devices used as caches
+		double cacheFraction;
+		uint32_t numItems;
+		// below the utility of requests, so that prefetching uses otherwise idle capacity
+		double prefetchUtility;
+		// weight of the previous popularity
+		double smoothing;
+
+		d2dPopularityCachePolicy(double cacheFraction, uint32_t numItems, double prefetchUtility);
+
+		void place(d2dOptimizer *opt, uint32_t superslot, const std::vector< std::pair<uint32_t, uint32_t> > &arrivals);
+		bool prefetch(uint32_t d, uint32_t n) {
+			return !pending.empty() && pending[d * numCont + n];
+		}
+		void claim(d2dOptimizer *opt, uint32_t d, uint32_t n);
+
+	private:
+		uint32_t numCont;
+		std::vector<double> popularity;
+		// pending[d * numCont + n] prefetch interest, cached: held because of a prefetch
+		std::vector<char> pending;
+		std::vector<char> cached;
+		// providers and their previous utility U[d_prv][d][n] per prefetch (d, n)
+		std::map< std::pair<uint32_t, uint32_t>, std::vector< std::pair<uint32_t, double> > > savedUtility;
+
+		void addPrefetch(d2dOptimizer *opt, uint32_t d, uint32_t n);
+		// removes the prefetch utilities of (d, n)
+		void resetUtility(d2dOptimizer *opt, uint32_t d, uint32_t n);
+};
+
+struct d2dSuperslotStats {
+	uint32_t superslot;
+	int32_t status;
+	uint32_t exchanges;
+	// exchanges of prefetched content
+	uint32_t prefetches;
+	uint64_t bytes;
+	double utility;
+	// process CPU time and wall time of optimize(), including the rolling-horizon plan
+	double cpuSeconds;
+	double wallSeconds;
+	// interests not satisfied at the end of the superslot
+	uint64_t pendingInterests;
+};
+
+// Runs the scheduler of opt (opt->mode) over consecutive superslots and carries the state forward:
+// received content is held in the next superslot, satisfied interests are removed and the AP and
+// client roles at the end of a superslot become the initial states of the next one, like state.dat.
+// Devices setting up a role at the end of a superslot start the next one Idle. Sizes S are counted
+// as bytes, latencies are measured from the interest arrival to the end of the exchange.
+// With a chunker opt holds the chunked instance: an interest returned for the first chunk of a
+// content is an interest in all of its chunks (arrivals for the other chunks are ignored), and
+// interests and latencies are counted per content, until its last chunk is received.
+class d2dSimulator {
+
+	public:
+		d2dOptimizer *opt;
+		// not owned, NULL for no new interests / static devices
+		d2dInterestModel *interestModel;
+		d2dMobilityModel *mobilityModel;
+		// not owned, NULL if the content of opt is not chunked
+		const d2dContentChunker *chunker;
+		// not owned, NULL for no proactive replication
+		d2dCachePolicy *cachePolicy;
+		// not owned, NULL to schedule each superslot on its own
+		d2dRollingHorizon *horizon;
+
+		std::vector<d2dSuperslotStats> stats;
+		// delivery latency in seconds of all satisfied interests
+		std::vector<double> latencies;
+
+		d2dSimulator(d2dOptimizer *opt, d2dInterestModel *interestModel, d2dMobilityModel *mobilityModel);
+
+		// simulates numSuperslots superslots, stops early if the scheduler does not return a schedule
+		void run(uint32_t numSuperslots);
+
+		void print(std::ostream &out);
+
+	private:
+		// arrival time in seconds of the interest of device d in content n, arrival[d * numCont + n]
+		std::vector<double> arrival;
+
+		// adds the interests of the superslot to arrivals
+		void addInterests(uint32_t superslot, std::vector< std::pair<uint32_t, uint32_t> > &arrivals);
+		void apply(const d2dSchedule &schedule, uint32_t superslot, d2dSuperslotStats &slotStats);
+		void carryRoles(const d2dSchedule &schedule);
+		uint64_t pendingInterests();
+		bool prefetch(uint32_t d, uint32_t n) {
+			return cachePolicy != NULL && cachePolicy->prefetch(d, n);
+		}
+		// content of the unchunked instance
+		uint32_t contentOf(uint32_t n) {
+			return chunker == NULL ? n : chunker->chunkContent[n];
+		}
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include "d2dSolutionCache.h"
+
+// hash of the multiset terms combined with color
+static uint64_t refineColor(uint64_t color, std::vector<uint64_t> &terms) {
+	std::sort(terms.begin(), terms.end());
+	uint64_t h = d2dHashCombine(0, color);
+	for (uint32_t i = 0; i<terms.size(); i++) {
+		h = d2dHashCombine(h, terms[i]);
+	}
+	return h;
+}
+
+static uint32_t numColors(std::vector<uint64_t> colors) {
+	std::sort(colors.begin(), colors.end());
+	return std::unique(colors.begin(), colors.end()) - colors.begin();
+}
+
+// rank[i] = position of i ordered by color, equal colors by index
+static void rankByColor(const std::vector<uint64_t> &colors, std::vector<uint32_t> &rank) {
+	std::vector<uint32_t> order(colors.size());
+	for (uint32_t i = 0; i<order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&colors](uint32_t a, uint32_t b) {
+		return colors[a] != colors[b] ? colors[a] < colors[b] : a < b;
+	});
+	rank.resize(colors.size());
+	for (uint32_t i = 0; i<order.size(); i++) {
+		rank[order[i]] = i;
+	}
+}
+
+static void inverse(const std::vector<uint32_t> &rank, std::vector<uint32_t> &at) {
+	at.resize(rank.size());
+	for (uint32_t i = 0; i<rank.size(); i++) {
+		at[rank[i]] = i;
+	}
+}
+
+d2dSolutionCache::d2dSolutionCache(uint32_t capacity) {
+	this->capacity 	= capacity;
+	hits 			= 0;
+	misses 			= 0;
+	lastKey 		= 0;
+}
+
+uint64_t d2dSolutionCache::fingerprint(d2dOptimizer *opt) {
+	uint32_t numDev 	= opt->deviceVector.size();
+	uint32_t numChan 	= opt->channelVector.size();
+	uint32_t numCont 	= opt->contentVector.size();
+	opt->updateInterferenceList();
+
+	std::vector<uint64_t> devColor(numDev);
+	std::vector<uint64_t> chanColor(numChan, 2);
+	std::vector<uint64_t> contColor(numCont);
+	for (uint32_t d = 0; d<numDev; d++) {
+		devColor[d] = d2dHashCombine(d2dHashCombine(1, opt->deviceVector[d]->capacity), opt->START_Idle[d]);
+	}
+	for (uint32_t n = 0; n<numCont; n++) {
+		contColor[n] = d2dHashCombine(3, opt->S[n]);
+	}
+
+	//each parameter entry adds a term with the colors of the other indices to all of its indices
+	std::vector< std::vector<uint64_t> > devTerms(numDev);
+	std::vector< std::vector<uint64_t> > chanTerms(numChan);
+	std::vector< std::vector<uint64_t> > contTerms(numCont);
+	uint32_t classes = numColors(devColor) + numColors(chanColor) + numColors(contColor);
+	for (;;) {
+		for (uint32_t d = 0; d<numDev; d++) {
+			for (uint32_t n = 0; n<numCont; n++) {
+				if (opt->P[d][n] != 0 || opt->I[d][n] != 0 || opt->D[d][n] >= 0) {
+					uint64_t value = d2dHashCombine(d2dHashCombine(d2dHashCombine(0, opt->P[d][n]), opt->I[d][n]), opt->D[d][n]);
+					devTerms[d].push_back(d2dHashCombine(d2dHashCombine(1, contColor[n]), value));
+					contTerms[n].push_back(d2dHashCombine(d2dHashCombine(1, devColor[d]), value));
+				}
+			}
+			for (uint32_t c = 0; c<numChan; c++) {
+				if (opt->W[d][c] != 0 || opt->START_AP[d][c] != 0) {
+					uint64_t value = d2dHashCombine(d2dHashCombine(0, opt->W[d][c]), opt->START_AP[d][c]);
+					devTerms[d].push_back(d2dHashCombine(d2dHashCombine(2, chanColor[c]), value));
+					chanTerms[c].push_back(d2dHashCombine(d2dHashCombine(2, devColor[d]), value));
+				}
+				for (uint32_t i = 0; i<opt->interferenceList[d * numChan + c].size(); i++) {
+					uint32_t d_rx = opt->interferenceList[d * numChan + c][i].first;
+					uint32_t c_rx = opt->interferenceList[d * numChan + c][i].second;
+					devTerms[d].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(9, chanColor[c]), devColor[d_rx]), chanColor[c_rx]));
+					devTerms[d_rx].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(10, devColor[d]), chanColor[c]), chanColor[c_rx]));
+					chanTerms[c].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(9, devColor[d]), devColor[d_rx]), chanColor[c_rx]));
+					chanTerms[c_rx].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(10, devColor[d]), chanColor[c]), devColor[d_rx]));
+				}
+			}
+			for (uint32_t b = 0; b<numDev; b++) {
+				if (opt->START_Client[d][b] != 0) {
+					devTerms[d].push_back(d2dHashCombine(3, devColor[b]));
+					devTerms[b].push_back(d2dHashCombine(4, devColor[d]));
+				}
+				for (uint32_t c = 0; c<numChan; c++) {
+					if (opt->L[d][b][c] > 0) {
+						uint64_t value = opt->L[d][b][c];
+						devTerms[d].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(5, devColor[b]), chanColor[c]), value));
+						devTerms[b].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(6, devColor[d]), chanColor[c]), value));
+						chanTerms[c].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(5, devColor[d]), devColor[b]), value));
+					}
+				}
+				for (uint32_t n = 0; n<numCont; n++) {
+					if (opt->U[d][b][n] != 0.0) {
+						uint64_t value = d2dHashDouble(opt->U[d][b][n]);
+						devTerms[d].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(7, devColor[b]), contColor[n]), value));
+						devTerms[b].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(8, devColor[d]), contColor[n]), value));
+						contTerms[n].push_back(d2dHashCombine(d2dHashCombine(d2dHashCombine(7, devColor[d]), devColor[b]), value));
+					}
+				}
+			}
+		}
+		for (uint32_t d = 0; d<numDev; d++) {
+			devColor[d] = refineColor(devColor[d], devTerms[d]);
+			devTerms[d].clear();
+		}
+		for (uint32_t c = 0; c<numChan; c++) {
+			chanColor[c] = refineColor(chanColor[c], chanTerms[c]);
+			chanTerms[c].clear();
+		}
+		for (uint32_t n = 0; n<numCont; n++) {
+			contColor[n] = refineColor(contColor[n], contTerms[n]);
+			contTerms[n].clear();
+		}
+		//the partition only gets finer, it is stable when the number of classes does not grow
+		uint32_t refined = numColors(devColor) + numColors(chanColor) + numColors(contColor);
+		if (refined == classes) {
+			break;
+		}
+		classes = refined;
+	}
+
+	rankByColor(devColor, deviceRank);
+	rankByColor(chanColor, channelRank);
+	rankByColor(contColor, contentRank);
+	std::vector<uint32_t> devAt;
+	std::vector<uint32_t> chanAt;
+	std::vector<uint32_t> contAt;
+	inverse(deviceRank, devAt);
+	inverse(channelRank, chanAt);
+	inverse(contentRank, contAt);
+
+	//model options and parameters in canonical order
+	uint64_t h = d2dHashCombine(0, numDev);
+	h = d2dHashCombine(h, numChan);
+	h = d2dHashCombine(h, numCont);
+	h = d2dHashCombine(h, opt->settings.numTimeSlots);
+	h = d2dHashCombine(h, d2dHashDouble(opt->settings.tau));
+	h = d2dHashCombine(h, opt->settings.kappa_startAP);
+	h = d2dHashCombine(h, opt->settings.kappa_startClient);
+	h = d2dHashCombine(h, opt->mode);
+	h = d2dHashCombine(h, opt->channelReuse);
+	h = d2dHashCombine(h, opt->multicast);
+	h = d2dHashCombine(h, opt->airtimeSharing);
+	h = d2dHashCombine(h, opt->utilityDecay);
+	h = d2dHashCombine(h, d2dHashDouble(opt->decayRate));
+	h = d2dHashCombine(h, opt->decaySlot);
+	for (uint32_t n = 0; n<numCont; n++) {
+		h = d2dHashCombine(h, opt->S[contAt[n]]);
+	}
+	std::vector< std::pair<uint32_t, uint32_t> > receivers;
+	for (uint32_t i = 0; i<numDev; i++) {
+		uint32_t d = devAt[i];
+		h = d2dHashCombine(h, opt->deviceVector[d]->capacity);
+		h = d2dHashCombine(h, opt->START_Idle[d]);
+		for (uint32_t k = 0; k<numCont; k++) {
+			uint32_t n = contAt[k];
+			h = d2dHashCombine(d2dHashCombine(d2dHashCombine(h, opt->P[d][n]), opt->I[d][n]), opt->D[d][n]);
+		}
+		for (uint32_t k = 0; k<numChan; k++) {
+			uint32_t c = chanAt[k];
+			h = d2dHashCombine(d2dHashCombine(h, opt->W[d][c]), opt->START_AP[d][c]);
+			if (!opt->terminalAP.empty()) {
+				h = d2dHashCombine(h, d2dHashDouble(opt->terminalAP[d * numChan + c]));
+			}
+
+			receivers.clear();
+			for (uint32_t r = 0; r<opt->interferenceList[d * numChan + c].size(); r++) {
+				receivers.push_back(std::make_pair(deviceRank[opt->interferenceList[d * numChan + c][r].first],
+												   channelRank[opt->interferenceList[d * numChan + c][r].second]));
+			}
+			std::sort(receivers.begin(), receivers.end());
+			h = d2dHashCombine(h, receivers.size());
+			for (uint32_t r = 0; r<receivers.size(); r++) {
+				h = d2dHashCombine(d2dHashCombine(h, receivers[r].first), receivers[r].second);
+			}
+		}
+		for (uint32_t j = 0; j<numDev; j++) {
+			uint32_t b = devAt[j];
+			h = d2dHashCombine(h, opt->START_Client[d][b]);
+			if (!opt->terminalClient.empty()) {
+				h = d2dHashCombine(h, d2dHashDouble(opt->terminalClient[d * numDev + b]));
+			}
+			for (uint32_t k = 0; k<numChan; k++) {
+				h = d2dHashCombine(h, opt->L[d][b][chanAt[k]]);
+			}
+			for (uint32_t k = 0; k<numCont; k++) {
+				h = d2dHashCombine(h, d2dHashDouble(opt->U[d][b][contAt[k]]));
+			}
+		}
+	}
+	lastKey = h;
+	return h;
+}
+
+void d2dSolutionCache::relabel(const d2dSchedule &src, d2dSchedule &dst, bool toCanonical) const {
+	std::vector<uint32_t> devMap 	= deviceRank;
+	std::vector<uint32_t> chanMap 	= channelRank;
+	std::vector<uint32_t> contMap 	= contentRank;
+	if (!toCanonical) {
+		inverse(deviceRank, devMap);
+		inverse(channelRank, chanMap);
+		inverse(contentRank, contMap);
+	}
+
+	dst.reset(src.numDevices, src.numTimeSlots);
+	for (uint32_t d = 0; d<src.numDevices; d++) {
+		for (int64_t t = 0; t<src.numTimeSlots; t++) {
+			uint8_t r 		= src.getRole(d, t);
+			uint32_t arg 	= src.getRoleArg(d, t);
+			if (r == D2D_ROLE_STARTAP || r == D2D_ROLE_SWITCHAP || r == D2D_ROLE_AP) {
+				arg = chanMap[arg];
+			} else if (r != D2D_ROLE_IDLE) {
+				arg = devMap[arg];
+			}
+			dst.setRole(devMap[d], t, r, arg);
+		}
+	}
+	for (uint32_t i = 0; i<src.exchanges.size(); i++) {
+		const d2dExchange &ex = src.exchanges[i];
+		dst.exchanges.push_back(d2dExchange(devMap[ex.d_prv], devMap[ex.d_cns], contMap[ex.n], chanMap[ex.c], ex.t, ex.duration));
+	}
+	dst.utility = src.utility;
+}
+
+bool d2dSolutionCache::lookup(d2dOptimizer *opt, d2dSchedule &schedule, int32_t &status) {
+	std::unordered_map<uint64_t, std::list<entry>::iterator>::iterator it = index.find(fingerprint(opt));
+	if (it == index.end()) {
+		misses++;
+		return false;
+	}
+	entries.splice(entries.begin(), entries, it->second);
+	relabel(it->second->schedule, schedule, false);
+	status = it->second->status;
+	hits++;
+	return true;
+}
+
+void d2dSolutionCache::insert(const d2dSchedule &schedule, int32_t status) {
+	if (capacity == 0) {
+		return;
+	}
+	std::unordered_map<uint64_t, std::list<entry>::iterator>::iterator it = index.find(lastKey);
+	if (it != index.end()) {
+		entries.splice(entries.begin(), entries, it->second);
+	} else {
+		entries.push_front(entry());
+		entries.front().key = lastKey;
+		index[lastKey] = entries.begin();
+	}
+	relabel(schedule, entries.front().schedule, true);
+	entries.front().status = status;
+
+	if (entries.size() > capacity) {
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+void d2dSolutionCache::clear() {
+	entries.clear();
+	index.clear();
+	hits 	= 0;
+	misses 	= 0;
+}
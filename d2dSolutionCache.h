@@ -0,0 +1,65 @@
+#ifndef D2DSOLUTIONCACHE_H
+#define D2DSOLUTIONCACHE_H
+
+#include <list>
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// LRU cache of schedules keyed by a canonical fingerprint of the instance, so that a superslot
+// presenting the same instance as an earlier one, or the same instance with other device, channel
+// and content ids or order, is answered without building a model.
+// The fingerprint refines colors of devices, channels and content over all parameters (P, I, D, W,
+// S, L, U, interferenceList, START_*, capacity) until the partition is stable (Weisfeiler-Lehman),
+// orders every index set by color and hashes the parameters, terminal values and the model options
+// in that order.
+// Indices with equal color are ordered by index; for symmetric devices this does not change the
+// hash, instances on which the refinement fails to separate non-symmetric devices are a miss.
+// Schedules are stored in canonical indices and relabeled to the instance on a hit.
+class d2dSolutionCache {
+
+	public:
+		// maximum number of schedules
+		uint32_t capacity;
+
+		uint64_t hits;
+		uint64_t misses;
+
+		d2dSolutionCache(uint32_t capacity);
+
+		// canonical fingerprint of the instance and model options of opt, sets the canonical
+		// order used by the following insert()
+		uint64_t fingerprint(d2dOptimizer *opt);
+
+		// schedule and solver status of an equal instance, counts hits and misses
+		bool lookup(d2dOptimizer *opt, d2dSchedule &schedule, int32_t &status);
+		// stores schedule for the instance of the last fingerprint() or lookup(), evicts the least
+		// recently used schedule if the cache is full
+		void insert(const d2dSchedule &schedule, int32_t status);
+
+		void clear();
+		uint32_t size() const {
+			return entries.size();
+		}
+
+	private:
+		struct entry {
+			uint64_t key;
+			d2dSchedule schedule;
+			int32_t status;
+		};
+
+		std::list<entry> entries;
+		std::unordered_map<uint64_t, std::list<entry>::iterator> index;
+
+		// canonical position per device / channel / content index of the last fingerprint()
+		uint64_t lastKey;
+		std::vector<uint32_t> deviceRank;
+		std::vector<uint32_t> channelRank;
+		std::vector<uint32_t> contentRank;
+
+		// schedule with index i replaced by rank[i], or by the inverse with toCanonical = false
+		void relabel(const d2dSchedule &src, d2dSchedule &dst, bool toCanonical) const;
+};
+
+#endif
@@ -0,0 +1,620 @@
+#include "d2dSolverBackend.h"
+#include <iomanip>
+#include <cmath>
+#include <unordered_map>
+#include <cstdlib>
+
+#ifndef D2D_NO_GUROBI
+#include "d2dGurobiBackend.h"
+#endif
+
+// LP names must not contain brackets or operators
+static std::string lpName(const std::string &name) {
+	std::string result = name;
+	for (size_t i = 0; i<result.size(); i++) {
+		switch (result[i]) {
+			case '[':
+				result[i] = '(';
+				break;
+			case ']':
+				result[i] = ')';
+				break;
+			case '-':
+			case '+':
+			case ' ':
+			case ':':
+			case '*':
+			case '^':
+			case '<':
+			case '>':
+			case '=':
+				result[i] = '_';
+				break;
+		}
+	}
+	return result;
+}
+
+d2dConstraintBuffer::d2dConstraintBuffer(bool useNames) {
+	this->useNames = useNames;
+	rowBegin.push_back(0);
+}
+
+void d2dConstraintBuffer::reserve(size_t numRows, size_t numTerms) {
+	coeffs.reserve(numTerms);
+	vars.reserve(numTerms);
+	rowBegin.reserve(numRows + 1);
+	senses.reserve(numRows);
+	rhs.reserve(numRows);
+	if (useNames) {
+		names.reserve(numRows);
+	}
+}
+
+void d2dConstraintBuffer::clear() {
+	//clear() keeps the capacity, the buffer can be refilled without reallocation
+	coeffs.clear();
+	vars.clear();
+	rowBegin.clear();
+	rowBegin.push_back(0);
+	senses.clear();
+	rhs.clear();
+	names.clear();
+}
+
+void d2dConstraintBuffer::flush(d2dSolverBackend *backend) {
+	if (numRows() == 0) {
+		return;
+	}
+	backend->addConstrs(*this);
+	clear();
+}
+
+d2dSolverBackend* createDefaultBackend() {
+#ifndef D2D_NO_GUROBI
+	return new d2dGurobiBackend();
+#else
+	return new d2dFileBackend("d2dModel.mps");
+#endif
+}
+
+d2dFileBackend::d2dFileBackend(const std::string &fname) {
+	this->fname = fname;
+	objSense 	= D2D_MAXIMIZE;
+	solutionObj = 0.0;
+	rowBegin.push_back(0);
+}
+
+std::string d2dFileBackend::name() {
+	return "file";
+}
+
+void d2dFileBackend::clear() {
+	colLb.clear();
+	colUb.clear();
+	colType.clear();
+	colObj.clear();
+	colNames.clear();
+
+	rowBegin.clear();
+	rowBegin.push_back(0);
+	rowVars.clear();
+	rowCoeffs.clear();
+	rowSenses.clear();
+	rowRhs.clear();
+	rowNames.clear();
+
+	solution.clear();
+	solutionObj = 0.0;
+	relaxedTypes.clear();
+}
+
+d2dVar d2dFileBackend::addVars(uint64_t count, double lb, double ub, char type, const std::vector<std::string> *names) {
+	d2dVar first = colLb.size();
+
+	colLb.resize(first + count, lb);
+	colUb.resize(first + count, ub);
+	colType.resize(first + count, relaxedTypes.empty() ? type : D2D_CONTINUOUS);
+	colObj.resize(first + count, 0.0);
+	if (!relaxedTypes.empty()) {
+		relaxedTypes.resize(first + count, type);
+	}
+
+	//names are only stored once the first named variable is added
+	if (names != NULL) {
+		colNames.resize(first);
+		colNames.insert(colNames.end(), names->begin(), names->begin() + count);
+	}
+	return first;
+}
+
+void d2dFileBackend::addConstrs(const d2dConstraintBuffer &buf) {
+	uint64_t firstRow 	= rowSenses.size();
+	size_t termOffset	= rowVars.size();
+
+	rowVars.insert(rowVars.end(), buf.vars.begin(), buf.vars.end());
+	rowCoeffs.insert(rowCoeffs.end(), buf.coeffs.begin(), buf.coeffs.end());
+	for (size_t i = 1; i<buf.rowBegin.size(); i++) {
+		rowBegin.push_back(termOffset + buf.rowBegin[i]);
+	}
+	rowSenses.insert(rowSenses.end(), buf.senses.begin(), buf.senses.end());
+	rowRhs.insert(rowRhs.end(), buf.rhs.begin(), buf.rhs.end());
+
+	if (buf.useNames) {
+		rowNames.resize(firstRow);
+		rowNames.insert(rowNames.end(), buf.names.begin(), buf.names.end());
+	}
+}
+
+void d2dFileBackend::setObjective(const std::vector<d2dVar> &vars, const std::vector<double> &coeffs, int32_t sense) {
+	std::fill(colObj.begin(), colObj.end(), 0.0);
+	for (size_t i = 0; i<vars.size(); i++) {
+		colObj[vars[i]] += coeffs[i];
+	}
+	objSense = sense;
+}
+
+uint64_t d2dFileBackend::numVars() {
+	return colLb.size();
+}
+
+uint64_t d2dFileBackend::numConstrs() {
+	return rowSenses.size();
+}
+
+void d2dFileBackend::setBounds(const std::vector<double> &lb, const std::vector<double> &ub) {
+	std::copy(lb.begin(), lb.begin() + std::min(lb.size(), colLb.size()), colLb.begin());
+	std::copy(ub.begin(), ub.begin() + std::min(ub.size(), colUb.size()), colUb.begin());
+}
+
+void d2dFileBackend::setParam(const std::string &param, const std::string &value) {
+	if (param == "ModelFile") {
+		fname = value;
+	} else if (param == "SolutionFile") {
+		solutionFname = value;
+	} else if (param == "StartFile") {
+		startFname = value;
+	}
+}
+
+int32_t d2dFileBackend::optimize() {
+	write(fname);
+	cout << "Model written to " << fname << endl;
+	if (!startFname.empty() && !start.empty()) {
+		write(startFname);
+		cout << "MIP start written to " << startFname << endl;
+	}
+	
+	solution.clear();
+	solutionObj = 0.0;
+	if (!solutionFname.empty() && std::ifstream(solutionFname.c_str()).good()) {
+		int32_t status = readSolution(solutionFname);
+		if (status != D2D_STATUS_ERROR) {
+			cout << "Solution read from " << solutionFname << endl;
+		}
+		return status;
+	}
+	return D2D_STATUS_EXPORTED;
+}
+
+bool d2dFileBackend::hasSolution() {
+	return !solution.empty();
+}
+
+double d2dFileBackend::getObjValue() {
+	return solutionObj;
+}
+
+void d2dFileBackend::getValues(std::vector<double> &values) {
+	values = solution;
+	values.resize(numVars(), 0.0);
+}
+
+bool d2dFileBackend::setRelaxed(bool relaxed) {
+	if (relaxed && relaxedTypes.empty() && !colType.empty()) {
+		relaxedTypes = colType;
+		colType.assign(colType.size(), D2D_CONTINUOUS);
+	} else if (!relaxed && !relaxedTypes.empty()) {
+		colType = relaxedTypes;
+		relaxedTypes.clear();
+	}
+	return true;
+}
+
+void d2dFileBackend::setStart(const std::vector<double> &values) {
+	start = values;
+	start.resize(numVars(), 0.0);
+}
+
+std::string d2dFileBackend::colName(d2dVar var) {
+	if (var < (d2dVar)colNames.size() && !colNames[var].empty()) {
+		return colNames[var];
+	}
+	std::stringstream sstm;
+	sstm << "C" << var;
+	return sstm.str();
+}
+
+std::string d2dFileBackend::rowName(uint64_t row) {
+	if (row < rowNames.size() && !rowNames[row].empty()) {
+		return rowNames[row];
+	}
+	std::stringstream sstm;
+	sstm << "R" << row;
+	return sstm.str();
+}
+
+void d2dFileBackend::write(const std::string &fname) {
+	std::ofstream out(fname.c_str());
+	if (!out.is_open()) {
+		throw std::runtime_error("Cannot open " + fname);
+	}
+	out << std::setprecision(17);
+
+	if (fname.size() >= 3 && fname.compare(fname.size() - 3, 3, ".lp") == 0) {
+		writeLp(out);
+	} else if (fname.size() >= 4 && fname.compare(fname.size() - 4, 4, ".mst") == 0) {
+		writeMst(out);
+	} else {
+		writeMps(out);
+	}
+}
+
+void d2dFileBackend::writeMst(std::ostream &out) {
+	//the names have to match the ones of the written model
+	bool lpNames = this->fname.size() >= 3 && this->fname.compare(this->fname.size() - 3, 3, ".lp") == 0;
+	out << "# MIP start" << endl;
+	for (uint64_t c = 0; c<start.size(); c++) {
+		out << (lpNames ? lpName(colName(c)) : colName(c)) << " " << start[c] << "\n";
+	}
+}
+
+void d2dFileBackend::writeMps(std::ostream &out) {
+
+	// column-wise copy of the constraint matrix
+	std::vector<size_t> colBegin(numVars() + 1, 0);
+	for (size_t k = 0; k<rowVars.size(); k++) {
+		colBegin[rowVars[k] + 1]++;
+	}
+	for (size_t c = 0; c<numVars(); c++) {
+		colBegin[c + 1] += colBegin[c];
+	}
+	std::vector<uint64_t> colRows(rowVars.size());
+	std::vector<double> colCoeffs(rowVars.size());
+	std::vector<size_t> colEnd(colBegin.begin(), colBegin.end() - 1);
+	for (uint64_t row = 0; row<numConstrs(); row++) {
+		for (size_t k = rowBegin[row]; k<rowBegin[row + 1]; k++) {
+			d2dVar c = rowVars[k];
+			//a row may contain the same variable more than once, MPS requires a single entry
+			if (colEnd[c] > colBegin[c] && colRows[colEnd[c] - 1] == row) {
+				colCoeffs[colEnd[c] - 1] += rowCoeffs[k];
+				continue;
+			}
+			colRows[colEnd[c]]		= row;
+			colCoeffs[colEnd[c]]	= rowCoeffs[k];
+			colEnd[c]++;
+		}
+	}
+
+	//FREE marks free MPS for readers that would otherwise guess the format
+	//OBJSENSE is not read by all solvers (e.g. CBC), a maximization is written as minimization of the
+	//negated objective; solutionObj is computed from colObj, so the objective value keeps its sign
+	double objFactor = objSense == D2D_MAXIMIZE ? -1.0 : 1.0;
+	out << "NAME d2dModel FREE" << endl;
+	if (objSense == D2D_MAXIMIZE) {
+		out << "* maximization written as minimization of the negated objective" << endl;
+	}
+
+	out << "ROWS" << endl;
+	out << " N d2dObj" << endl;
+	for (uint64_t row = 0; row<numConstrs(); row++) {
+		char type = rowSenses[row] == D2D_LESS_EQUAL ? 'L' : (rowSenses[row] == D2D_GREATER_EQUAL ? 'G' : 'E');
+		out << " " << type << " " << rowName(row) << "\n";
+	}
+
+	out << "COLUMNS" << endl;
+	bool intSection = false;
+	for (uint64_t c = 0; c<numVars(); c++) {
+		bool isInt = colType[c] != D2D_CONTINUOUS;
+		if (isInt != intSection) {
+			out << " MARKER 'MARKER' " << (isInt ? "'INTORG'" : "'INTEND'") << "\n";
+			intSection = isInt;
+		}
+		std::string name = colName(c);
+		//every column is listed, even if it does not appear in the objective or any row
+		if (colObj[c] != 0.0 || colBegin[c] == colEnd[c]) {
+			//no negative zero for columns without objective coefficient
+			out << " " << name << " d2dObj " << (colObj[c] != 0.0 ? objFactor * colObj[c] : 0.0) << "\n";
+		}
+		for (size_t k = colBegin[c]; k<colEnd[c]; k++) {
+			out << " " << name << " " << rowName(colRows[k]) << " " << colCoeffs[k] << "\n";
+		}
+	}
+	if (intSection) {
+		out << " MARKER 'MARKER' 'INTEND'" << "\n";
+	}
+
+	out << "RHS" << endl;
+	for (uint64_t row = 0; row<numConstrs(); row++) {
+		if (rowRhs[row] != 0.0) {
+			out << " RHS " << rowName(row) << " " << rowRhs[row] << "\n";
+		}
+	}
+
+	out << "BOUNDS" << endl;
+	for (uint64_t c = 0; c<numVars(); c++) {
+		std::string name = colName(c);
+		bool lbInf = colLb[c] <= -D2D_INFINITY;
+		bool ubInf = colUb[c] >= D2D_INFINITY;
+		if (colType[c] == D2D_BINARY && colLb[c] == 0.0 && colUb[c] == 1.0) {
+			//integer column with bounds [0,1], BV entries are not understood by all readers
+			out << " UP BND " << name << " 1\n";
+		} else if (!lbInf && colLb[c] == colUb[c]) {
+			out << " FX BND " << name << " " << colLb[c] << "\n";
+		} else if (lbInf && ubInf) {
+			out << " FR BND " << name << "\n";
+		} else {
+			if (lbInf) {
+				out << " MI BND " << name << "\n";
+			} else if (colLb[c] != 0.0) {
+				out << " LO BND " << name << " " << colLb[c] << "\n";
+			}
+			if (!ubInf) {
+				out << " UP BND " << name << " " << colUb[c] << "\n";
+			} else if (colType[c] != D2D_CONTINUOUS) {
+				//some readers default integer columns to an upper bound of 1
+				out << " PL BND " << name << "\n";
+			}
+		}
+	}
+	out << "ENDATA" << endl;
+}
+
+static void writeLpTerm(std::ostream &out, double coeff, const std::string &name, size_t termIndex) {
+	if (termIndex > 0 && termIndex % 8 == 0) {
+		out << "\n  ";
+	}
+	out << (coeff < 0 ? " - " : " + ") << std::fabs(coeff) << " " << name;
+}
+
+void d2dFileBackend::writeLp(std::ostream &out) {
+	out << "\\ d2dModel" << endl;
+	out << (objSense == D2D_MAXIMIZE ? "Maximize" : "Minimize") << endl;
+	out << " obj:";
+	size_t numTerms = 0;
+	for (uint64_t c = 0; c<numVars(); c++) {
+		if (colObj[c] != 0.0) {
+			writeLpTerm(out, colObj[c], lpName(colName(c)), numTerms++);
+		}
+	}
+	if (numTerms == 0 && numVars() > 0) {
+		out << " 0 " << lpName(colName(0));
+	}
+	out << endl;
+
+	out << "Subject To" << endl;
+	//a row may contain the same variable more than once, the terms are merged
+	std::vector<double> rowCoeff(numVars(), 0.0);
+	std::vector<char> inRow(numVars(), 0);
+	std::vector<d2dVar> rowCols;
+	for (uint64_t row = 0; row<numConstrs(); row++) {
+		out << " " << lpName(rowName(row)) << ":";
+		rowCols.clear();
+		for (size_t k = rowBegin[row]; k<rowBegin[row + 1]; k++) {
+			if (!inRow[rowVars[k]]) {
+				inRow[rowVars[k]] = 1;
+				rowCols.push_back(rowVars[k]);
+			}
+			rowCoeff[rowVars[k]] += rowCoeffs[k];
+		}
+		numTerms = 0;
+		for (size_t k = 0; k<rowCols.size(); k++) {
+			if (rowCoeff[rowCols[k]] != 0.0) {
+				writeLpTerm(out, rowCoeff[rowCols[k]], lpName(colName(rowCols[k])), numTerms++);
+			}
+			rowCoeff[rowCols[k]] = 0.0;
+			inRow[rowCols[k]] = 0;
+		}
+		if (numTerms == 0 && numVars() > 0) {
+			out << " 0 " << lpName(colName(0));
+		}
+		const char *sense = rowSenses[row] == D2D_LESS_EQUAL ? "<=" : (rowSenses[row] == D2D_GREATER_EQUAL ? ">=" : "=");
+		out << " " << sense << " " << rowRhs[row] << "\n";
+	}
+
+	out << "Bounds" << endl;
+	for (uint64_t c = 0; c<numVars(); c++) {
+		if (colType[c] == D2D_BINARY) {
+			continue;
+		}
+		bool lbInf = colLb[c] <= -D2D_INFINITY;
+		bool ubInf = colUb[c] >= D2D_INFINITY;
+		std::string name = lpName(colName(c));
+		if (lbInf && ubInf) {
+			out << " " << name << " free\n";
+		} else if (!lbInf && colLb[c] == colUb[c]) {
+			out << " " << name << " = " << colLb[c] << "\n";
+		} else if (lbInf || colLb[c] != 0.0 || !ubInf) {
+			out << " ";
+			if (lbInf) {
+				out << "-inf";
+			} else {
+				out << colLb[c];
+			}
+			out << " <= " << name << " <= ";
+			if (ubInf) {
+				out << "+inf";
+			} else {
+				out << colUb[c];
+			}
+			out << "\n";
+		}
+	}
+
+	const char types[2] = { D2D_BINARY, D2D_INTEGER };
+	const char *sections[2] = { "Binaries", "Generals" };
+	for (int i = 0; i<2; i++) {
+		out << sections[i] << endl;
+		numTerms = 0;
+		for (uint64_t c = 0; c<numVars(); c++) {
+			if (colType[c] == types[i]) {
+				out << " " << lpName(colName(c));
+				if (++numTerms % 8 == 0) {
+					out << "\n";
+				}
+			}
+		}
+		if (numTerms % 8 != 0) {
+			out << "\n";
+		}
+	}
+	out << "End" << endl;
+}
+
+// status of a CBC solution file from its first line, e.g. "Optimal - objective value 2" or
+// "Stopped on time (no integer solution - continuous used) - objective value 1.5"
+static int32_t cbcStatus(const std::string &line) {
+	if (line.find("no integer solution") != std::string::npos) {
+		return D2D_STATUS_NO_SOLUTION;
+	}
+	if (line.compare(0, 7, "Optimal") == 0) {
+		return D2D_STATUS_OPTIMAL;
+	}
+	if (line.find("nfeasible") != std::string::npos) {
+		return D2D_STATUS_INFEASIBLE;
+	}
+	if (line.compare(0, 7, "Stopped") == 0) {
+		return D2D_STATUS_FEASIBLE;
+	}
+	return D2D_STATUS_UNKNOWN;
+}
+
+// objective value at the end of a header line, e.g. "# Objective value = 2" (Gurobi)
+// or "Optimal - objective value 2" (CBC)
+static bool objectiveFromLine(const std::string &line, double &obj) {
+	size_t pos = line.find_last_of(" =");
+	if (pos == std::string::npos || pos + 1 >= line.size()) {
+		return false;
+	}
+	char *end = NULL;
+	obj = strtod(line.c_str() + pos + 1, &end);
+	return end != NULL && *end == '\0';
+}
+
+int32_t d2dFileBackend::readSolution(const std::string &fname) {
+	solution.clear();
+	solutionObj = 0.0;
+	std::ifstream infile(fname.c_str());
+	if (!infile.is_open()) {
+		cerr << "Cannot open " << fname << endl;
+		return D2D_STATUS_ERROR;
+	}
+
+	std::unordered_map<std::string, d2dVar> colIndex;
+	colIndex.reserve(numVars());
+	for (uint64_t c = 0; c<numVars(); c++) {
+		colIndex[colName(c)] = c;
+		colIndex[lpName(colName(c))] = c;
+	}
+	//CBC numbers the columns in the order of the file, which is the model order only for MPS
+	bool lpModel = this->fname.size() >= 3 && this->fname.compare(this->fname.size() - 3, 3, ".lp") == 0;
+
+	//Gurobi only writes a solution file if it has found a solution, without proof of optimality
+	int32_t status = D2D_STATUS_FEASIBLE;
+	bool firstLine = true;
+	bool allColumns = true;
+	//objective value stated in the file, in the sense of the written model
+	bool hasFileObj = false;
+	double fileObj = 0.0;
+	uint64_t numValues = 0;
+	std::vector<bool> read(numVars(), false);
+	std::vector<double> values(numVars(), 0.0);
+	std::string line;
+	while (std::getline(infile, line)) {
+		if (line.empty() || line.substr(0,1) == "#") {
+			//Gurobi header "# Objective value = 2"
+			if (line.find("Objective value") != std::string::npos) {
+				hasFileObj = objectiveFromLine(line, fileObj);
+			}
+			firstLine = false;
+			continue;
+		}
+		// "name value" (Gurobi) or "index name value reducedCost" (CBC, infeasible entries marked with **)
+		std::vector<std::string> tokens;
+		std::stringstream sstm(line);
+		std::string token;
+		while (sstm >> token) {
+			if (token != "**") {
+				tokens.push_back(token);
+			}
+		}
+		uint32_t nameToken = (tokens.size() >= 3 && tokens.at(0).find_first_not_of("0123456789") == std::string::npos) ? 1 : 0;
+		char *end = NULL;
+		double value = tokens.size() >= nameToken + 2 ? strtod(tokens.at(nameToken + 1).c_str(), &end) : 0.0;
+		if (end == NULL || *end != '\0') {
+			//CBC status line, e.g. "Optimal - objective value 2"
+			if (firstLine) {
+				status = cbcStatus(line);
+				hasFileObj = objectiveFromLine(line, fileObj);
+				firstLine = false;
+				if (status != D2D_STATUS_OPTIMAL && status != D2D_STATUS_FEASIBLE) {
+					return status;
+				}
+			}
+			continue;
+		}
+		firstLine = false;
+
+		//a solution of another model (e.g. a stale file of an earlier run) is rejected
+		std::unordered_map<std::string, d2dVar>::iterator it = colIndex.find(tokens.at(nameToken));
+		if (it == colIndex.end()) {
+			cerr << "unknown variable " << tokens.at(nameToken) << " in file " << fname << ", the solution does not belong to the model" << endl;
+			return D2D_STATUS_ERROR;
+		}
+		if (nameToken == 1 && !lpModel && strtoull(tokens.at(0).c_str(), NULL, 10) != (uint64_t) it->second) {
+			cerr << "variable " << tokens.at(nameToken) << " at column " << tokens.at(0) << " in file " << fname << ", the solution does not belong to the model" << endl;
+			return D2D_STATUS_ERROR;
+		}
+		if (read[it->second]) {
+			cerr << "variable " << tokens.at(nameToken) << " listed twice in file " << fname << endl;
+			return D2D_STATUS_ERROR;
+		}
+		read[it->second] 	= true;
+		values[it->second] 	= value;
+		numValues++;
+		//CBC lists only the non-zero columns
+		allColumns = allColumns && nameToken == 0;
+	}
+	//Gurobi lists all columns
+	if (allColumns && numValues != numVars()) {
+		cerr << numValues << " of " << numVars() << " variables in file " << fname << ", the solution does not belong to the model" << endl;
+		return D2D_STATUS_ERROR;
+	}
+
+	double obj = 0.0;
+	for (uint64_t c = 0; c<numVars(); c++) {
+		obj += colObj[c] * values[c];
+	}
+	//the MPS file holds a maximization as minimization of the negated objective
+	double writtenObj = (!lpModel && objSense == D2D_MAXIMIZE) ? -obj : obj;
+	if (hasFileObj && std::fabs(writtenObj - fileObj) > 1e-4 * std::max(1.0, std::fabs(fileObj))) {
+		cerr << "objective value " << fileObj << " in file " << fname << " differs from " << writtenObj << ", the solution does not belong to the model" << endl;
+		return D2D_STATUS_ERROR;
+	}
+	for (uint64_t row = 0; row<numConstrs(); row++) {
+		double activity = 0.0;
+		for (size_t k = rowBegin[row]; k<rowBegin[row + 1]; k++) {
+			activity += rowCoeffs[k] * values[rowVars[k]];
+		}
+		double tol = 1e-5 * std::max(1.0, std::fabs(rowRhs[row]));
+		if ((rowSenses[row] != D2D_GREATER_EQUAL && activity > rowRhs[row] + tol)
+			|| (rowSenses[row] != D2D_LESS_EQUAL && activity < rowRhs[row] - tol)) {
+			cerr << "constraint " << rowName(row) << " violated by the solution in file " << fname << ", the solution does not belong to the model" << endl;
+			return D2D_STATUS_ERROR;
+		}
+	}
+
+	solution.swap(values);
+	solutionObj = obj;
+	return status;
+}
@@ -0,0 +1,293 @@
+#ifndef D2DSOLVERBACKEND_H
+#define D2DSOLVERBACKEND_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <functional>
+#include <stdint.h>
+
+// number of buffered constraint terms after which rows are handed to the solver
+#define D2D_CONSTR_FLUSH_TERMS (1 << 22)
+
+#define D2D_LESS_EQUAL 		'<'
+#define D2D_GREATER_EQUAL 	'>'
+#define D2D_EQUAL 			'='
+
+#define D2D_CONTINUOUS 	'C'
+#define D2D_BINARY 		'B'
+#define D2D_INTEGER 	'I'
+
+#define D2D_MAXIMIZE	-1
+#define D2D_MINIMIZE	1
+
+#define D2D_INFINITY 1e100
+
+// result of d2dSolverBackend::optimize()
+#define D2D_STATUS_ERROR 		-1
+#define D2D_STATUS_UNKNOWN 		0
+#define D2D_STATUS_OPTIMAL 		1
+#define D2D_STATUS_INFEASIBLE 	2
+// stopped early (e.g. time limit) with a feasible solution
+#define D2D_STATUS_FEASIBLE 	3
+// stopped early without a feasible solution
+#define D2D_STATUS_NO_SOLUTION 	4
+// the model has been written to a file, but not solved
+#define D2D_STATUS_EXPORTED 	5
+
+using namespace std;
+
+// index of a variable (column) in the backend model
+typedef int64_t d2dVar;
+
+// A family of variables stored as one contiguous block of columns.
+// The time slot is the last (contiguous) dimension.
+struct d2dVarBlock {
+	d2dVar base;
+	uint32_t numDims;
+	uint64_t dims[5];
+
+	d2dVarBlock() {
+		this->base 		= -1;
+		this->numDims 	= 0;
+	}
+
+	d2dVarBlock(d2dVar base, const std::vector<uint64_t> &dims) {
+		this->base 		= base;
+		this->numDims 	= dims.size();
+		for (uint32_t i = 0; i<numDims && i<5; i++) {
+			this->dims[i] = dims[i];
+		}
+	}
+
+	uint64_t size() const {
+		uint64_t count = numDims > 0 ? 1 : 0;
+		for (uint32_t i = 0; i<numDims; i++) {
+			count *= dims[i];
+		}
+		return count;
+	}
+
+	d2dVar operator()(uint64_t i, uint64_t t) const {
+		return base + i * dims[1] + t;
+	}
+
+	d2dVar operator()(uint64_t i, uint64_t j, uint64_t t) const {
+		return base + (i * dims[1] + j) * dims[2] + t;
+	}
+
+	d2dVar operator()(uint64_t i, uint64_t j, uint64_t k, uint64_t l, uint64_t t) const {
+		return base + (((i * dims[1] + j) * dims[2] + k) * dims[3] + l) * dims[4] + t;
+	}
+};
+
+// Row buffer for adding constraints in bulk. The terms of all rows are stored back to back,
+// row i uses the terms [rowBegin[i], rowBegin[i+1]). Names are only stored if enabled.
+class d2dSolverBackend;
+class d2dConstraintBuffer {
+
+	public:
+		std::vector<double> coeffs;
+		std::vector<d2dVar> vars;
+		std::vector<size_t> rowBegin;
+		std::vector<char> senses;
+		std::vector<double> rhs;
+		std::vector<std::string> names;
+
+		bool useNames;
+
+		d2dConstraintBuffer(bool useNames);
+
+		void reserve(size_t numRows, size_t numTerms);
+		void clear();
+
+		size_t numRows() const {
+			return senses.size();
+		}
+
+		size_t numTerms() const {
+			return coeffs.size();
+		}
+
+		void addTerm(d2dVar var, double coeff) {
+			vars.push_back(var);
+			coeffs.push_back(coeff);
+		}
+
+		void endRow(char sense, double rhsValue) {
+			rowBegin.push_back(coeffs.size());
+			senses.push_back(sense);
+			rhs.push_back(rhsValue);
+			if (useNames) {
+				names.push_back("");
+			}
+		}
+
+		//only call if useNames is set
+		void nameRow(const std::string &name) {
+			names.back() = name;
+		}
+
+		//hands all buffered rows to the backend in one call
+		void flush(d2dSolverBackend *backend);
+
+		//flush only if the buffer holds more than D2D_CONSTR_FLUSH_TERMS terms
+		void flushIfFull(d2dSolverBackend *backend) {
+			if (coeffs.size() >= D2D_CONSTR_FLUSH_TERMS) {
+				flush(backend);
+			}
+		}
+};
+
+// called by a backend with the values and objective of every new incumbent found during optimize()
+typedef std::function<void(const std::vector<double>&, double)> d2dIncumbentFound;
+// returns true and fills values with an external solution the backend should try as incumbent
+typedef std::function<bool(std::vector<double>&)> d2dIncumbentPoll;
+
+// Solver-neutral interface used by d2dOptimizer to build and solve the model.
+// Errors are reported as std::runtime_error.
+class d2dSolverBackend {
+
+	public:
+		virtual ~d2dSolverBackend() {}
+
+		virtual std::string name() = 0;
+
+		//discards all variables and constraints
+		virtual void clear() = 0;
+
+		//adds count variables with the same bounds and type, returns the index of the first one
+		//names may be NULL
+		virtual d2dVar addVars(uint64_t count, double lb, double ub, char type, const std::vector<std::string> *names) = 0;
+		virtual void addConstrs(const d2dConstraintBuffer &buf) = 0;
+		virtual void setObjective(const std::vector<d2dVar> &vars, const std::vector<double> &coeffs, int32_t sense) = 0;
+
+		virtual uint64_t numVars() = 0;
+		virtual uint64_t numConstrs() = 0;
+
+		//generic parameter, e.g. "TimeLimit" "60"; unknown parameters are ignored
+		virtual void setParam(const std::string &param, const std::string &value) = 0;
+
+		virtual int32_t optimize() = 0;
+
+		virtual bool hasSolution() = 0;
+		virtual double getObjValue() = 0;
+		//values of all variables, indexed by d2dVar
+		virtual void getValues(std::vector<double> &values) = 0;
+
+		//replaces the bounds of all variables, indexed by d2dVar
+		virtual void setBounds(const std::vector<double> &lb, const std::vector<double> &ub) = 0;
+
+		//treats all integer variables as continuous in the following optimize() calls (continuous
+		//relaxation) until called with false, returns false if not supported
+		virtual bool setRelaxed(bool /*relaxed*/) {
+			return false;
+		}
+
+		//start solution for the next optimize(), indexed by d2dVar, ignored if not supported
+		virtual void setStart(const std::vector<double> &/*values*/) {
+		}
+
+		//independent copy of the built model with its own solver state, so that copies can be solved
+		//concurrently in different threads; NULL if not supported
+		virtual d2dSolverBackend* clone() {
+			return NULL;
+		}
+
+		//stops a running optimize() from another thread, which returns with its best solution
+		virtual void interrupt() {
+		}
+
+		//incumbent exchange with other solvers during optimize(), called from the solving thread;
+		//empty functions remove the callbacks, ignored if not supported
+		virtual void setIncumbentCallbacks(const d2dIncumbentFound &/*found*/, const d2dIncumbentPoll &/*poll*/) {
+		}
+
+		//names of the constraints of an irreducible inconsistent subsystem, false if not supported
+		virtual bool computeIIS(std::vector<std::string> &/*constrNames*/) {
+			return false;
+		}
+
+		//writes the model, the format is derived from the file extension (.lp, .mps or .mst for the start solution)
+		virtual void write(const std::string &fname) = 0;
+};
+
+// Backend without solver dependency. The model is kept in memory and written as
+// (free) MPS or CPLEX LP file by optimize() and write(), so it can be solved offline
+// with any solver. A solution written by that solver can be loaded with readSolution().
+// Supported are Gurobi and CBC: the MPS file holds a maximization as minimization of the
+// negated objective without OBJSENSE section, solutions are read in their .sol formats.
+class d2dFileBackend : public d2dSolverBackend {
+
+	public:
+		// file written by optimize(), the format is derived from the extension ("ModelFile")
+		std::string fname;
+		// solution loaded by optimize() after writing the model, if it exists ("SolutionFile")
+		std::string solutionFname;
+		// MIP start written by optimize() in Gurobi MST format, if set ("StartFile")
+		std::string startFname;
+
+		std::vector<double> colLb;
+		std::vector<double> colUb;
+		std::vector<char> colType;
+		std::vector<double> colObj;
+		std::vector<std::string> colNames;
+
+		std::vector<size_t> rowBegin;
+		std::vector<d2dVar> rowVars;
+		std::vector<double> rowCoeffs;
+		std::vector<char> rowSenses;
+		std::vector<double> rowRhs;
+		std::vector<std::string> rowNames;
+
+		int32_t objSense;
+
+		std::vector<double> solution;
+		double solutionObj;
+		std::vector<double> start;
+
+		// types of the variables while relaxed, colType is continuous then; empty if not relaxed
+		std::vector<char> relaxedTypes;
+
+		d2dFileBackend(const std::string &fname);
+
+		std::string name();
+		void clear();
+		d2dVar addVars(uint64_t count, double lb, double ub, char type, const std::vector<std::string> *names);
+		void addConstrs(const d2dConstraintBuffer &buf);
+		void setObjective(const std::vector<d2dVar> &vars, const std::vector<double> &coeffs, int32_t sense);
+		uint64_t numVars();
+		uint64_t numConstrs();
+		void setBounds(const std::vector<double> &lb, const std::vector<double> &ub);
+		void setParam(const std::string &param, const std::string &value);
+		int32_t optimize();
+		bool hasSolution();
+		double getObjValue();
+		void getValues(std::vector<double> &values);
+		bool setRelaxed(bool relaxed);
+		void setStart(const std::vector<double> &values);
+		void write(const std::string &fname);
+
+		void writeMst(std::ostream &out);
+		void writeMps(std::ostream &out);
+		void writeLp(std::ostream &out);
+
+		// reads a solution file with "name value" lines (Gurobi .sol format, '#' starts a comment)
+		// or "index name value reducedCost" lines after a status line (CBC), returns the status of the
+		// solver run; D2D_STATUS_ERROR if the file does not match the model (unknown columns, other
+		// objective value or violated rows), e.g. a stale file of an earlier run
+		int32_t readSolution(const std::string &fname);
+
+		std::string colName(d2dVar var);
+		std::string rowName(uint64_t row);
+};
+
+// Creates the default backend: Gurobi, unless built with D2D_NO_GUROBI, then a
+// d2dFileBackend writing d2dModel.mps.
+d2dSolverBackend* createDefaultBackend();
+
+#endif
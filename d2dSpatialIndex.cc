@@ -0,0 +1,61 @@
+#include "d2dSpatialIndex.h"
+
+d2dSpatialIndex::d2dSpatialIndex() {
+	cellSize 	= 1.0;
+	minX 		= 0.0;
+	minY 		= 0.0;
+	gridWidth 	= 0;
+	gridHeight 	= 0;
+}
+
+void d2dSpatialIndex::build(const std::vector<double> &x, const std::vector<double> &y, double cellSize) {
+	this->x 		= x;
+	this->y 		= y;
+	this->cellSize 	= std::max(cellSize, 1.0);
+	uint32_t numPoints = x.size();
+
+	minX = 0.0;
+	minY = 0.0;
+	double maxX = 0.0;
+	double maxY = 0.0;
+	if (numPoints > 0) {
+		minX = *std::min_element(x.begin(), x.end());
+		minY = *std::min_element(y.begin(), y.end());
+		maxX = *std::max_element(x.begin(), x.end());
+		maxY = *std::max_element(y.begin(), y.end());
+	}
+	gridWidth 	= (uint32_t)((maxX - minX) / this->cellSize) + 1;
+	gridHeight 	= (uint32_t)((maxY - minY) / this->cellSize) + 1;
+
+	//counting sort of the points by cell
+	cellStart.assign((uint64_t)gridWidth * gridHeight + 1, 0);
+	for (uint32_t i = 0; i<numPoints; i++) {
+		cellStart[cellOf(x[i], y[i]) + 1]++;
+	}
+	for (uint64_t i = 1; i<cellStart.size(); i++) {
+		cellStart[i] += cellStart[i-1];
+	}
+	cellPoints.resize(numPoints);
+	std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+	for (uint32_t i = 0; i<numPoints; i++) {
+		cellPoints[fill[cellOf(x[i], y[i])]++] = i;
+	}
+}
+
+void d2dSpatialIndex::neighbors(uint32_t i, double range, std::vector<uint32_t> &result) const {
+	result.clear();
+	int64_t cx = (int64_t)((x[i] - minX) / cellSize);
+	int64_t cy = (int64_t)((y[i] - minY) / cellSize);
+	for (int64_t gy = std::max<int64_t>(cy - 1, 0); gy <= std::min<int64_t>(cy + 1, gridHeight - 1); gy++) {
+		for (int64_t gx = std::max<int64_t>(cx - 1, 0); gx <= std::min<int64_t>(cx + 1, gridWidth - 1); gx++) {
+			uint64_t cell = gy * gridWidth + gx;
+			for (uint32_t k = cellStart[cell]; k<cellStart[cell + 1]; k++) {
+				uint32_t other = cellPoints[k];
+				if (other != i && distance(i, other) <= range) {
+					result.push_back(other);
+				}
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+}
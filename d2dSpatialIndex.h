@@ -0,0 +1,107 @@
+#ifndef D2DSPATIALINDEX_H
+#define D2DSPATIALINDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+
+// link speed up to a distance in meters
+struct d2dRate {
+	double distance;
+	long speed;
+
+	d2dRate(double distance, long speed) {
+		this->distance 	= distance;
+		this->speed 	= speed;
+	}
+};
+
+// Distance based link speed and interference. A transmitter interferes with receivers on the same
+// channel within interferenceRange and on the neighboring channel indices within adjacentChannelRange.
+struct d2dRadioModel {
+	// sorted by distance, links longer than the last distance have no connectivity
+	std::vector<d2dRate> rateTable;
+	double interferenceRange;
+	double adjacentChannelRange;
+
+	d2dRadioModel() {
+		//802.11 like rates, content size units per second
+		rateTable.push_back(d2dRate(10.0, 4));
+		rateTable.push_back(d2dRate(25.0, 2));
+		rateTable.push_back(d2dRate(50.0, 1));
+		interferenceRange 		= 80.0;
+		adjacentChannelRange 	= 10.0;
+	}
+
+	// 0 if the distance exceeds the rate table
+	long linkSpeed(double distance) const {
+		for (uint32_t i = 0; i<rateTable.size(); i++) {
+			if (distance <= rateTable[i].distance) {
+				return rateTable[i].speed;
+			}
+		}
+		return 0;
+	}
+
+	bool interferes(uint32_t c_tx, uint32_t c_rx, double distance) const {
+		if (c_tx == c_rx) {
+			return distance <= interferenceRange;
+		}
+		return (c_tx + 1 == c_rx || c_rx + 1 == c_tx) && distance <= adjacentChannelRange;
+	}
+
+	// largest distance with connectivity or interference
+	double range() const {
+		double linkRange = rateTable.empty() ? 0.0 : rateTable.back().distance;
+		return std::max(std::max(linkRange, interferenceRange), adjacentChannelRange);
+	}
+
+	void sortRates() {
+		std::sort(rateTable.begin(), rateTable.end(), [](const d2dRate &a, const d2dRate &b) {
+			return a.distance < b.distance;
+		});
+	}
+};
+
+// Uniform grid over points in the plane for fixed radius neighbor queries. With a cell size of at
+// least the query range only the 3x3 cells around a point have to be searched, so all neighbor
+// lists together are found in time linear in the number of points times the number of neighbors.
+class d2dSpatialIndex {
+
+	public:
+		d2dSpatialIndex();
+
+		// indexes the points (x[i], y[i]), queries must not exceed cellSize
+		void build(const std::vector<double> &x, const std::vector<double> &y, double cellSize);
+
+		// points other than i within range in increasing index order
+		void neighbors(uint32_t i, double range, std::vector<uint32_t> &result) const;
+
+		double distance(uint32_t a, uint32_t b) const {
+			return sqrt((x[a] - x[b]) * (x[a] - x[b]) + (y[a] - y[b]) * (y[a] - y[b]));
+		}
+
+		uint32_t size() const {
+			return x.size();
+		}
+
+	private:
+		std::vector<double> x;
+		std::vector<double> y;
+
+		double cellSize;
+		double minX;
+		double minY;
+		uint32_t gridWidth;
+		uint32_t gridHeight;
+		// points of cell i are cellPoints[cellStart[i], cellStart[i+1])
+		std::vector<uint32_t> cellStart;
+		std::vector<uint32_t> cellPoints;
+
+		uint64_t cellOf(double px, double py) const {
+			return (uint64_t)((py - minY) / cellSize) * gridWidth + (uint64_t)((px - minX) / cellSize);
+		}
+};
+
+#endif
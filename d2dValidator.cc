@@ -0,0 +1,490 @@
+#include "d2dValidator.h"
+
+d2dValidator::d2dValidator(d2dOptimizer *opt) {
+	this->opt 		= opt;
+	numViolations 	= 0;
+	utility 		= 0.0;
+}
+
+void d2dValidator::violation(int64_t t, const std::string &message) {
+	numViolations++;
+	if (messages.size() < D2D_VALIDATOR_MAX_MESSAGES) {
+		std::stringstream sstm;
+		sstm << "t " << t << ": " << message;
+		messages.push_back(sstm.str());
+	}
+}
+
+bool d2dValidator::validRole(const d2dSchedule &schedule, uint32_t d, int64_t t) {
+	uint8_t role = schedule.getRole(d, t);
+	uint32_t arg = schedule.getRoleArg(d, t);
+	switch (role) {
+		case D2D_ROLE_IDLE:
+			return true;
+		case D2D_ROLE_STARTAP:
+		case D2D_ROLE_SWITCHAP:
+		case D2D_ROLE_AP:
+			if (arg < numChan) {
+				return true;
+			}
+			break;
+		case D2D_ROLE_STARTCLIENT:
+		case D2D_ROLE_JOINAP:
+		case D2D_ROLE_CLIENT:
+			//C39 - C41
+			if (arg < numDev && arg != d) {
+				return true;
+			}
+			break;
+	}
+	std::stringstream sstm;
+	sstm << "device " << d << " has invalid role " << d2dSchedule::roleName(role) << " " << arg;
+	violation(t, sstm.str());
+	return false;
+}
+
+bool d2dValidator::hasStartState(uint32_t d) {
+	if (opt->START_Idle[d] == 1) {
+		return true;
+	}
+	for (uint32_t c = 0; c<numChan; c++) {
+		if (opt->START_AP[d][c] == 1) {
+			return true;
+		}
+	}
+	for (uint32_t d_ap = 0; d_ap<numDev; d_ap++) {
+		if (opt->START_Client[d][d_ap] == 1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void d2dValidator::checkTransition(const d2dSchedule &schedule, uint32_t d, int64_t t) {
+	uint8_t role = schedule.getRole(d, t);
+	uint32_t arg = schedule.getRoleArg(d, t);
+	int32_t kappaAP 	= opt->settings.kappa_startAP;
+	int32_t kappaClient = opt->settings.kappa_startClient;
+
+	bool ok = true;
+	if (t == 0) {
+		//initial states C18, C20, C23, C26, C28, C31, C34
+		switch (role) {
+			case D2D_ROLE_IDLE:
+				ok = opt->START_Idle[d] == 1;
+				break;
+			case D2D_ROLE_STARTAP:
+				ok = hasStartState(d) && t < numT - kappaAP - 1;
+				break;
+			case D2D_ROLE_STARTCLIENT:
+				ok = hasStartState(d) && t < numT - kappaClient - 1;
+				break;
+			case D2D_ROLE_AP:
+				ok = opt->START_AP[d][arg] == 1;
+				break;
+			case D2D_ROLE_CLIENT:
+				ok = opt->START_Client[d][arg] == 1;
+				break;
+			default:
+				ok = false;
+		}
+		if (!ok) {
+			std::stringstream sstm;
+			sstm << "device " << d << " cannot start the superslot in " << d2dSchedule::roleName(role);
+			violation(t, sstm.str());
+		}
+		return;
+	}
+
+	uint8_t prev 		= schedule.getRole(d, t-1);
+	uint32_t prevArg 	= schedule.getRoleArg(d, t-1);
+	bool prevStable 	= prev == D2D_ROLE_IDLE || prev == D2D_ROLE_AP || prev == D2D_ROLE_CLIENT;
+	// number of S_SwitchAP / S_JoinAP slots before entering S_AP / S_Client, -1 for other transitions
+	int64_t setupSlots 	= -1;
+	int32_t kappa 		= 0;
+	switch (role) {
+		case D2D_ROLE_IDLE:
+			//C19
+			ok = prev == D2D_ROLE_IDLE;
+			break;
+		case D2D_ROLE_STARTAP:
+			//C21, C22
+			ok = prevStable && t < numT - kappaAP - 1;
+			break;
+		case D2D_ROLE_SWITCHAP:
+			//C25
+			ok = (prev == D2D_ROLE_STARTAP || prev == D2D_ROLE_SWITCHAP) && prevArg == arg;
+			break;
+		case D2D_ROLE_AP:
+			//C27, C24: kappa_startAP slots in S_SwitchAP
+			if (prev == D2D_ROLE_SWITCHAP && prevArg == arg) {
+				setupSlots 	= 0;
+				kappa 		= kappaAP;
+				for (int64_t t_sw = t-1; t_sw >= 0 && schedule.getRole(d, t_sw) == D2D_ROLE_SWITCHAP; t_sw--) {
+					setupSlots++;
+				}
+				ok = setupSlots >= kappa;
+			} else {
+				ok = prev == D2D_ROLE_AP && prevArg == arg;
+			}
+			break;
+		case D2D_ROLE_STARTCLIENT:
+			//C29, C30
+			ok = prevStable && t < numT - kappaClient - 1;
+			break;
+		case D2D_ROLE_JOINAP:
+			//C33
+			ok = (prev == D2D_ROLE_STARTCLIENT || prev == D2D_ROLE_JOINAP) && prevArg == arg;
+			break;
+		case D2D_ROLE_CLIENT:
+			//C35, C32: kappa_startClient slots in S_JoinAP
+			if (prev == D2D_ROLE_JOINAP && prevArg == arg) {
+				setupSlots 	= 0;
+				kappa 		= kappaClient;
+				for (int64_t t_sw = t-1; t_sw >= 0 && schedule.getRole(d, t_sw) == D2D_ROLE_JOINAP; t_sw--) {
+					setupSlots++;
+				}
+				ok = setupSlots >= kappa;
+			} else {
+				ok = prev == D2D_ROLE_CLIENT && prevArg == arg;
+			}
+			break;
+	}
+	if (!ok) {
+		std::stringstream sstm;
+		if (setupSlots >= 0) {
+			sstm << "device " << d << " becomes " << d2dSchedule::roleName(role) << " after " << setupSlots << " of " << kappa << " setup slots";
+		} else {
+			sstm << "device " << d << " cannot change from " << d2dSchedule::roleName(prev) << " " << prevArg
+				 << " to " << d2dSchedule::roleName(role) << " " << arg;
+		}
+		violation(t, sstm.str());
+	}
+}
+
+bool d2dValidator::checkExchange(const d2dExchange &ex) {
+	std::stringstream sstm;
+	sstm << "exchange " << ex.d_prv << " -> " << ex.d_cns << " content " << ex.n << " channel " << ex.c << " ";
+	if (ex.d_prv >= numDev || ex.d_cns >= numDev || ex.n >= numCont || ex.c >= numChan || ex.t < 0 || ex.t >= numT) {
+		sstm << "has invalid indices";
+		violation(ex.t, sstm.str());
+		return false;
+	}
+
+	utility += opt->exchangeUtility(ex.d_prv, ex.d_cns, ex.n, ex.c, ex.t);
+
+	bool ok = true;
+	if (opt->I[ex.d_cns][ex.n] != 1) {
+		//C5
+		sstm << "consumer not interested ";
+		ok = false;
+	}
+	if (opt->P[ex.d_cns][ex.n] == 1) {
+		//C13
+		sstm << "consumer holds the content initially ";
+		ok = false;
+	}
+	if (opt->W[ex.d_prv][ex.c] != 1 || opt->W[ex.d_cns][ex.c] != 1) {
+		//C6
+		sstm << "channel not supported ";
+		ok = false;
+	}
+	int64_t duration = opt->exchangeDuration(ex.d_prv, ex.d_cns, ex.n, ex.c);
+	if (duration < 0) {
+		//C7
+		sstm << "without connectivity ";
+		ok = false;
+	} else if (!opt->exchangeFits(ex.d_prv, ex.d_cns, ex.n, ex.c, ex.t)) {
+		//C8
+		sstm << "does not fit into the superslot or misses the deadline ";
+		ok = false;
+	} else if (!opt->multicast && duration != ex.duration) {
+		sstm << "has duration " << ex.duration << " instead of " << duration << " ";
+		ok = false;
+	} else if (opt->multicast && !multicastRate(ex)) {
+		//MC1, MC3 multicast transmissions may be slower than the link of a consumer
+		sstm << "has duration " << ex.duration << " without a rate of at most the link speed fitting into the superslot ";
+		ok = false;
+	}
+	if (!ok) {
+		violation(ex.t, sstm.str());
+	}
+	return ok;
+}
+
+bool d2dValidator::multicastRate(const d2dExchange &ex) {
+	for (uint32_t k = 0; k<opt->multicastRates.size() && opt->multicastRates[k] <= opt->L[ex.d_prv][ex.d_cns][ex.c]; k++) {
+		if (opt->multicastDuration(ex.n, k) == ex.duration && opt->multicastFits(ex.n, k, ex.t) && 
+			opt->meetsDeadline(ex.d_cns, ex.n, ex.t + ex.duration)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void d2dValidator::checkConnection(const d2dSchedule &schedule, const d2dExchange &ex, int64_t t) {
+	uint8_t rolePrv 	= schedule.getRole(ex.d_prv, t);
+	uint32_t argPrv 	= schedule.getRoleArg(ex.d_prv, t);
+	uint8_t roleCns 	= schedule.getRole(ex.d_cns, t);
+	uint32_t argCns 	= schedule.getRoleArg(ex.d_cns, t);
+
+	//C42
+	if ((rolePrv == D2D_ROLE_AP && argPrv == ex.c && roleCns == D2D_ROLE_CLIENT && argCns == ex.d_prv) ||
+		(roleCns == D2D_ROLE_AP && argCns == ex.c && rolePrv == D2D_ROLE_CLIENT && argPrv == ex.d_cns)) {
+		return;
+	}
+	std::stringstream sstm;
+	sstm << "exchange " << ex.d_prv << " -> " << ex.d_cns << " on channel " << ex.c << " without AP / client connection";
+	violation(t, sstm.str());
+}
+
+void d2dValidator::checkAPs(const std::vector<uint32_t> &aps, int64_t t) {
+	//C36
+	for (uint32_t i = 0; i<aps.size(); i++) {
+		uint32_t d = aps[i];
+		uint32_t c = apChannel[d];
+		if (!opt->channelReuse) {
+			//every further AP on the channel conflicts with the first one
+			if (channelAP[c] < 0) {
+				channelAP[c] = d;
+				continue;
+			}
+			std::stringstream sstm;
+			sstm << "devices " << channelAP[c] << " and " << d << " are AP on channel " << c;
+			violation(t, sstm.str());
+			continue;
+		}
+		//interfering APs, each pair is reported by the lower device unless only the higher device interferes with it
+		const std::vector< std::pair<uint32_t, uint32_t> > &receivers = opt->interferenceList[d * numChan + c];
+		for (uint32_t j = 0; j<receivers.size(); j++) {
+			uint32_t d_int = receivers[j].first;
+			if (receivers[j].second != c || apChannel[d_int] != c || (d_int < d && opt->X[d_int][c][d][c] == 1)) {
+				continue;
+			}
+			std::stringstream sstm;
+			sstm << "devices " << std::min(d, d_int) << " and " << std::max(d, d_int) << " are AP on channel " << c;
+			violation(t, sstm.str());
+		}
+	}
+	if (!opt->channelReuse) {
+		for (uint32_t i = 0; i<aps.size(); i++) {
+			channelAP[apChannel[aps[i]]] = -1;
+		}
+	}
+}
+
+void d2dValidator::checkInterference(const d2dSchedule &schedule, const std::vector<uint32_t> &active, int64_t t) {
+	//C16, a transmitter may only interfere with its own consumer
+	for (uint32_t i = 0; i<active.size(); i++) {
+		receiving[schedule.exchanges[active[i]].d_cns] = active[i];
+	}
+	for (uint32_t i = 0; i<active.size(); i++) {
+		const d2dExchange &tx = schedule.exchanges[active[i]];
+		//the exchanges of a multicast transmission or with airtime sharing share the transmitter
+		if (checkedSlot[tx.d_prv * numChan + tx.c] == t) {
+			continue;
+		}
+		checkedSlot[tx.d_prv * numChan + tx.c] = t;
+		const std::vector< std::pair<uint32_t, uint32_t> > &receivers = opt->interferenceList[tx.d_prv * numChan + tx.c];
+		for (uint32_t j = 0; j<receivers.size(); j++) {
+			int64_t k = receiving[receivers[j].first];
+			if (k < 0 || schedule.exchanges[k].c != receivers[j].second || schedule.exchanges[k].d_prv == tx.d_prv) {
+				continue;
+			}
+			std::stringstream sstm;
+			sstm << "device " << tx.d_prv << " on channel " << tx.c << " interferes with device " << receivers[j].first << " on channel " << receivers[j].second;
+			violation(t, sstm.str());
+		}
+	}
+	for (uint32_t i = 0; i<active.size(); i++) {
+		receiving[schedule.exchanges[active[i]].d_cns] = -1;
+	}
+}
+
+bool d2dValidator::validate(const d2dSchedule &schedule) {
+	numDev 	= opt->deviceVector.size();
+	numChan = opt->channelVector.size();
+	numCont = opt->contentVector.size();
+	numT 	= opt->settings.numTimeSlots;
+	if (opt->multicast && opt->multicastRates.empty()) {
+		//D2D_MODE_MATCHING does not build the model
+		opt->computeMulticastRates();
+	}
+
+	numViolations = 0;
+	messages.clear();
+	utility = 0.0;
+
+	if (schedule.numDevices != numDev || schedule.numTimeSlots != numT ||
+		schedule.role.size() != (uint64_t)numDev * numT || schedule.roleArg.size() != (uint64_t)numDev * numT) {
+		violation(0, "schedule does not match the number of devices and time slots");
+		return false;
+	}
+
+	//roles with invalid arguments are reported, the replay requires valid arguments
+	bool rolesOk = true;
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (int64_t t = 0; t<numT; t++) {
+			rolesOk = validRole(schedule, d, t) && rolesOk;
+		}
+	}
+	if (!rolesOk) {
+		return false;
+	}
+
+	//exchanges by start slot
+	std::vector<uint32_t> firstStart(numT + 1, 0);
+	std::vector<char> exchangeOk(schedule.exchanges.size(), 0);
+	for (uint32_t i = 0; i<schedule.exchanges.size(); i++) {
+		exchangeOk[i] = checkExchange(schedule.exchanges[i]);
+		if (exchangeOk[i]) {
+			firstStart[schedule.exchanges[i].t + 1]++;
+		}
+	}
+	for (int64_t t = 0; t<numT; t++) {
+		firstStart[t + 1] += firstStart[t];
+	}
+	std::vector<uint32_t> byStart(firstStart[numT]);
+	std::vector<uint32_t> fill(firstStart.begin(), firstStart.end() - 1);
+	for (uint32_t i = 0; i<schedule.exchanges.size(); i++) {
+		if (exchangeOk[i]) {
+			byStart[fill[schedule.exchanges[i].t]++] = i;
+		}
+	}
+
+	running.assign(numDev, -1);
+	//with airtime sharing running only holds received exchanges
+	bool sharing = opt->airtimeSharing && !opt->multicast;
+	airtime.assign(numDev, 0.0);
+	sending.assign(numDev, 0);
+	storage.resize(numDev);
+	for (uint32_t d = 0; d<numDev; d++) {
+		storage[d] = opt->freeStorage(d);
+	}
+	availableFrom.assign(numDev * numCont, numT + 1);
+	received.assign(numDev * numCont, 0);
+	for (uint32_t d = 0; d<numDev; d++) {
+		for (uint32_t n = 0; n<numCont; n++) {
+			if (opt->P[d][n] == 1) {
+				availableFrom[d * numCont + n] = 0;
+			}
+		}
+	}
+
+	opt->updateInterferenceList();
+	apChannel.assign(numDev, -1);
+	receiving.assign(numDev, -1);
+	channelAP.assign(numChan, -1);
+	checkedSlot.assign((uint64_t)numDev * numChan, -1);
+	std::vector<uint32_t> aps;
+	std::vector<uint32_t> active;
+	for (int64_t t = 0; t<numT; t++) {
+		//roles
+		for (uint32_t i = 0; i<aps.size(); i++) {
+			apChannel[aps[i]] = -1;
+		}
+		aps.clear();
+		for (uint32_t d = 0; d<numDev; d++) {
+			checkTransition(schedule, d, t);
+
+			uint8_t role = schedule.getRole(d, t);
+			uint32_t arg = schedule.getRoleArg(d, t);
+			if (role == D2D_ROLE_AP) {
+				apChannel[d] = arg;
+				aps.push_back(d);
+			} else if ((role == D2D_ROLE_STARTCLIENT || role == D2D_ROLE_JOINAP || role == D2D_ROLE_CLIENT) &&
+						schedule.getRole(arg, t) != D2D_ROLE_AP) {
+				//C36 - C38
+				std::stringstream sstm;
+				sstm << "device " << d << " is " << d2dSchedule::roleName(role) << " of device " << arg << ", which is not AP";
+				violation(t, sstm.str());
+			}
+		}
+		checkAPs(aps, t);
+
+		//finished exchanges
+		for (uint32_t i = 0; i<active.size(); ) {
+			const d2dExchange &ex = schedule.exchanges[active[i]];
+			if (ex.t + ex.duration > t) {
+				i++;
+				continue;
+			}
+			if (sharing) {
+				airtime[ex.d_prv] -= opt->airtimeShare(ex.d_prv, ex.d_cns, ex.n, ex.c);
+				sending[ex.d_prv]--;
+			} else {
+				running[ex.d_prv] = -1;
+			}
+			running[ex.d_cns] = -1;
+			active[i] = active.back();
+			active.pop_back();
+		}
+
+		//new exchanges
+		for (uint32_t k = firstStart[t]; k<firstStart[t + 1]; k++) {
+			const d2dExchange &ex = schedule.exchanges[byStart[k]];
+			std::stringstream sstm;
+			sstm << "exchange " << ex.d_prv << " -> " << ex.d_cns << " content " << ex.n << " ";
+			bool ok = true;
+			if (availableFrom[ex.d_prv * numCont + ex.n] > t) {
+				//C4
+				sstm << "provider does not hold the content ";
+				ok = false;
+			}
+			if (received[ex.d_cns * numCont + ex.n]) {
+				//C13
+				sstm << "content is received twice ";
+				ok = false;
+			}
+			if ((running[ex.d_prv] >= 0 && !sameTransmission(schedule.exchanges[running[ex.d_prv]], ex)) || 
+				running[ex.d_cns] >= 0 || (sharing && sending[ex.d_cns] > 0) || ex.d_prv == ex.d_cns) {
+				//C12, C14, C15
+				sstm << "device takes part in another exchange ";
+				ok = false;
+			} else if (sharing && airtime[ex.d_prv] + opt->airtimeShare(ex.d_prv, ex.d_cns, ex.n, ex.c) > 1.0 + D2D_AIRTIME_TOLERANCE) {
+				//C14
+				sstm << "exceeds the airtime of the provider ";
+				ok = false;
+			}
+			if (storage[ex.d_cns] >= 0 && storage[ex.d_cns] < opt->S[ex.n]) {
+				sstm << "exceeds the storage capacity of the consumer ";
+				ok = false;
+			}
+			if (!ok) {
+				violation(t, sstm.str());
+				continue;
+			}
+			if (storage[ex.d_cns] >= 0) {
+				storage[ex.d_cns] -= opt->S[ex.n];
+			}
+			received[ex.d_cns * numCont + ex.n] 		= 1;
+			availableFrom[ex.d_cns * numCont + ex.n] 	= std::min(availableFrom[ex.d_cns * numCont + ex.n], ex.t + ex.duration);
+			if (sharing) {
+				airtime[ex.d_prv] += opt->airtimeShare(ex.d_prv, ex.d_cns, ex.n, ex.c);
+				sending[ex.d_prv]++;
+			} else {
+				running[ex.d_prv] = byStart[k];
+			}
+			running[ex.d_cns] = byStart[k];
+			active.push_back(byStart[k]);
+		}
+
+		for (uint32_t i = 0; i<active.size(); i++) {
+			checkConnection(schedule, schedule.exchanges[active[i]], t);
+		}
+		checkInterference(schedule, active, t);
+	}
+
+	return numViolations == 0;
+}
+
+void d2dValidator::print(std::ostream &out) const {
+	if (numViolations == 0) {
+		out << "Schedule valid, utility " << utility << endl;
+		return;
+	}
+	out << "Schedule invalid, " << numViolations << " violations, utility " << utility << endl;
+	for (uint32_t i = 0; i<messages.size(); i++) {
+		out << messages[i] << endl;
+	}
+}
@@ -0,0 +1,85 @@
+#ifndef D2DVALIDATOR_H
+#define D2DVALIDATOR_H
+
+#include "d2dOptimizer.h"
+#include "d2dSchedule.h"
+
+// number of violation messages kept by d2dValidator, all violations are counted
+#define D2D_VALIDATOR_MAX_MESSAGES 100
+
+// Checks a schedule against the instance of opt without the model, e.g. heuristic results or
+// schedules before they are dispatched to the devices. The schedule is replayed slot by slot:
+//  - role transitions and initial states (C17 - C35), setup durations kappa_startAP / kappa_startClient
+//  - one AP per channel or no interfering APs with channelReuse, clients connected to an AP (C36 - C41)
+//  - exchanges: interest, channel support, connectivity, content held by the provider when the
+//    exchange starts, received once, fits into the superslot (C4 - C8, C13)
+//  - each device takes part in one exchange at a time, half-duplex (C12, C14, C15), with multicast
+//    the consumers of a transmission (same provider, content, channel, start and duration) share the provider,
+//    with airtime sharing the airtime shares of the exchanges of a provider fit into the time slot
+//  - the received content fits into the storage capacity of the consumer
+//  - the two devices of an exchange are AP and client of this AP on the channel (C42)
+//  - interference between concurrent exchanges (C16)
+// The run time is linear in the number of devices, time slots and exchange slots, plus the interference
+// edges (interferenceList) of the active transmitters and APs per time slot.
+class d2dValidator {
+
+	public:
+		d2dOptimizer *opt;
+
+		// results of the last validate()
+		uint64_t numViolations;
+		std::vector<std::string> messages;
+		// sum of the utility of all exchanges
+		double utility;
+
+		d2dValidator(d2dOptimizer *opt);
+
+		// returns true if the schedule is feasible
+		bool validate(const d2dSchedule &schedule);
+
+		void print(std::ostream &out) const;
+
+	private:
+		uint32_t numDev;
+		uint32_t numChan;
+		uint32_t numCont;
+		int64_t numT;
+
+		// index into schedule.exchanges of the running exchange per device, -1 if none
+		std::vector<int64_t> running;
+		// with airtime sharing, summed airtime share and number of running exchanges per provider
+		std::vector<double> airtime;
+		std::vector<uint32_t> sending;
+		// storage left per device for received content, -1 = unlimited
+		std::vector<int64_t> storage;
+		// time slot from which content n is held by device d, availableFrom[d * numCont + n], numT + 1 if never
+		std::vector<int64_t> availableFrom;
+		std::vector<char> received;
+		// per device in the current slot the channel it is AP on and the exchange it receives, -1 if none
+		std::vector<int64_t> apChannel;
+		std::vector<int64_t> receiving;
+		// first AP per channel in the current slot without channelReuse, -1 if none
+		std::vector<int64_t> channelAP;
+		// last slot the receivers of transmitter d on channel c were checked, checkedSlot[d * numChan + c]
+		std::vector<int64_t> checkedSlot;
+
+		void violation(int64_t t, const std::string &message);
+		
+		// b is received from the same multicast transmission as a
+		bool sameTransmission(const d2dExchange &a, const d2dExchange &b) {
+			return opt->multicast && a.d_prv == b.d_prv && a.n == b.n && a.c == b.c && a.t == b.t && a.duration == b.duration;
+		}
+
+		// device is Idle, AP or client at the beginning of the superslot
+		bool hasStartState(uint32_t d);
+		bool validRole(const d2dSchedule &schedule, uint32_t d, int64_t t);
+		void checkTransition(const d2dSchedule &schedule, uint32_t d, int64_t t);
+		bool checkExchange(const d2dExchange &ex);
+		// the duration of a multicast exchange belongs to a rate class of at most the link speed that fits
+		bool multicastRate(const d2dExchange &ex);
+		void checkConnection(const d2dSchedule &schedule, const d2dExchange &ex, int64_t t);
+		void checkAPs(const std::vector<uint32_t> &aps, int64_t t);
+		void checkInterference(const d2dSchedule &schedule, const std::vector<uint32_t> &active, int64_t t);
+};
+
+#endif
@@ -1,33 +1,237 @@
 #include "testScenario.h"
+#include "d2dSimulator.h"
+#include "d2dScenarioGenerator.h"
+#include "d2dScheduleEncoder.h"
+#include "d2dSolutionCache.h"
+#include "d2dParameterTuner.h"
 
 int main(int argc, char** argv) {
 	
-	
+	// runOptimizer <test> [-matching] [-start] [-lns <seconds>] [-portfolio <seconds>] [-rounding] [-lagrangian <cluster size>] [-auto <memory MB> <seconds>] [-reuse] [-multicast] [-airtime] [-chunk <size>] [-decay <linear|exponential|step> <rate>] [-cache <fraction>] [-dispatch <file>] [-solcache <entries>] [-template] [-horizon <superslots> <coarsening>] [-simulate <superslots> <interest probability>] [model.mps|model.lp [solution file]]
+	// -matching: schedule with d2dMatchingHeuristic only, without solver
+	// -lns: improve the schedule of d2dMatchingHeuristic by large neighborhood search for the given time
+	// -portfolio: race MIP variants, LNS and LP rounding in parallel threads for the given time, sharing incumbents
+	// -rounding: round the LP relaxation into a schedule and report the gap to the LP bound
+	// -lagrangian: solve clusters of at most the given number of devices (0 = connected components) with prices on the coupling constraints
+	// -auto: predict the model size and select MIP, Lagrangian decomposition, LNS or matching for the memory and time budget
+	// -reuse: allow several APs per channel if they do not interfere with each other
+	// -multicast: an AP may send content to several of its clients with one transmission
+	// -airtime: a provider may serve several consumers at once by sharing the airtime of each slot
+	// -chunk: split the content into chunks of at most the given size, which are scheduled separately
+	// -decay: discount the utility by the end of the exchange, step discounts after half the superslot
+	// -start: use the schedule of d2dMatchingHeuristic as MIP start (written to <model file>.mst with a model file)
+	// runOptimizer -generate <uniform|clustered|venue> <devices> <seed> [positions]
+	// -generate: write the .dat files of a geometric scenario into the working directory, with positions
+	// positions.dat instead of link_speed.dat and interference.dat
+	// -cache: in a simulation the given fraction of the devices prefetches popular content
+	// -dispatch: write the per-device timelines of the schedule in the binary format of d2dScheduleEncoder
+	// -solcache: reuse the schedules of up to the given number of earlier superslots with an equal instance
+	// -template: build the model once and only update objective and bounds while the instance shape does not change
+	// -horizon: in a simulation plan each superslot within a window of the given number of superslots, at the given number of time slots per window slot
+	// -simulate: run the scheduler over consecutive superslots with random interest arrivals per device and content
+	// runOptimizer -tune <corpus file> <seconds> [-candidates <file>] [-reuse] [-multicast] [-airtime] [-decay <linear|exponential|step> <rate>]
+	// -tune: solve the instance directories listed in the corpus file with each candidate parameter set for up to the
+	// given time per run and write the fastest to the target gap to d2dSolver.prm, which later runs load
+	// -candidates: parameter sets to tune, one per line as <name>=<value> ..., instead of the built-in ones
+	// with a model file the model is written instead of solved, an existing solution file of an offline solver run is loaded
+	// test scenarios from TEST_VALIDATOR run their checks instead, the exit code is 0 if all pass
 	int test = TEST_NONE;
-	if (argc > 1) {
-		test = atoi(argv[1]);
+	int32_t mode 		= D2D_MODE_MIP;
+	bool matchingStart 	= false;
+	bool channelReuse 	= false;
+	bool multicast 		= false;
+	bool airtimeSharing = false;
+	long chunkSize 		= 0;
+	int32_t utilityDecay 	= D2D_DECAY_NONE;
+	double decayRate 		= 0.0;
+	double cacheFraction 	= 0.0;
+	std::string dispatchFile;
+	uint32_t solutionCacheSize 	= 0;
+	bool useTemplate 	= false;
+	double timeLimit 	= 0.0;
+	uint32_t numSuperslots 		= 0;
+	double interestProbability 	= 0.0;
+	uint32_t maxClusterSize 	= 0;
+	double memoryBudget 		= 0.0;
+	uint32_t horizon 			= 1;
+	uint32_t coarsening 		= 1;
+	std::string corpusFile;
+	std::string candidatesFile;
+	std::vector<std::string> files;
+	
+	if ((argc == 5 || argc == 6) && std::string(argv[1]) == "-generate") {
+		d2dScenarioGenerator generator;
+		std::string placement = argv[2];
+		generator.placement 	= placement == "clustered" ? D2D_PLACEMENT_CLUSTERED : (placement == "venue" ? D2D_PLACEMENT_VENUE : D2D_PLACEMENT_UNIFORM);
+		generator.numDevices 	= atoi(argv[3]);
+		generator.seed 			= atoi(argv[4]);
+		generator.generate();
+		return generator.writeFiles("", argc == 6 && std::string(argv[5]) == "positions") ? 0 : 1;
+	}
+	
+	for (int i = 1; i<argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-matching") {
+			mode = D2D_MODE_MATCHING;
+		} else if (arg == "-reuse") {
+			channelReuse = true;
+		} else if (arg == "-multicast") {
+			multicast = true;
+		} else if (arg == "-airtime") {
+			airtimeSharing = true;
+		} else if (arg == "-chunk" && i + 1 < argc) {
+			chunkSize = atol(argv[++i]);
+		} else if (arg == "-decay" && i + 2 < argc) {
+			std::string decay = argv[++i];
+			utilityDecay 	= decay == "linear" ? D2D_DECAY_LINEAR : (decay == "exponential" ? D2D_DECAY_EXPONENTIAL : D2D_DECAY_STEP);
+			decayRate 		= atof(argv[++i]);
+		} else if (arg == "-cache" && i + 1 < argc) {
+			cacheFraction = atof(argv[++i]);
+		} else if (arg == "-dispatch" && i + 1 < argc) {
+			dispatchFile = argv[++i];
+		} else if (arg == "-solcache" && i + 1 < argc) {
+			solutionCacheSize = atoi(argv[++i]);
+		} else if (arg == "-template") {
+			useTemplate = true;
+		} else if (arg == "-start") {
+			matchingStart = true;
+		} else if (arg == "-lns" && i + 1 < argc) {
+			mode = D2D_MODE_LNS;
+			timeLimit = atof(argv[++i]);
+		} else if (arg == "-portfolio" && i + 1 < argc) {
+			mode = D2D_MODE_PORTFOLIO;
+			timeLimit = atof(argv[++i]);
+		} else if (arg == "-rounding") {
+			mode = D2D_MODE_LP;
+		} else if (arg == "-horizon" && i + 2 < argc) {
+			horizon 	= atoi(argv[++i]);
+			coarsening 	= atoi(argv[++i]);
+		} else if (arg == "-lagrangian" && i + 1 < argc) {
+			mode = D2D_MODE_LAGRANGIAN;
+			maxClusterSize = atoi(argv[++i]);
+		} else if (arg == "-tune" && i + 2 < argc) {
+			corpusFile 	= argv[++i];
+			timeLimit 	= atof(argv[++i]);
+		} else if (arg == "-candidates" && i + 1 < argc) {
+			candidatesFile = argv[++i];
+		} else if (arg == "-auto" && i + 2 < argc) {
+			mode = D2D_MODE_AUTO;
+			memoryBudget 	= atof(argv[++i]);
+			timeLimit 		= atof(argv[++i]);
+		} else if (arg == "-simulate" && i + 2 < argc) {
+			numSuperslots 		= atoi(argv[++i]);
+			interestProbability = atof(argv[++i]);
+		} else if (i == 1) {
+			test = atoi(argv[1]);
+		} else {
+			files.push_back(arg);
+		}
 	}
 	cout << "Running Test Scenario " << test << endl;
 
-	d2dOptimizer *d2dOpt = new d2dOptimizer();
+	d2dOptimizer *d2dOpt = NULL;
+	if (files.size() > 0) {
+		d2dFileBackend *fileBackend = new d2dFileBackend(files.at(0));
+		if (files.size() > 1) {
+			fileBackend->setParam("SolutionFile", files.at(1));
+		}
+		if (matchingStart) {
+			fileBackend->setParam("StartFile", files.at(0) + ".mst");
+		}
+		d2dOpt = new d2dOptimizer(fileBackend);
+	} else {
+		d2dOpt = new d2dOptimizer();
+	}
+	d2dOpt->mode 				= mode;
+	d2dOpt->useMatchingStart 	= matchingStart;
+	d2dOpt->timeLimit 			= timeLimit;
+	d2dOpt->channelReuse 		= channelReuse;
+	d2dOpt->multicast 			= multicast;
+	d2dOpt->airtimeSharing 		= airtimeSharing;
+	d2dOpt->useTemplate 		= useTemplate;
+	d2dOpt->maxClusterSize 		= maxClusterSize;
+	d2dOpt->memoryBudget 		= memoryBudget;
+	d2dOpt->utilityDecay 		= utilityDecay;
+	d2dOpt->decayRate 			= decayRate;
 	
 	d2dOpt->settings.numTimeSlots 		= 10;
 	d2dOpt->settings.tau 				= 10.0;
 	d2dOpt->settings.kappa_startAP		= 3;
 	d2dOpt->settings.kappa_startClient	= 2;
+	d2dOpt->decaySlot 					= d2dOpt->settings.numTimeSlots / 2;
+	
+	if (!corpusFile.empty()) {
+		d2dParameterTuner tuner(d2dOpt);
+		tuner.timeLimit = timeLimit;
+		if (!tuner.readCorpus(corpusFile) || (!candidatesFile.empty() && !tuner.readCandidates(candidatesFile))) {
+			return 1;
+		}
+		if (tuner.run() != D2D_STATUS_OPTIMAL || !tuner.write(D2D_PARAMETER_FILE)) {
+			return 1;
+		}
+		cout << "Parameters written to " << D2D_PARAMETER_FILE << endl;
+		return 0;
+	}
 	
+	//with chunking the instance is read into a separate optimizer and split into d2dOpt
+	d2dOptimizer *instance = d2dOpt;
+	if (chunkSize > 0) {
+		instance = new d2dOptimizer(new d2dFileBackend(""));
+		instance->settings = d2dOpt->settings;
+	}
 	switch(test) {
 		case TEST_NONE:
-			d2dOpt->readBasicParamters();
-			d2dOpt->allocateParameters();
-			d2dOpt->readParameters();
+			instance->readBasicParamters();
+			instance->allocateParameters();
+			instance->readParameters();
 			break;
 		default:
-			testScenario::setupScenario(test, d2dOpt);
+			testScenario::setupScenario(test, instance);
 			
 	}		
+	if (test >= TEST_VALIDATOR) {
+		return testScenario::runChecks(test, instance) ? 0 : 1;
+	}
+	d2dContentChunker chunker(chunkSize);
+	if (chunkSize > 0) {
+		chunker.split(instance, d2dOpt);
+		delete instance;
+	}
 	d2dOpt->printParameter();
-	d2dOpt->optimize();
+	
+	d2dSolutionCache solutionCache(solutionCacheSize);
+	if (solutionCacheSize > 0) {
+		d2dOpt->solutionCache = &solutionCache;
+	}
+	
+	if (numSuperslots > 0) {
+		d2dOpt->debugResults = false;
+		d2dRandomInterestModel interestModel(interestProbability, 1);
+		d2dSimulator simulator(d2dOpt, &interestModel, NULL);
+		if (chunkSize > 0) {
+			simulator.chunker = &chunker;
+		}
+		d2dPopularityCachePolicy cachePolicy(cacheFraction, 3, 0.1);
+		if (cacheFraction > 0.0) {
+			simulator.cachePolicy = &cachePolicy;
+		}
+		d2dRollingHorizon rollingHorizon(horizon, coarsening);
+		rollingHorizon.mode = mode;
+		if (horizon > 1) {
+			simulator.horizon = &rollingHorizon;
+		}
+		simulator.run(numSuperslots);
+		simulator.print(cout);
+		if (solutionCacheSize > 0) {
+			cout << "solution cache hits " << solutionCache.hits << " misses " << solutionCache.misses << endl;
+		}
+	} else {
+		d2dOpt->optimize();
+		if (!dispatchFile.empty()) {
+			d2dScheduleEncoder encoder(d2dOpt);
+			encoder.write(d2dOpt->schedule, dispatchFile);
+		}
+	}
 	
 	return 1;
 }
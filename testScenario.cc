@@ -1,4 +1,10 @@
 #include "testScenario.h"
+#include "d2dScenarioGenerator.h"
+#include "d2dValidator.h"
+#include "d2dScheduleEncoder.h"
+#include "d2dSolutionCache.h"
+#include "d2dMatchingHeuristic.h"
+#include "d2dRollingHorizon.h"
 
 void testScenario::fillVectors(d2dOptimizer *opt, int numChannels, int numDevices, int numContent) {
 	for (int c=0; c<numChannels; c++) {
@@ -14,6 +20,24 @@ void testScenario::fillVectors(d2dOptimizer *opt, int numChannels, int numDevice
 	}
 }
 
+//clustered devices from d2dScenarioGenerator, 2 channels and 3 content
+static void fillGeometric(d2dOptimizer *opt, uint32_t seed, uint32_t numDevices, uint32_t devicesPerCluster) {
+	d2dScenarioGenerator generator;
+	generator.seed 				= seed;
+	generator.numDevices 		= numDevices;
+	generator.numChannels 		= 2;
+	generator.numContent 		= 3;
+	generator.placement 		= D2D_PLACEMENT_CLUSTERED;
+	generator.devicesPerCluster = devicesPerCluster;
+	generator.generate();
+	generator.fill(opt);
+	
+	opt->settings.numTimeSlots 		= 10;
+	opt->settings.tau 				= 10.0;
+	opt->settings.kappa_startAP		= 1;
+	opt->settings.kappa_startClient	= 1;
+}
+
 void testScenario::setupScenario(int scenario, d2dOptimizer *opt) {
 	
 	int numChannels = 0;
@@ -378,6 +402,113 @@ void testScenario::setupScenario(int scenario, d2dOptimizer *opt) {
 			opt->settings.kappa_startAP		= 1;
 			opt->settings.kappa_startClient	= 1;
 			
+			break;
+		case TEST_GEOMETRIC:
+			cout << "TEST_GEOMETRIC" << endl;
+			fillGeometric(opt, 1, 12, 6);
+			break;
+		case TEST_VALIDATOR:
+			//device 0 serves device 1 on channel 0, device 2 serves device 3 on channel 1
+			//device 0 on channel 0 interferes with device 3 on channel 1
+			cout << "TEST_VALIDATOR" << endl;
+			
+			numChannels = 2;
+			numDevices  = 4;
+			numContent  = 2;
+			
+			fillVectors(opt, numChannels, numDevices, numContent);
+			opt->allocateParameters();
+			
+			opt->S[0] = 1;
+			opt->S[1] = 1;
+			
+			opt->P[0][0] = 1;
+			opt->I[1][0] = 1;
+			opt->P[2][1] = 1;
+			opt->I[3][1] = 1;
+			
+			for (int d=0; d<numDevices; d++) {
+				for (int c=0; c<numChannels; c++) {
+					opt->W[d][c] = 1;
+				}
+			}
+			
+			opt->U[0][1][0] = 1;
+			opt->U[2][3][1] = 1;
+			
+			for (int c=0; c<numChannels; c++) {
+				opt->L[0][1][c] = 1;
+				opt->L[2][3][c] = 1;
+			}
+			
+			opt->X[0][0][3][1] = 1;
+			
+			opt->settings.numTimeSlots 		= 10;
+			opt->settings.tau 				= 10.0;
+			opt->settings.kappa_startAP		= 1;
+			opt->settings.kappa_startClient	= 1;
+			break;
+		case TEST_SCHEDULE_ENCODER:
+			//device 0 multicasts content 0 to devices 1 and 2 on channel 1 and then sends content 1 to device 1
+			cout << "TEST_SCHEDULE_ENCODER" << endl;
+			
+			numChannels = 2;
+			numDevices  = 4;
+			numContent  = 2;
+			
+			fillVectors(opt, numChannels, numDevices, numContent);
+			for (int d=0; d<numDevices; d++) {
+				opt->deviceVector[d]->id = 100 + d;
+			}
+			for (int c=0; c<numChannels; c++) {
+				opt->channelVector[c]->id = 10 + c;
+			}
+			for (int n=0; n<numContent; n++) {
+				opt->contentVector[n]->id = 200 + n;
+			}
+			opt->allocateParameters();
+			
+			opt->S[0] = 2;
+			opt->S[1] = 1;
+			
+			opt->P[0][0] = 1;
+			opt->P[0][1] = 1;
+			opt->I[1][0] = 1;
+			opt->I[1][1] = 1;
+			opt->I[2][0] = 1;
+			
+			for (int d=0; d<numDevices; d++) {
+				for (int c=0; c<numChannels; c++) {
+					opt->W[d][c] = 1;
+				}
+			}
+			
+			opt->U[0][1][0] = 1;
+			opt->U[0][1][1] = 1;
+			opt->U[0][2][0] = 1;
+			
+			for (int c=0; c<numChannels; c++) {
+				opt->L[0][1][c] = 1;
+				opt->L[0][2][c] = 1;
+			}
+			
+			opt->settings.numTimeSlots 		= 10;
+			opt->settings.tau 				= 10.0;
+			opt->settings.kappa_startAP		= 1;
+			opt->settings.kappa_startClient	= 1;
+			break;
+		case TEST_SOLUTION_CACHE:
+			cout << "TEST_SOLUTION_CACHE" << endl;
+			fillGeometric(opt, 1, 12, 6);
+			opt->deviceVector[1]->capacity = 1;
+			break;
+		case TEST_SOLVE_MODES:
+			cout << "TEST_SOLVE_MODES" << endl;
+			fillGeometric(opt, 9, 8, 4);
+			break;
+		case TEST_BIT_MATRIX:
+			//no instance, the matrices are filled by runChecks()
+			cout << "TEST_BIT_MATRIX" << endl;
 			break;
 		default:
 			cerr << "Unknown test scenario " << scenario << endl;
@@ -385,4 +516,485 @@ void testScenario::setupScenario(int scenario, d2dOptimizer *opt) {
 			break;
 	}
 	
-}
\ No newline at end of file
+}
+
+//device ap starts an AP on channel c at slot 0, client joins it from slot 2 and is connected from slot 4
+static void connect(d2dSchedule &schedule, uint32_t ap, uint32_t c, uint32_t client) {
+	for (int64_t t = 0; t<schedule.numTimeSlots; t++) {
+		schedule.setRole(ap, t, t == 0 ? D2D_ROLE_STARTAP : (t == 1 ? D2D_ROLE_SWITCHAP : D2D_ROLE_AP), c);
+		if (t >= 2) {
+			schedule.setRole(client, t, t == 2 ? D2D_ROLE_STARTCLIENT : (t == 3 ? D2D_ROLE_JOINAP : D2D_ROLE_CLIENT), ap);
+		}
+	}
+}
+
+//prints the result of a check
+static bool check(bool ok, const std::string &name) {
+	cout << (ok ? "passed: " : "FAILED: ") << name << endl;
+	return ok;
+}
+
+//the schedule is rejected with a message containing text
+static bool expectViolation(d2dOptimizer *opt, const d2dSchedule &schedule, const std::string &text, const std::string &name) {
+	d2dValidator validator(opt);
+	bool found = false;
+	if (!validator.validate(schedule)) {
+		for (uint32_t i = 0; i<validator.messages.size(); i++) {
+			found = found || validator.messages[i].find(text) != std::string::npos;
+		}
+	}
+	if (!found) {
+		validator.print(cout);
+	}
+	return check(found, name);
+}
+
+//schedule of timelines with the ids of opt, false if a timeline refers to an unknown id
+static bool assemble(d2dOptimizer *opt, const std::vector<d2dDeviceTimeline> &timelines, d2dSchedule &schedule) {
+	std::unordered_map<uint64_t, uint32_t> devices, channels, contents;
+	for (uint32_t d = 0; d<opt->deviceVector.size(); d++) {
+		devices[opt->deviceVector[d]->id] = d;
+	}
+	for (uint32_t c = 0; c<opt->channelVector.size(); c++) {
+		channels[opt->channelVector[c]->id] = c;
+	}
+	for (uint32_t n = 0; n<opt->contentVector.size(); n++) {
+		contents[opt->contentVector[n]->id] = n;
+	}
+	
+	schedule.reset(opt->deviceVector.size(), opt->settings.numTimeSlots);
+	for (uint32_t i = 0; i<timelines.size(); i++) {
+		const d2dDeviceTimeline &timeline = timelines[i];
+		if (!devices.count(timeline.device) || timeline.numTimeSlots != schedule.numTimeSlots) {
+			return false;
+		}
+		uint32_t d = devices[timeline.device];
+		for (uint32_t k = 0; k<timeline.states.size(); k++) {
+			const d2dStateChange &change = timeline.states[k];
+			bool apRole = change.role == D2D_ROLE_STARTAP || change.role == D2D_ROLE_SWITCHAP || change.role == D2D_ROLE_AP;
+			std::unordered_map<uint64_t, uint32_t> &args = apRole ? channels : devices;
+			if (change.role != D2D_ROLE_IDLE && !args.count(change.arg)) {
+				return false;
+			}
+			int64_t end = k + 1 < timeline.states.size() ? timeline.states[k + 1].t : schedule.numTimeSlots;
+			for (int64_t t = change.t; t<end; t++) {
+				schedule.setRole(d, t, change.role, change.role == D2D_ROLE_IDLE ? 0 : args[change.arg]);
+			}
+		}
+		//every exchange is the receive entry of its consumer
+		for (uint32_t k = 0; k<timeline.exchanges.size(); k++) {
+			const d2dTimelineExchange &entry = timeline.exchanges[k];
+			if (!entry.receive) {
+				continue;
+			}
+			if (entry.peers.size() != 1 || !devices.count(entry.peers[0]) || !contents.count(entry.n) || !channels.count(entry.c)) {
+				return false;
+			}
+			schedule.exchanges.push_back(d2dExchange(devices[entry.peers[0]], d, contents[entry.n], channels[entry.c], entry.t, entry.duration));
+		}
+	}
+	return true;
+}
+
+static bool exchangeOrder(const d2dExchange &a, const d2dExchange &b) {
+	if (a.t != b.t) return a.t < b.t;
+	if (a.d_prv != b.d_prv) return a.d_prv < b.d_prv;
+	if (a.d_cns != b.d_cns) return a.d_cns < b.d_cns;
+	if (a.n != b.n) return a.n < b.n;
+	if (a.c != b.c) return a.c < b.c;
+	return a.duration < b.duration;
+}
+
+//equal roles and exchanges, in any order of the exchanges
+static bool sameSchedule(const d2dSchedule &a, const d2dSchedule &b) {
+	if (a.numDevices != b.numDevices || a.numTimeSlots != b.numTimeSlots || a.role != b.role || a.roleArg != b.roleArg ||
+		a.exchanges.size() != b.exchanges.size()) {
+		return false;
+	}
+	std::vector<d2dExchange> exA = a.exchanges;
+	std::vector<d2dExchange> exB = b.exchanges;
+	std::sort(exA.begin(), exA.end(), exchangeOrder);
+	std::sort(exB.begin(), exB.end(), exchangeOrder);
+	for (uint32_t i = 0; i<exA.size(); i++) {
+		if (exchangeOrder(exA[i], exB[i]) || exchangeOrder(exB[i], exA[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//instance of src with device i = src device devices[i], channel c = src channel channels[c] and
+//content n = src content contents[n]
+static void permute(d2dOptimizer *src, d2dOptimizer *dst, const std::vector<uint32_t> &devices,
+					const std::vector<uint32_t> &channels, const std::vector<uint32_t> &contents) {
+	uint32_t numDev 	= devices.size();
+	uint32_t numChan 	= channels.size();
+	uint32_t numCont 	= contents.size();
+	for (uint32_t c = 0; c<numChan; c++) {
+		dst->addChannel(src->channelVector[channels[c]]->id);
+	}
+	for (uint32_t n = 0; n<numCont; n++) {
+		dst->addContent(src->contentVector[contents[n]]->id, src->contentVector[contents[n]]->size);
+	}
+	for (uint32_t i = 0; i<numDev; i++) {
+		dst->addDevice(src->deviceVector[devices[i]]->id)->capacity = src->deviceVector[devices[i]]->capacity;
+	}
+	dst->settings 		= src->settings;
+	dst->mode 			= src->mode;
+	dst->channelReuse 	= src->channelReuse;
+	dst->multicast 		= src->multicast;
+	dst->airtimeSharing = src->airtimeSharing;
+	dst->utilityDecay 	= src->utilityDecay;
+	dst->decayRate 		= src->decayRate;
+	dst->decaySlot 		= src->decaySlot;
+	dst->allocateParameters();
+	
+	for (uint32_t n = 0; n<numCont; n++) {
+		dst->S[n] = src->S[contents[n]];
+	}
+	for (uint32_t i = 0; i<numDev; i++) {
+		uint32_t d = devices[i];
+		dst->START_Idle[i] = src->START_Idle[d];
+		for (uint32_t n = 0; n<numCont; n++) {
+			dst->P[i][n] = src->P[d][contents[n]];
+			dst->I[i][n] = src->I[d][contents[n]];
+			dst->D[i][n] = src->D[d][contents[n]];
+		}
+		for (uint32_t c = 0; c<numChan; c++) {
+			dst->W[i][c] 		= src->W[d][channels[c]];
+			dst->START_AP[i][c] = src->START_AP[d][channels[c]];
+		}
+		for (uint32_t j = 0; j<numDev; j++) {
+			uint32_t e = devices[j];
+			dst->START_Client[i][j] = src->START_Client[d][e];
+			for (uint32_t n = 0; n<numCont; n++) {
+				dst->U[i][j][n] = src->U[d][e][contents[n]];
+			}
+			for (uint32_t c = 0; c<numChan; c++) {
+				dst->L[i][j][c] = src->L[d][e][channels[c]];
+				for (uint32_t c_int = 0; c_int<numChan; c_int++) {
+					dst->X[i][c][j][c_int] = src->X[d][channels[c]][e][channels[c_int]];
+				}
+			}
+		}
+	}
+}
+
+//d2dBitMatrix a and b against the int matrices refA and refB of the same size
+static bool sameBits(const d2dBitMatrix &a, const d2dBitMatrix &b, const std::vector< std::vector<int> > &refA,
+					 const std::vector< std::vector<int> > &refB) {
+	uint32_t cols = a.cols();
+	for (uint32_t r = 0; r<refA.size(); r++) {
+		for (uint32_t s = 0; s<refB.size(); s++) {
+			uint32_t count = 0, countAnd = 0, countAndNot = 0;
+			std::vector<uint32_t> columns, columnsAndNot;
+			for (uint32_t i = 0; i<cols; i++) {
+				if (a[r][i] != refA[r][i] || b[s][i] != refB[s][i]) {
+					return false;
+				}
+				count 		+= refA[r][i];
+				countAnd 	+= refA[r][i] & refB[s][i];
+				countAndNot += refA[r][i] & (1 - refB[s][i]);
+				if (refA[r][i] == 1) {
+					columns.push_back(i);
+				}
+				if (refA[r][i] == 1 && refB[s][i] == 0) {
+					columnsAndNot.push_back(i);
+				}
+			}
+			std::vector<uint32_t> bitColumns, bitColumnsAndNot;
+			a.columns(r, NULL, 0, bitColumns);
+			a.columns(r, &b, s, bitColumnsAndNot);
+			if (a.count(r) != count || a.countAnd(r, b, s) != countAnd || a.countAndNot(r, b, s) != countAndNot ||
+				a.intersects(r, b, s) != (countAnd > 0) || bitColumns != columns || bitColumnsAndNot != columnsAndNot) {
+				return false;
+			}
+			//bits beyond the last column are 0
+			if (cols % 64 != 0 && (a.words(r)[a.wordsPerRow() - 1] >> (cols % 64)) != 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool testScenario::runChecks(int scenario, d2dOptimizer *opt) {
+	bool ok = true;
+	uint32_t numDevices = opt->deviceVector.size();
+	int64_t numT 		= opt->settings.numTimeSlots;
+	
+	switch(scenario) {
+		case TEST_VALIDATOR:
+		{
+			opt->channelReuse 	= false;
+			opt->multicast 		= false;
+			opt->airtimeSharing = false;
+			
+			d2dSchedule valid;
+			valid.reset(numDevices, numT);
+			connect(valid, 0, 0, 1);
+			connect(valid, 2, 1, 3);
+			valid.exchanges.push_back(d2dExchange(0, 1, 0, 0, 4, opt->exchangeDuration(0, 1, 0, 0)));
+			valid.exchanges.push_back(d2dExchange(2, 3, 1, 1, 6, opt->exchangeDuration(2, 3, 1, 1)));
+			d2dValidator validator(opt);
+			ok = check(validator.validate(valid), "valid schedule") && ok;
+			validator.print(cout);
+			
+			//C36
+			d2dSchedule sameChannel = valid;
+			connect(sameChannel, 2, 0, 3);
+			sameChannel.exchanges[1].c = 0;
+			ok = expectViolation(opt, sameChannel, "devices 0 and 2 are AP on channel 0", "two APs on one channel") && ok;
+			
+			//with channel reuse only interfering APs exclude each other
+			opt->channelReuse = true;
+			d2dValidator reuse(opt);
+			ok = check(reuse.validate(sameChannel), "two APs on one channel with channel reuse") && ok;
+			opt->X[2][0][0][0] = 1;
+			opt->interferenceList.clear();
+			ok = expectViolation(opt, sameChannel, "devices 0 and 2 are AP on channel 0", "two interfering APs with channel reuse") && ok;
+			opt->X[2][0][0][0] = 0;
+			opt->interferenceList.clear();
+			opt->channelReuse = false;
+			
+			//C16
+			d2dSchedule interference = valid;
+			interference.exchanges[1].t = 4;
+			ok = expectViolation(opt, interference, "device 0 on channel 0 interferes with device 3 on channel 1", "interference") && ok;
+			
+			//C24, C27
+			d2dSchedule noSetup = valid;
+			noSetup.setRole(0, 0, D2D_ROLE_IDLE, 0);
+			noSetup.setRole(0, 1, D2D_ROLE_IDLE, 0);
+			ok = expectViolation(opt, noSetup, "device 0 cannot change from IDLE 0 to AP 0", "AP without setup state") && ok;
+			
+			//C4
+			d2dSchedule noContent = valid;
+			noContent.exchanges[1].n = 0;
+			opt->I[3][0] = 1;
+			ok = expectViolation(opt, noContent, "exchange 2 -> 3 content 0 provider does not hold the content", "provider without content") && ok;
+			opt->I[3][0] = 0;
+			
+			opt->deviceVector[3]->capacity = 0;
+			ok = expectViolation(opt, valid, "exchange 2 -> 3 content 1 exceeds the storage capacity", "consumer without storage") && ok;
+			opt->deviceVector[3]->capacity = -1;
+		}
+			break;
+		case TEST_SCHEDULE_ENCODER:
+		{
+			opt->channelReuse 	= false;
+			opt->multicast 		= true;
+			opt->airtimeSharing = false;
+			
+			d2dSchedule schedule;
+			schedule.reset(numDevices, numT);
+			connect(schedule, 0, 1, 1);
+			for (int64_t t = 3; t<numT; t++) {
+				schedule.setRole(2, t, t == 3 ? D2D_ROLE_STARTCLIENT : (t == 4 ? D2D_ROLE_JOINAP : D2D_ROLE_CLIENT), 0);
+			}
+			//one transmission to both clients, then a unicast exchange
+			schedule.exchanges.push_back(d2dExchange(0, 1, 0, 1, 5, opt->exchangeDuration(0, 1, 0, 1)));
+			schedule.exchanges.push_back(d2dExchange(0, 2, 0, 1, 5, opt->exchangeDuration(0, 2, 0, 1)));
+			schedule.exchanges.push_back(d2dExchange(0, 1, 1, 1, 8, opt->exchangeDuration(0, 1, 1, 1)));
+			d2dValidator validator(opt);
+			ok = check(validator.validate(schedule), "valid multicast schedule") && ok;
+			validator.print(cout);
+			
+			d2dScheduleEncoder encoder(opt);
+			std::vector<d2dDeviceTimeline> timelines;
+			encoder.slice(schedule, timelines);
+			ok = check(timelines[0].exchanges.size() == 2 && timelines[0].exchanges[0].peers.size() == 2, 
+						"multicast transmission is one sending entry") && ok;
+			
+			std::vector<d2dDeviceTimeline> decoded(timelines.size());
+			bool decodedAll = true;
+			bool truncated 	= false;
+			for (uint32_t d = 0; d<timelines.size(); d++) {
+				std::vector<uint8_t> message;
+				d2dScheduleEncoder::encode(timelines[d], message);
+				decodedAll = d2dScheduleEncoder::decode(message.data(), message.size(), decoded[d]) && decodedAll;
+				d2dDeviceTimeline rest;
+				truncated = d2dScheduleEncoder::decode(message.data(), message.size() - 1, rest) || truncated;
+			}
+			ok = check(decodedAll, "decode messages") && ok;
+			ok = check(!truncated, "reject truncated messages") && ok;
+			
+			d2dSchedule roundTrip;
+			ok = check(assemble(opt, decoded, roundTrip) && sameSchedule(schedule, roundTrip), "decoded schedule equals the schedule") && ok;
+		}
+			break;
+		case TEST_SOLUTION_CACHE:
+		{
+			d2dSchedule schedule;
+			d2dMatchingHeuristic heuristic(opt);
+			heuristic.run(schedule);
+			d2dValidator validator(opt);
+			ok = check(validator.validate(schedule) && !schedule.exchanges.empty(), "valid schedule with exchanges") && ok;
+			validator.print(cout);
+			if (schedule.exchanges.empty()) {
+				return false;
+			}
+			
+			d2dSolutionCache cache(4);
+			d2dSchedule cached;
+			int32_t status = D2D_STATUS_ERROR;
+			ok = check(!cache.lookup(opt, cached, status), "empty cache misses") && ok;
+			cache.insert(schedule, D2D_STATUS_FEASIBLE);
+			
+			//devices in reverse order, channels and content rotated
+			uint32_t numChan = opt->channelVector.size();
+			uint32_t numCont = opt->contentVector.size();
+			std::vector<uint32_t> devices(numDevices), channels(numChan), contents(numCont);
+			for (uint32_t d = 0; d<numDevices; d++) {
+				devices[d] = numDevices - 1 - d;
+			}
+			for (uint32_t c = 0; c<numChan; c++) {
+				channels[c] = (c + 1) % numChan;
+			}
+			for (uint32_t n = 0; n<numCont; n++) {
+				contents[n] = (n + 1) % numCont;
+			}
+			d2dOptimizer permuted(new d2dFileBackend(""));
+			permute(opt, &permuted, devices, channels, contents);
+			ok = check(cache.lookup(&permuted, cached, status) && status == D2D_STATUS_FEASIBLE, "permuted instance hits") && ok;
+			d2dValidator permutedValidator(&permuted);
+			ok = check(permutedValidator.validate(cached) && fabs(permutedValidator.utility - validator.utility) < 1e-9, 
+						"relabeled schedule is valid for the permuted instance") && ok;
+			permutedValidator.print(cout);
+			
+			//one utility changed
+			for (uint32_t d = 0; d<numDevices; d++) {
+				devices[d] = d;
+			}
+			d2dOptimizer changed(new d2dFileBackend(""));
+			permute(opt, &changed, devices, channels, contents);
+			const d2dExchange &ex = schedule.exchanges[0];
+			changed.U[ex.d_prv][ex.d_cns][(ex.n + numCont - 1) % numCont] += 1.0;
+			ok = check(!cache.lookup(&changed, cached, status), "instance with another utility misses") && ok;
+			ok = check(cache.hits == 1 && cache.misses == 2, "hits and misses counted") && ok;
+		}
+			break;
+		case TEST_BIT_MATRIX:
+		{
+			srand(1);
+			const uint32_t sizes[] = {63, 64, 65, 130};
+			for (uint32_t k = 0; k<4; k++) {
+				uint32_t cols = sizes[k];
+				uint32_t rows = 4;
+				d2dBitMatrix a, b;
+				a.resize(rows, cols);
+				b.resize(rows, cols);
+				std::vector< std::vector<int> > refA(rows, std::vector<int>(cols, 0));
+				std::vector< std::vector<int> > refB(rows, std::vector<int>(cols, 0));
+				//row 0 empty, row 1 full, rows 2 and 3 random with the last column set in row 2
+				for (uint32_t i = 0; i<cols; i++) {
+					refA[1][i] = refB[1][i] = 1;
+					for (uint32_t r = 2; r<rows; r++) {
+						refA[r][i] = rand() % 2;
+						refB[r][i] = rand() % 2;
+					}
+				}
+				refA[2][cols - 1] = refB[2][cols - 1] = 1;
+				for (uint32_t r = 0; r<rows; r++) {
+					for (uint32_t i = 0; i<cols; i++) {
+						//nonzero values are stored as 1
+						a[r][i] = refA[r][i] * 3;
+						b[r][i] = refB[r][i];
+					}
+				}
+				std::stringstream name;
+				name << "bit matrix with " << cols << " columns";
+				ok = check(sameBits(a, b, refA, refB), name.str()) && ok;
+				
+				//clear the last column and every second column of the full row
+				for (uint32_t i = 0; i<cols; i += 2) {
+					a[1][i] = refA[1][i] = 0;
+				}
+				a[2][cols - 1] = refA[2][cols - 1] = 0;
+				b[3][0] = b[2][0];
+				refB[3][0] = refB[2][0];
+				name << " after writes";
+				ok = check(sameBits(a, b, refA, refB), name.str()) && ok;
+			}
+		}
+			break;
+		case TEST_SOLVE_MODES:
+		{
+			uint32_t numChan = opt->channelVector.size();
+			uint32_t numCont = opt->contentVector.size();
+			std::vector<uint32_t> devices(numDevices), channels(numChan), contents(numCont);
+			for (uint32_t d = 0; d<numDevices; d++) {
+				devices[d] = d;
+			}
+			for (uint32_t c = 0; c<numChan; c++) {
+				channels[c] = c;
+			}
+			for (uint32_t n = 0; n<numCont; n++) {
+				contents[n] = n;
+			}
+			
+			//upper bound of the utility without solver, each interest served by its best provider
+			double interestBound = 0.0;
+			for (uint32_t d = 0; d<numDevices; d++) {
+				for (uint32_t n = 0; n<numCont; n++) {
+					double best = 0.0;
+					for (uint32_t d_prv = 0; d_prv<numDevices && opt->I[d][n] == 1 && opt->P[d][n] == 0; d_prv++) {
+						best = std::max(best, opt->U[d_prv][d][n]);
+					}
+					interestBound += best;
+				}
+			}
+			double bound = interestBound;
+			d2dOptimizer mip(createDefaultBackend());
+			permute(opt, &mip, devices, channels, contents);
+			mip.debugResults = false;
+			int32_t status = mip.optimize();
+			if (status == D2D_STATUS_OPTIMAL) {
+				bound = mip.schedule.utility;
+				cout << "MIP optimum " << bound << endl;
+			} else {
+				cout << "No MIP optimum (status " << status << "), utility bound " << bound << endl;
+			}
+			
+			//the MIP with channel reuse may exceed the optimum without it, but no AP may serve another AP (C42)
+			const char *names[] 	= {"matching", "LNS", "portfolio", "LP rounding", "rolling horizon", "Lagrangian", "auto", 
+									   "MIP with channel reuse"};
+			const int32_t modes[] 	= {D2D_MODE_MATCHING, D2D_MODE_LNS, D2D_MODE_PORTFOLIO, D2D_MODE_LP, D2D_MODE_MIP, 
+									   D2D_MODE_LAGRANGIAN, D2D_MODE_AUTO, D2D_MODE_MIP};
+			for (uint32_t k = 0; k<8; k++) {
+				bool reuse = std::string(names[k]) == "MIP with channel reuse";
+				d2dOptimizer run(createDefaultBackend());
+				permute(opt, &run, devices, channels, contents);
+				run.mode 			= modes[k];
+				run.timeLimit 		= 10.0;
+				run.maxClusterSize 	= 4;
+				run.debugResults 	= false;
+				run.channelReuse 	= run.channelReuse || reuse;
+				if (std::string(names[k]) == "rolling horizon") {
+					d2dRollingHorizon horizon(2, 2);
+					horizon.plan(&run);
+				}
+				status = run.optimize();
+				if (status == D2D_STATUS_EXPORTED) {
+					cout << "skipped: " << names[k] << " without solver" << endl;
+					continue;
+				}
+				d2dValidator validator(&run);
+				bool valid = (status == D2D_STATUS_OPTIMAL || status == D2D_STATUS_FEASIBLE) && validator.validate(run.schedule);
+				double limit = reuse && !opt->channelReuse ? interestBound : bound;
+				std::stringstream name;
+				name << names[k] << " schedule valid with utility " << validator.utility << " <= " << limit;
+				ok = check(valid && validator.utility <= limit + 1e-6, name.str()) && ok;
+				if (!valid) {
+					cout << "status " << status << endl;
+					validator.print(cout);
+				}
+			}
+		}
+			break;
+		default:
+			cerr << "No checks for test scenario " << scenario << endl;
+			return false;
+	}
+	return ok;
+}
@@ -44,12 +44,40 @@
 //no exchange should occur if a device has already the content initially
 #define TEST_NO_EXCHANGE_IF_ALREADY_AVAIL 10
 
+//clustered devices from d2dScenarioGenerator with a fixed seed, links and interference follow from the distances
+#define TEST_GEOMETRIC 11
+
+//the scenarios from here on are checks run by runChecks() instead of an optimization
+
+//d2dValidator on hand-built invalid schedules: two APs on one channel, interference, a missing setup
+//state, a provider without the content and a consumer without storage
+#define TEST_VALIDATOR 12
+
+//d2dScheduleEncoder: the timelines of a schedule with a multicast transmission are encoded, decoded
+//and turned back into the schedule, devices, channels and content have ids other than their index
+#define TEST_SCHEDULE_ENCODER 13
+
+//d2dSolutionCache: a copy of a geometric instance with permuted devices, channels and content hits the
+//schedule of the instance, which has to be valid for the copy; a copy with one other utility misses
+#define TEST_SOLUTION_CACHE 14
+
+//d2dBitMatrix against int matrices with 63, 64, 65 and 130 columns, single entries and the row operations
+#define TEST_BIT_MATRIX 15
+
+//the modes matching, LNS, portfolio, LP rounding, rolling horizon, Lagrangian and auto on two clusters of
+//4 devices: valid schedules with at most the utility of the MIP optimum, without solver at most the best
+//utility per interest; modes that only export the model are skipped. The MIP with channel reuse has to
+//give a valid schedule as well
+#define TEST_SOLVE_MODES 16
+
 class d2dOptimizer;
 class testScenario {
 	
 	public:
 		static void setupScenario(int scenario, d2dOptimizer *opt);
 		static void fillVectors(d2dOptimizer *opt, int numChannels, int numDevices, int numContent);
+		// checks of the scenarios from TEST_VALIDATOR on the instance of setupScenario(), false if one fails
+		static bool runChecks(int scenario, d2dOptimizer *opt);
 };
 
 #endif
\ No newline at end of file